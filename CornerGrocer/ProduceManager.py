@@ -1,5 +1,16 @@
 import os # imported to use the getcwd() function, which allows the writeFrequencyFile
           # function to print the directory the file was created in.
+from array import array # imported to hand all counts to C++ as one contiguous buffer
+import gzip # imported to read sales logs that were archived with gzip
+import re # imported to recognize timestamps at the start of a sales line
+
+#a leading timestamp, seconds since 1970 or an ISO time, then the rest of the line. Compiled once
+#here rather than looked up for every line.
+TIMED_LINE = re.compile(r"([0-9]{10,}|([0-9]{4})-([0-9][0-9])-([0-9][0-9])T([0-9][0-9]):([0-9][0-9]):([0-9][0-9])Z?)[ \t\r\v\f]+(.*)",
+                        re.DOTALL)
+#a name followed by a quantity and unit price, and a name followed by a quantity alone
+PRICED_LINE = re.compile(r"(.*\S)[ \t]+(-?[0-9]+)[ \t]+([0-9]+\.?[0-9]*|\.[0-9]+)", re.DOTALL)
+COUNTED_LINE = re.compile(r"(.*\S)[ \t]+(-?[0-9]+)", re.DOTALL)
 
 
 #produce manager created as a class in order to cut down on work having to be redone,
@@ -13,22 +24,134 @@ class ProduceManager:
         self.dataFileName = inputFileName #set instance's dataFileName to input file name given by C++
         self.outputFileName = outputFileName #set instance's outputFileName to output file name given by C++
         self.produceDict = {} #dictionary to be used to hold produce data from data file
+        self.consumedOffset = 0 #bytes of the data file already counted, see updateProduceFrequencies
+        self.fileIdentity = None #(device, inode) of the data file when it was last read
+        self.provisionalItem = None #(name, quantity, added) of an unfinished last line, counted until
+                                    #more of the file arrives; added is True if it wasn't an item before
+        self.countCancelled = False #set by C++, from another thread, to stop a count at its next line
 
     #this method returns no data, and populates the instances produce dictionary with items sold today
-    #along with the quantity of each item sold. 
+    #along with the quantity of each item sold. The dictionary is emptied first, so calling this again
+    #recounts the file instead of adding the same sales to the dictionary twice.
     def totalProduceFrequencies(self):
-        #open a file whose name matches that given upon instantiation, in read mode.
-        produceRecord = open(self.dataFileName, 'r') 
-        #iterate over open file stream, line by line. For loop automatically stops when EOF is reached
-        for itemLine in produceRecord:
-           produceItem = itemLine.strip() #strip whitespace from both ends of string on each line
-           #search this instance's produceDict for a key matching the word retrieved from the file'
-           #if it is not there...
-           if (produceItem not in self.produceDict): 
-               self.produceDict[produceItem] = 1 #include it in the dictionary by giving it a value of one
-           else: #if it's already in there...
-               self.produceDict[produceItem] += 1 #...increment its value by one.
-        produceRecord.close() #always clean up after yourself! file closed!
+        self.produceDict = {} #start from an empty dictionary
+        self.consumedOffset = 0 #and from the top of the file
+        self.fileIdentity = None
+        self.provisionalItem = None
+        self.updateProduceFrequencies() #with nothing read yet, this reads the whole file
+
+    #this method returns no data, and adds only the lines appended to the data file since it was last
+    #read to the dictionary, so a log the registers keep writing to never has to be recounted.
+    #If the file was replaced (rotated) or got shorter (truncated), it is read again from the top,
+    #keeping the counts from before (lines added to a rotated file after it was last read are
+    #missed, since the old file isn't kept open between calls). A last line with no newline yet is
+    #counted provisionally, and taken back next time, in case the rest of it was still being written.
+    #Once countCancelled is set it stops before the next line, keeping what it counted so far and
+    #its place after it, except in a compressed log, whose part counts are dropped like damaged ones.
+    def updateProduceFrequencies(self):
+        if (self.provisionalItem is not None): #take back last time's provisional count
+            produceItem, quantity, added = self.provisionalItem
+            self.addProduce(produceItem, -quantity)
+            if (added and self.produceDict[produceItem] == 0): #only guessed at, not sold
+                del self.produceDict[produceItem]
+            self.provisionalItem = None
+        try:
+            fileStat = os.stat(self.dataFileName) #size and identity of the file right now
+        except OSError: #no file at the moment (mid rotation), try again next time
+            return
+        fileIdentity = (fileStat.st_dev, fileStat.st_ino)
+        if (fileIdentity != self.fileIdentity or fileStat.st_size < self.consumedOffset):
+            self.consumedOffset = 0 #a different or shorter file, read it from the top
+            self.fileIdentity = fileIdentity
+        #open the file in binary mode, so the offset is a byte count, and read only what's new,
+        #a line at a time so a multi-GB log is never held in memory whole
+        produceRecord = open(self.dataFileName, 'rb')
+        produceRecord.seek(self.consumedOffset)
+        magic = produceRecord.peek(4)[:4] #first bytes of what's new, without reading past them
+        compressed = (magic[:2] == b"\x1f\x8b" or magic == b"\x28\xb5\x2f\xfd") #gzip or zstd
+        #a damaged compressed log is only found partway through, so keep the counts from before it
+        countedBefore = dict(self.produceDict) if compressed else None
+        try:
+            produceLines = self.openCompressed(produceRecord, magic) if compressed else produceRecord
+            for itemLine in produceLines:
+                if (self.countCancelled): #asked to stop, leave the rest for next time
+                    break
+                #a compressed log holds whole members, so its last line counts as complete too
+                complete = compressed or itemLine.endswith(b"\n")
+                if (complete and not compressed):
+                    self.consumedOffset += len(itemLine)
+                #decode like C++ reads bytes, never failing on a bad one, then strip whitespace,
+                #then any timestamp, then any quantity and price
+                produceItem, quantity = self.parseSalesLine(
+                    self.removeTimestamp(itemLine.decode(errors="replace").strip()))
+                if (produceItem != ""): #blank lines aren't items, skip them
+                    if (not complete): #a last line with no newline yet, and whether it's a new item
+                        self.provisionalItem = (produceItem, quantity, produceItem not in self.produceDict)
+                    self.addProduce(produceItem, quantity)
+            if (compressed and self.countCancelled): #stopped partway, its place can't be kept
+                self.produceDict = countedBefore
+            elif (compressed):
+                self.consumedOffset = produceRecord.tell() #read to the end, nothing left to finish
+        except Exception:
+            if (compressed):
+                self.produceDict = countedBefore #as if the damaged log was never read
+            raise
+        finally:
+            produceRecord.close() #always clean up after yourself! file closed!
+
+    #this method returns a reader of the decompressed lines of produceRecord, one or more gzip or
+    #zstd members back to back starting with magic, the same way the C++ side reads a compressed
+    #log. zstd needs Python 3.14's compression.zstd; without it, or for damaged or cut short data,
+    #an exception is raised rather than miscounting.
+    def openCompressed(self, produceRecord, magic):
+        if (magic[:2] == b"\x1f\x8b"):
+            return gzip.GzipFile(fileobj=produceRecord, mode='rb')
+        try:
+            from compression import zstd #only imported when a zstd log turns up
+        except ImportError:
+            raise RuntimeError("This Python has no zstd support, can't read File: " + self.dataFileName)
+        return zstd.ZstdFile(produceRecord, mode='rb')
+
+    #this method returns produceLine without a leading timestamp ("1619172900 Apples" or
+    #"2021-04-23T10:15:00 Apples"), or produceLine unchanged if it has none, the same way the
+    #C++ side tells timestamped lines apart: seconds need at least 10 digits, so a name like
+    #"7 Up" stays whole. Only the item name is counted here; time windows are kept by the
+    #C++ side alone. Most lines don't start with a digit, so they're returned before any regex runs.
+    def removeTimestamp(self, produceLine):
+        if (not ("0" <= produceLine[:1] <= "9")): #no timestamp starts any other way
+            return produceLine
+        timedLine = TIMED_LINE.fullmatch(produceLine)
+        if (timedLine is None or timedLine.group(8).strip() == ""): #no timestamp, or nothing after it
+            return produceLine
+        if (timedLine.group(2) is not None): #an ISO time, check each field's range like C++ does
+            month, day, hour, minute, second = (int(timedLine.group(field)) for field in range(3, 8))
+            if (not (1 <= month <= 12 and 1 <= day <= 31 and hour <= 23 and minute <= 59 and second <= 60)):
+                return produceLine
+        return timedLine.group(8).strip()
+
+    #this method returns a tuple of the item name and quantity sold on produceLine, which has had
+    #its timestamp removed: ("Apples", 12) for "Apples 12" or "Apples 12 0.45", and (produceLine, 1)
+    #for a line without a quantity, following the rules in sales_record.h on the C++ side. Prices
+    #only count towards revenue, which is kept by the C++ side alone, so they're checked but dropped.
+    #Most lines are a bare name, so a line not ending in a digit, or with no space or tab before
+    #it (like "Garlic-504"), is returned before any regex runs.
+    def parseSalesLine(self, produceLine):
+        if (not ("0" <= produceLine[-1:] <= "9") or #neither a quantity nor a price ends any other way
+                (" " not in produceLine and "\t" not in produceLine)): #and both follow a space or tab
+            return (produceLine, 1)
+        pricedLine = PRICED_LINE.fullmatch(produceLine)
+        if (pricedLine is not None and abs(int(pricedLine.group(2))) <= 1000000000 and
+                float(pricedLine.group(3)) <= 1000000):
+            return (pricedLine.group(1), int(pricedLine.group(2)))
+        countedLine = COUNTED_LINE.fullmatch(produceLine)
+        if (countedLine is not None and abs(int(countedLine.group(2))) <= 1000000000):
+            return (countedLine.group(1), int(countedLine.group(2)))
+        return (produceLine, 1)
+
+    #this method adds amount to the quantity of produceItem, adding it to the dictionary with a
+    #quantity of zero first if it isn't there yet
+    def addProduce(self, produceItem, amount):
+        self.produceDict[produceItem] = self.produceDict.get(produceItem, 0) + amount
     
     #this method returns no data, and prints a prettified list of all items sold today, followed
     #by the quantity of the items sold today
@@ -47,14 +170,19 @@ class ProduceManager:
     #this method is used to return a single item's quantity sold today, as found in the
     #instance's produce dictionary. Takes one string, itemName, as a search key
     def returnProduceFrequency(self, itemName):
-        match = False #set booolean match to false as a defualt state
-        for item in self.produceDict.items(): #iterate over the instance's produce dictionary
-            if item[0] == itemName: #if the key (item[0]) matches the key itemName...
-                return item[1] #...return the value, its quantity (item[1])
-                match = True #turn match to true
-        if (match == False or itemName == 'quit'): #if 'quit' is given or no match found...
-           return -1 #...return -1.
+        #look the key up directly in the dictionary (a hash lookup, instead of checking every item)
+        #and return its quantity, or -1 if no match is found
+        return self.produceDict.get(itemName, -1)
     
+    #this method returns the whole produce dictionary in one call, as a tuple of two buffers
+    #C++ can read in place: every item name joined by newlines into one bytes object, and an
+    #array of 64 bit counts in the same order. Both are built by C loops inside Python
+    #(join and array), so no per item work is done in Python code.
+    def exportFrequencyTable(self):
+        names = "\n".join(self.produceDict.keys()).encode() #one bytes object holding every name
+        counts = array('q', self.produceDict.values()) #one contiguous int64 array of quantities
+        return (names, counts)
+
     #This method is used to put the data that was parsed from the given input file
     # in a cleaner format in the given output file name, namely, following the format:
     # <itemName> <itemQty>\n  (notice the *single* space between itemName and itemQty.
@@ -67,5 +195,6 @@ class ProduceManager:
             fileLine = produceItem[0] + " " + str(produceItem[1]) + "\n" 
             #write line to file
             outputFile.write(fileLine)    
+        outputFile.close() #close the file so everything is flushed before C++ reads it
         #print a message to user showing the location of the file as created.
         print("Wrote to Location: " + os.getcwd() + "\\" + self.outputFileName)
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Background Task definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "background_task.h"
+#include <cstdio>
+#include <stdexcept>
+
+void TaskProgress::Reset() {
+	total_.store(0);
+	done_.store(0);
+	cancelled_.store(false);
+}
+
+BackgroundTask::~BackgroundTask() {
+	Cancel();
+	Wait();
+}
+
+/*running_ is set here rather than on the worker, so running() is already
+* true when Start returns*/
+void BackgroundTask::Start(const std::string& description,
+	                       std::function<void(TaskProgress&)> job) {
+	Wait();
+	description_ = description;
+	progress_.Reset();
+	error_.clear();
+	running_.store(true);
+	thread_ = std::thread([this, job]() {
+		try {
+			job(progress_);
+		}
+		catch (std::exception& error) { //handed to Wait, even std::bad_alloc
+			error_ = error.what();
+		}
+		running_.store(false);
+	});
+}
+
+std::string BackgroundTask::Wait() {
+	if (thread_.joinable()) { thread_.join(); }
+	std::string error; //only reported once
+	error.swap(error_);
+	return error;
+}
+
+//megabytes to one decimal place read more easily than bytes
+std::string BackgroundTask::Describe() const {
+	uint64_t total = progress_.total();
+	uint64_t done = progress_.done();
+	char text[64];
+	if (total != 0) {
+		std::snprintf(text, sizeof(text), ": %d%% of %.1f MB",
+			          static_cast<int>(done * 100 / total), total / 1e6);
+	}
+	else if (done != 0) {
+		std::snprintf(text, sizeof(text), ": %.1f MB so far", done / 1e6);
+	}
+	else {
+		text[0] = '\0'; //nothing to say yet
+	}
+	return description_ + text;
+}
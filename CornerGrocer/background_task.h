@@ -0,0 +1,111 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Background Task header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef BACKGROUND_TASK_H
+#define BACKGROUND_TASK_H
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+/* This file runs one long job, counting the input file or writing the
+* output file, on a worker thread, so the menu can be shown and used while
+* it runs.
+*
+* The job is handed a TaskProgress. It says how many bytes it has done out
+* of how many as it goes, which the menu reads to show how far it has got,
+* and checks cancelled() between pieces of work, stopping early (with
+* everything it did so far left consistent) once it is set. Both sides only
+* touch atomics, so neither ever waits on the other.
+*
+* A job reports failure by throwing std::runtime_error, like the code it
+* runs, though anything derived from std::exception (running out of memory,
+* say) is caught the same way. The message is kept and handed to whoever calls Wait, on the menu's
+* thread, so nothing is printed over the menu from the worker. */
+
+//how far a job has got, and whether it has been asked to stop
+class TaskProgress {
+public:
+	//bytes the whole job will do, 0 if that isn't known
+	void set_total(uint64_t bytes) {
+		total_.store(bytes, std::memory_order_relaxed);
+	}
+	uint64_t total() const { return total_.load(std::memory_order_relaxed); }
+
+	//bytes done so far
+	void set_done(uint64_t bytes) {
+		done_.store(bytes, std::memory_order_relaxed);
+	}
+	uint64_t done() const { return done_.load(std::memory_order_relaxed); }
+
+	//asks the job to stop at its next check
+	void Cancel() { cancelled_.store(true); }
+	bool cancelled() const { return cancelled_.load(); }
+
+	//back to nothing done, for the next job
+	void Reset();
+
+private:
+	std::atomic<uint64_t> total_{0}; //see set_total
+	std::atomic<uint64_t> done_{0}; //see set_done
+	std::atomic<bool> cancelled_{false}; //set by Cancel
+};
+
+//one job at a time on its own thread, see above
+class BackgroundTask {
+public:
+	BackgroundTask() = default;
+
+	//cancels and waits for any job still running
+	~BackgroundTask();
+
+	//a task owns its thread, so it can't be copied
+	BackgroundTask(const BackgroundTask&) = delete;
+	BackgroundTask& operator=(const BackgroundTask&) = delete;
+
+	/*waits for the last job, if there was one, then starts job on a new
+	* thread. description says what it is doing for the menu, such as
+	* "Counting sales.txt".*/
+	void Start(const std::string& description,
+		       std::function<void(TaskProgress&)> job);
+
+	//true from Start until the job returns or throws
+	bool running() const { return running_.load(); }
+
+	/*true if a job was started and hasn't been waited for yet, whether or
+	* not it is still running*/
+	bool started() const { return thread_.joinable(); }
+
+	/*waits for the job to return, if one was started, and returns the
+	* message it threw, or an empty string if it didn't throw*/
+	std::string Wait();
+
+	/*asks the job to stop at its next check, without waiting for it to;
+	* Wait does that*/
+	void Cancel() { progress_.Cancel(); }
+
+	//what the job is doing and how far it has got, for the menu
+	std::string Describe() const;
+
+	const std::string& description() const { return description_; }
+
+private:
+	std::thread thread_; //runs the job, joinable until waited for
+	std::string description_; //given to Start
+	TaskProgress progress_; //shared with the job
+	std::atomic<bool> running_{false}; //see running
+	std::string error_; //what the job threw, set before running_ clears
+};
+#endif
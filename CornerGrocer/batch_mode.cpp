@@ -0,0 +1,1268 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Batch Mode definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "batch_mode.h"
+#include "checkpoint.h"
+#include "history_store.h"
+#include "line_scanner.h"
+#include "mapped_file.h"
+#include "query_server.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+//most ingest threads --threads accepts, far more than any machine has cores
+const int64_t kMaxThreads = 1024;
+
+//name of each output format, as used on the command line and in records
+const char* FormatName(FrequencyFileFormat format) {
+	return format == FrequencyFileFormat::kBinary ? "binary" : "text";
+}
+
+/*returns the value following argument index, moving index onto it. Sets
+* error and returns nullptr if the argument was the last one.*/
+const char* TakeValue(int argc, char* argv[], int& index,
+	                  std::string& error) {
+	if (index + 1 >= argc) {
+		error = std::string("Missing value for ") + argv[index];
+		return nullptr;
+	}
+	return argv[++index];
+}
+
+//name of each follow event, as written in records
+const char* EventName(FollowEvent event) {
+	switch (event) {
+	case FollowEvent::kAppended: return "appended";
+	case FollowEvent::kTruncated: return "truncated";
+	case FollowEvent::kRotated: return "rotated";
+	default: return "none";
+	}
+}
+
+//name of each kind of ranking, as used on the command line and in records
+const char* RankKindName(RankKind kind) {
+	switch (kind) {
+	case RankKind::kTop: return "top";
+	case RankKind::kBottom: return "bottom";
+	case RankKind::kAbove: return "above";
+	default: return "all";
+	}
+}
+
+/*fills query from a ranking argument (--top, --bottom or --above, with or
+* without "output-" after the dashes) and its value. Sets error and returns
+* false if the value isn't a number that makes sense for the ranking.*/
+bool ParseRankQuery(std::string_view argument, const char* value,
+	                RankQuery& query, std::string& error) {
+	std::string_view kind = argument.substr(argument.rfind('-') + 1);
+	query.kind = kind == "top" ? RankKind::kTop :
+		kind == "bottom" ? RankKind::kBottom : RankKind::kAbove;
+	if (!ParseInteger(value, query.value)) {
+		error = std::string(argument) + " needs a whole number: " + value;
+		return false;
+	}
+	if (query.kind != RankKind::kAbove &&
+		(query.value < 1 || query.value > UINT32_MAX)) {
+		error = std::string(argument) + " needs a count of 1 or more: " +
+			value;
+		return false;
+	}
+	return true;
+}
+
+//adds every non-blank, trimmed line of file_name to names
+void ReadQueryFile(const std::string& file_name,
+	               std::vector<std::string>& names) {
+	MappedFile file(file_name);
+	LineScanner lines(file.data(), file.size());
+	for (std::string_view line; lines.Next(line);) {
+		std::string_view name = TrimWhitespace(line);
+		if (!name.empty()) { names.emplace_back(name); }
+	}
+}
+
+/*the per file side of WriteResults: each input file's own frequency file
+* and query answers. Frequency files are named after the input file, so two
+* inputs with the same name (from different directories) would overwrite
+* each other; that is checked before anything is written.*/
+void WritePartitionResults(const BatchOptions& options,
+	                       const MultiFileIngest& ingest,
+	                       const std::vector<std::string_view>& names,
+	                       RecordWriter& records) {
+	if (!options.per_file_directory.empty()) {
+		const char* extension =
+			options.output_format == FrequencyFileFormat::kBinary ?
+			".bin" : ".dat";
+		std::vector<std::string> output_files; //one per partition
+		for (std::size_t i = 0; i < ingest.size(); ++i) {
+			std::filesystem::path input(ingest.partition(i).file_name);
+			output_files.push_back((std::filesystem::path(
+				options.per_file_directory) /
+				(input.stem().string() + extension)).string());
+		}
+		std::vector<std::string> sorted_files(output_files);
+		std::sort(sorted_files.begin(), sorted_files.end());
+		auto duplicate = std::adjacent_find(sorted_files.begin(),
+			                                sorted_files.end());
+		if (duplicate != sorted_files.end()) {
+			throw std::runtime_error("Two input files would both write " +
+				                     *duplicate);
+		}
+		for (std::size_t i = 0; i < ingest.size(); ++i) {
+			const FrequencyEngine& counts = ingest.partition(i).counts;
+			counts.WriteFrequencyFile(output_files[i], options.output_format);
+			records.WriteExport(output_files[i], options.output_format,
+				                counts.Items().size());
+		}
+	}
+
+	if (!options.per_file) { return; }
+	std::vector<int64_t> counts; //reused for every file's batch lookup
+	for (std::size_t i = 0; i < ingest.size(); ++i) {
+		const IngestPartition& partition = ingest.partition(i);
+		partition.counts.ItemFrequencies(names, counts);
+		for (std::size_t name = 0; name < names.size(); ++name) {
+			records.WriteFileItem(partition.file_name, names[name],
+				                  counts[name]);
+		}
+	}
+}
+
+/*counts every input file, directories expanded, one after another into
+* sketch. An ingest record's items are the estimated distinct items first
+* seen in that file, since a sketch can't say which items a file had.*/
+void CountSketch(const BatchOptions& options, SketchEngine& sketch,
+	             RecordWriter& records) {
+	MultiFileIngest inputs; //only used to list directories
+	for (const std::string& input_file : options.input_files) {
+		inputs.AddInput(input_file);
+	}
+	for (std::size_t i = 0; i < inputs.size(); ++i) {
+		const std::string& file_name = inputs.partition(i).file_name;
+		int64_t units_before = sketch.TotalUnits();
+		int64_t items_before = sketch.DistinctItems();
+		auto start = std::chrono::steady_clock::now();
+		sketch.CountFile(file_name);
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		records.WriteIngest(file_name, static_cast<uint64_t>(std::max<int64_t>(
+			                sketch.DistinctItems() - items_before, 0)),
+			                sketch.TotalUnits() - units_before,
+			                elapsed.count());
+	}
+	records.WriteSketch(sketch);
+}
+
+/*counts every input file, directories expanded, through one aggregator
+* within the memory budget, then adds up its runs into the export while
+* looking the queries up. Items are only told apart once the runs are
+* added up, so instead of an ingest record per file there is one external
+* record for them all.*/
+void CountExternal(const BatchOptions& options,
+	               const std::vector<std::string_view>& names,
+	               RecordWriter& records) {
+	ExternalAggregator aggregator(options.external);
+	MultiFileIngest inputs; //only used to list directories
+	for (const std::string& input_file : options.input_files) {
+		inputs.AddInput(input_file);
+	}
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < inputs.size(); ++i) {
+		aggregator.CountFile(inputs.partition(i).file_name);
+	}
+	std::vector<int64_t> counts; //the queries' units
+	std::vector<int64_t> cents; //and revenue
+	aggregator.Finish(options.output_file, names, counts, cents);
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+	records.WriteExternal(aggregator, inputs.size(), elapsed.count());
+
+	if (!options.output_file.empty()) {
+		records.WriteExport(options.output_file, FrequencyFileFormat::kText,
+			                aggregator.items());
+	}
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		records.WriteItem(names[i], counts[i]);
+	}
+	if (options.revenue) {
+		for (std::size_t i = 0; i < names.size(); ++i) {
+			records.WriteRevenue(names[i], counts[i], cents[i]);
+		}
+		records.WriteRevenueTotal(aggregator.items(), aggregator.units(),
+			                      aggregator.revenue());
+	}
+}
+
+/*everything done with the counts once they're in: export, chart, queries,
+* searches and rankings, each only if it was asked for. With a sketch,
+* engine is its report and queries are answered with the sketch's estimates
+* instead.*/
+void WriteResults(const BatchOptions& options, const FrequencyEngine& engine,
+	              const MultiFileIngest* ingest, const SketchEngine* sketch,
+	              const std::vector<std::string_view>& names,
+	              RecordWriter& records) {
+	std::vector<uint32_t> ids; //picked by each ranking in turn
+	if (!options.output_file.empty() &&
+		options.output_rank.kind != RankKind::kNone) {
+		RunRankQuery(engine.Items(), options.output_rank, ids);
+		engine.WriteFrequencyFile(options.output_file, ids);
+		records.WriteExport(options.output_file, options.output_format,
+			                ids.size());
+	}
+	else if (!options.output_file.empty()) {
+		engine.WriteFrequencyFile(options.output_file, options.output_format);
+		records.WriteExport(options.output_file, options.output_format,
+			                engine.Items().size());
+	}
+
+	if (!options.chart_file.empty()) {
+		HistogramRenderer renderer(options.chart);
+		const std::string& chart = renderer.Render(engine.Items());
+		std::ofstream output(options.chart_file,
+			                 std::ios::out | std::ios::binary);
+		if (!output.is_open()) {
+			throw std::runtime_error("Error creating File: " +
+				                     options.chart_file);
+		}
+		output.write(chart.data(), chart.size());
+		records.WriteChart(options.chart_file, renderer.row_count());
+	}
+
+	std::vector<int64_t> counts; //filled in by one batch lookup
+	{
+		CORNER_GROCER_TIME_STAGE(kLookup); //the whole batch, as one call
+		if (sketch != nullptr) { sketch->ItemFrequencies(names, counts); }
+		else { engine.ItemFrequencies(names, counts); }
+		CORNER_GROCER_COUNT(kItemsLookedUp, names.size());
+	}
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		records.WriteItem(names[i], counts[i]);
+	}
+	if (options.revenue) {
+		for (std::size_t i = 0; i < names.size(); ++i) {
+			records.WriteRevenue(names[i], counts[i],
+				                 engine.ItemRevenue(names[i]));
+		}
+		records.WriteRevenueTotal(engine.Items().size(),
+			                      engine.Items().TotalUnits(),
+			                      engine.Items().TotalRevenue());
+	}
+	if (!options.searches.empty()) {
+		ItemSearchIndex index; //built again every time, as counts change
+		index.Build(engine.Items());
+		for (const std::string& search : options.searches) {
+			index.Search(search, options.search_limit, ids);
+			for (uint32_t id : ids) {
+				records.WriteMatch(search, engine.Items().Name(id),
+					               engine.Items().Count(id));
+			}
+		}
+	}
+	const TimeWindowCounter* windows = engine.time_windows();
+	if (windows != nullptr && windows->has_times()) {
+		for (int64_t window : options.windows) {
+			for (std::string_view name : names) {
+				uint32_t id = engine.Items().Find(name);
+				int64_t count = id != ItemDictionary::kNotFound ?
+					windows->WindowCount(id, window) : -1;
+				records.WriteWindowItem(name, window, count,
+					                    windows->newest_time());
+			}
+		}
+	}
+	if (ingest != nullptr) {
+		WritePartitionResults(options, *ingest, names, records);
+	}
+
+	const FrequencyTable& items = engine.Items();
+	for (const RankQuery& query : options.rankings) {
+		RunRankQuery(items, query, ids);
+		for (std::size_t rank = 0; rank < ids.size(); ++rank) {
+			records.WriteRank(query, rank + 1, items.Name(ids[rank]),
+				              items.Count(ids[rank]));
+		}
+	}
+}
+/*records engine's counts as the day's column of the history, then reads
+* it back, mapped, for the queries' days, the day totals and the movers*/
+void RecordHistory(const BatchOptions& options, const FrequencyEngine& engine,
+	               const std::vector<std::string_view>& names,
+	               RecordWriter& records) {
+	int64_t day = options.history_day != INT64_MIN ? options.history_day :
+		CurrentDay();
+	AppendHistoryDay(options.history_file, day, engine.Items());
+	HistoryStore history(options.history_file);
+	records.WriteHistory(options.history_file, FormatIsoDate(day),
+		                 history.size(), history.day_count());
+
+	int64_t first_day = day - options.history_days + 1;
+	std::vector<HistoryPoint> points;
+	for (std::string_view name : names) {
+		uint32_t id = history.Find(name);
+		if (id == ItemDictionary::kNotFound) { continue; } //never sold
+		history.ItemHistory(id, first_day, day, points);
+		for (const HistoryPoint& point : points) {
+			records.WriteHistoryDay(name, FormatIsoDate(point.day),
+				                    point.count);
+		}
+	}
+	history.DayTotals(first_day, day, points);
+	for (const HistoryPoint& point : points) {
+		records.WriteHistoryDay("", FormatIsoDate(point.day), point.count);
+	}
+	std::vector<HistoryMover> movers;
+	history.TopMovers(day, options.mover_count, movers);
+	for (std::size_t rank = 0; rank < movers.size(); ++rank) {
+		records.WriteMover(rank + 1, history.Name(movers[rank].id),
+			               FormatIsoDate(day), movers[rank].this_week,
+			               movers[rank].last_week);
+	}
+}
+}  // namespace
+
+/*walks argv once. Every argument but --help takes exactly one value, so
+* each is a simple match followed by TakeValue.*/
+bool ParseBatchOptions(int argc, char* argv[], BatchOptions& options,
+	                   std::string& error) {
+	for (int index = 1; index < argc; ++index) {
+		std::string_view argument = argv[index];
+		if (argument == "--help" || argument == "-h") {
+			error.clear(); //not an error, but nothing to run either
+			return false;
+		}
+		if (argument == "--follow") { //the only other flags without a value
+			options.follow = true;
+			continue;
+		}
+		if (argument == "--per-file") {
+			options.per_file = true;
+			continue;
+		}
+		if (argument == "--approximate") {
+			options.approximate = true;
+			continue;
+		}
+		if (argument == "--revenue") {
+			options.revenue = true;
+			continue;
+		}
+		const char* value = TakeValue(argc, argv, index, error);
+		if (value == nullptr) { return false; }
+
+		if (argument == "--input") {
+			options.input_files.emplace_back(value);
+		}
+		else if (argument == "--output") {
+			options.output_file = value;
+		}
+		else if (argument == "--format") {
+			std::string_view format = value;
+			if (format == "text") {
+				options.output_format = FrequencyFileFormat::kText;
+			}
+			else if (format == "binary") {
+				options.output_format = FrequencyFileFormat::kBinary;
+			}
+			else {
+				error = "Unknown --format (use text or binary): " +
+					std::string(format);
+				return false;
+			}
+		}
+		else if (argument == "--query") {
+			options.queries.emplace_back(value);
+		}
+		else if (argument == "--query-file") {
+			options.query_file = value;
+		}
+		else if (argument == "--search") {
+			options.searches.emplace_back(value);
+		}
+		else if (argument == "--search-limit") {
+			int64_t limit = 0;
+			if (!ParseInteger(value, limit) || limit < 1 ||
+				limit > UINT32_MAX) {
+				error = std::string("--search-limit needs a count of 1 or "
+					                "more: ") + value;
+				return false;
+			}
+			options.search_limit = static_cast<uint32_t>(limit);
+		}
+		else if (argument == "--emit") {
+			std::string_view style = value;
+			if (style == "jsonl") {
+				options.output_style = OutputStyle::kJsonLines;
+			}
+			else if (style == "csv") {
+				options.output_style = OutputStyle::kCsv;
+			}
+			else {
+				error = "Unknown --emit (use jsonl or csv): " +
+					std::string(style);
+				return false;
+			}
+		}
+		else if (argument == "--chart") {
+			options.chart_file = value;
+		}
+		else if (argument == "--chart-width" || argument == "--chart-top") {
+			int64_t number = 0;
+			if (!ParseInteger(value, number) || number < 0 ||
+				number > UINT32_MAX) {
+				error = std::string(argument) + " needs a whole number: " +
+					value;
+				return false;
+			}
+			if (argument == "--chart-width") { options.chart.width = number; }
+			else { options.chart.top = static_cast<uint32_t>(number); }
+		}
+		else if (argument == "--chart-sort") {
+			std::string_view order = value;
+			if (order == "input") {
+				options.chart.order = HistogramOrder::kInput;
+			}
+			else if (order == "count") {
+				options.chart.order = HistogramOrder::kCountDescending;
+			}
+			else if (order == "count-asc") {
+				options.chart.order = HistogramOrder::kCountAscending;
+			}
+			else if (order == "name") {
+				options.chart.order = HistogramOrder::kName;
+			}
+			else {
+				error = "Unknown --chart-sort (use input, count, count-asc or "
+					"name): " + std::string(order);
+				return false;
+			}
+		}
+		else if (argument == "--checkpoint") {
+			options.checkpoint_file = value;
+		}
+		else if (argument == "--serve") {
+			options.serve_address = value;
+		}
+		else if (argument == "--metrics") {
+			options.metrics_file = value;
+		}
+		else if (argument == "--history") {
+			options.history_file = value;
+		}
+		else if (argument == "--history-date") {
+			if (!ParseIsoDate(value, options.history_day)) {
+				error = std::string("--history-date needs a YYYY-MM-DD "
+					                "date: ") + value;
+				return false;
+			}
+		}
+		else if (argument == "--history-days" || argument == "--movers") {
+			int64_t number = 0;
+			if (!ParseInteger(value, number) || number < 0 ||
+				number > UINT32_MAX) {
+				error = std::string(argument) + " needs a whole number: " +
+					value;
+				return false;
+			}
+			if (argument == "--history-days") {
+				options.history_days = static_cast<uint32_t>(number);
+			}
+			else { options.mover_count = static_cast<uint32_t>(number); }
+		}
+		else if (argument == "--metrics-format") {
+			std::string_view format = value;
+			if (format == "prometheus") {
+				options.metrics_format = MetricsFormat::kPrometheus;
+			}
+			else if (format == "json") {
+				options.metrics_format = MetricsFormat::kJson;
+			}
+			else {
+				error = "Unknown --metrics-format (use prometheus or json): " +
+					std::string(format);
+				return false;
+			}
+		}
+		else if (argument == "--poll-ms" || argument == "--follow-seconds" ||
+			     argument == "--checkpoint-seconds") {
+			int64_t number = 0;
+			if (!ParseInteger(value, number) || number < 0 ||
+				number > UINT32_MAX) {
+				error = std::string(argument) + " needs a whole number: " +
+					value;
+				return false;
+			}
+			if (argument == "--poll-ms") {
+				options.poll_milliseconds = static_cast<unsigned>(number);
+			}
+			else if (argument == "--follow-seconds") {
+				options.follow_seconds = static_cast<unsigned>(number);
+			}
+			else {
+				options.checkpoint_seconds = static_cast<unsigned>(number);
+			}
+		}
+		else if (argument == "--top" || argument == "--bottom" ||
+			     argument == "--above" || argument == "--output-top" ||
+			     argument == "--output-bottom" ||
+			     argument == "--output-above") {
+			RankQuery query;
+			if (!ParseRankQuery(argument, value, query, error)) {
+				return false;
+			}
+			if (argument.substr(0, 9) == "--output-") {
+				options.output_rank = query;
+			}
+			else { options.rankings.push_back(query); }
+		}
+		else if (argument == "--window" || argument == "--bucket-seconds" ||
+			     argument == "--buckets") {
+			int64_t number = 0;
+			if (!ParseInteger(value, number) || number < 1 ||
+				number > UINT32_MAX) {
+				error = std::string(argument) +
+					" needs a count of 1 or more: " + value;
+				return false;
+			}
+			if (argument == "--window") { options.windows.push_back(number); }
+			else if (argument == "--bucket-seconds") {
+				options.window_buckets.bucket_seconds = number;
+			}
+			else {
+				options.window_buckets.bucket_count =
+					static_cast<uint32_t>(number);
+			}
+		}
+		else if (argument == "--sketch-width" ||
+			     argument == "--sketch-depth" || argument == "--sketch-top" ||
+			     argument == "--sketch-precision") {
+			int64_t number = 0;
+			if (!ParseInteger(value, number) || number < 1 ||
+				number > UINT32_MAX) {
+				error = std::string(argument) +
+					" needs a count of 1 or more: " + value;
+				return false;
+			}
+			uint32_t size = static_cast<uint32_t>(number);
+			if (argument == "--sketch-width") { options.sketch.width = size; }
+			else if (argument == "--sketch-depth") {
+				options.sketch.depth = size;
+			}
+			else if (argument == "--sketch-top") { options.sketch.top = size; }
+			else if (size < 4 || size > 18) {
+				error = "--sketch-precision needs a number from 4 to 18: " +
+					std::string(value);
+				return false;
+			}
+			else { options.sketch.precision = size; }
+		}
+		else if (argument == "--per-file-output") {
+			options.per_file_directory = value;
+		}
+		else if (argument == "--memory-budget") {
+			int64_t megabytes = 0;
+			if (!ParseInteger(value, megabytes) || megabytes < 1 ||
+				megabytes > (int64_t(1) << 40)) {
+				error = std::string("--memory-budget needs a number of "
+					                "MiB, 1 or more: ") + value;
+				return false;
+			}
+			options.bounded = true;
+			options.external.memory_budget = uint64_t(megabytes) << 20;
+		}
+		else if (argument == "--spill-dir") {
+			options.external.spill_directory = value;
+		}
+		else if (argument == "--threads") {
+			int64_t threads = 0;
+			if (!ParseInteger(value, threads) || threads < 0 ||
+				threads > kMaxThreads) {
+				error = std::string("--threads needs a number from 0 to ") +
+					std::to_string(kMaxThreads) + ": " + value;
+				return false;
+			}
+			options.thread_count = static_cast<unsigned>(threads);
+		}
+		else {
+			error = "Unknown argument: " + std::string(argument);
+			return false;
+		}
+	}
+	if (options.input_files.empty()) {
+		error = "At least one --input file is needed";
+		return false;
+	}
+	if (options.output_rank.kind != RankKind::kNone &&
+		(options.output_file.empty() ||
+		 options.output_format == FrequencyFileFormat::kBinary)) {
+		//binary files are always in name order, so only text can be ranked
+		error = "--output-top, --output-bottom and --output-above need "
+			"--output with --format text";
+		return false;
+	}
+	if (options.follow && options.input_files.size() != 1) {
+		error = "--follow needs exactly one --input file";
+		return false;
+	}
+	if (!options.checkpoint_file.empty() &&
+		(options.input_files.size() != 1 || options.approximate ||
+		 options.per_file || !options.per_file_directory.empty())) {
+		//a snapshot is of one log's exact counts
+		error = "--checkpoint needs exactly one --input file, and can't be "
+			"used with --approximate, --per-file or --per-file-output";
+		return false;
+	}
+	if (options.approximate && (options.follow || !options.windows.empty() ||
+		                        options.per_file ||
+		                        !options.per_file_directory.empty() ||
+		                        !options.serve_address.empty() ||
+		                        options.revenue ||
+		                        !options.history_file.empty())) {
+		/*a sketch can't be told apart by file or by time, or served
+		* exactly, and keeps no prices, nor exact counts to keep a history
+		* of*/
+		error = "--approximate can't be used with --follow, --window, "
+			"--per-file, --per-file-output, --serve, --revenue or --history";
+		return false;
+	}
+	if (options.bounded &&
+		(options.approximate || options.follow ||
+		 !options.checkpoint_file.empty() || !options.windows.empty() ||
+		 options.per_file || !options.per_file_directory.empty() ||
+		 !options.serve_address.empty() || !options.history_file.empty() ||
+		 !options.chart_file.empty() || !options.searches.empty() ||
+		 !options.rankings.empty() ||
+		 options.output_rank.kind != RankKind::kNone ||
+		 options.output_format == FrequencyFileFormat::kBinary)) {
+		/*the whole table is never in memory at once, so only what can be
+		* answered a run at a time can be asked for*/
+		error = "--memory-budget can only be used with --output (in text), "
+			"--query, --query-file and --revenue";
+		return false;
+	}
+	if (!options.external.spill_directory.empty() && !options.bounded) {
+		error = "--spill-dir needs --memory-budget";
+		return false;
+	}
+	return true;
+}
+
+void PrintBatchUsage(std::ostream& output) {
+	output << "Usage: CornerGrocer [arguments]\n"
+		<< "With no arguments, the interactive menu is shown. With "
+		<< "arguments, runs\nwithout prompts and writes results to stdout.\n"
+		<< "  --input PATH       sales log, or directory of them, to count "
+		<< "(repeatable)\n"
+		<< "                     gzip or zstd logs are decompressed as they "
+		<< "are read\n"
+		<< "  --output FILE      write a frequency file\n"
+		<< "  --format FORMAT    frequency file format: text (default) or "
+		<< "binary\n"
+		<< "  --output-top N     export only the N best sellers, best first\n"
+		<< "  --output-bottom N  export only the N worst sellers, worst "
+		<< "first\n"
+		<< "  --output-above N   export only items that sold more than N, "
+		<< "best first\n"
+		<< "  --query NAME       look up an item (repeatable)\n"
+		<< "  --query-file FILE  look up every item listed, one per line\n"
+		<< "  --revenue          also list queried items' revenue, and the "
+		<< "total, in cents,\n                     from lines logged with a "
+		<< "price (\"Apples 12 0.45\")\n"
+		<< "  --search TEXT      list items with words starting with each "
+		<< "word of TEXT,\n                     ignoring case (repeatable)\n"
+		<< "  --search-limit N   most items listed per search (default 10)\n"
+		<< "  --top N            list the N best sellers (repeatable)\n"
+		<< "  --bottom N         list the N worst sellers (repeatable)\n"
+		<< "  --above N          list items that sold more than N "
+		<< "(repeatable)\n"
+		<< "  --window SECONDS   also look queries up over the last SECONDS "
+		<< "of\n                     timestamped sales (repeatable)\n"
+		<< "  --bucket-seconds N time bucket length for --window (default "
+		<< "60)\n"
+		<< "  --buckets N        time buckets kept per item, 8 bytes each "
+		<< "(default 60)\n"
+		<< "  --per-file         also look queries up in each input file's "
+		<< "own counts\n"
+		<< "  --per-file-output DIR\n"
+		<< "                     also write each input file's frequency file "
+		<< "into DIR\n"
+		<< "  --emit STYLE       result format: jsonl (default) or csv\n"
+		<< "  --chart FILE       draw the histogram into FILE\n"
+		<< "  --chart-width N    histogram width, 0 (default) for the "
+		<< "terminal's\n"
+		<< "  --chart-sort ORDER histogram order: input (default), count, "
+		<< "count-asc\n                     or name\n"
+		<< "  --chart-top N      only chart the N best sellers\n"
+		<< "  --follow           keep reading the input as it grows, redoing "
+		<< "the\n                     export, chart and queries after each "
+		<< "read\n"
+		<< "  --poll-ms N        longest wait between follow reads (default "
+		<< "1000)\n"
+		<< "  --follow-seconds N stop following (and serving) after N "
+		<< "seconds, 0 (default)\n                     never\n"
+		<< "  --checkpoint FILE  start from FILE's snapshot of the input if "
+		<< "it has one,\n                     reading only what was added "
+		<< "since, then save a new one\n"
+		<< "  --checkpoint-seconds N\n"
+		<< "                     when following, save at most every N "
+		<< "seconds (default 60)\n"
+		<< "  --serve ADDRESS    also answer queries on a Unix socket path, "
+		<< "or on\n                     localhost:PORT, until "
+		<< "--follow-seconds pass (Linux only)\n"
+		<< "  --history FILE     record the counts as today's in FILE, then "
+		<< "list queries'\n                     units, and all units, on "
+		<< "each day recorded, and the\n                     biggest "
+		<< "movers week over week\n"
+		<< "  --history-date DATE\n"
+		<< "                     record as YYYY-MM-DD instead of today "
+		<< "(UTC)\n"
+		<< "  --history-days N   days back to list from the history "
+		<< "(default 90)\n"
+		<< "  --movers N         movers to list from the history (default "
+		<< "10)\n"
+		<< "  --metrics FILE     write how long each stage took into FILE "
+		<< "at the end\n                     (builds with "
+		<< "CORNER_GROCER_ENABLE_METRICS only)\n"
+		<< "  --metrics-format FORMAT\n"
+		<< "                     timings format: prometheus (default) or "
+		<< "json\n"
+		<< "  --approximate      estimate counts in fixed memory, for logs "
+		<< "with too\n                     many distinct items to count "
+		<< "exactly\n"
+		<< "  --sketch-width N   counters per row, rounded up to a power of "
+		<< "two; more\n                     is closer (default 65536)\n"
+		<< "  --sketch-depth N   rows of counters; more is surer (default 4)\n"
+		<< "  --sketch-top N     best sellers kept by name (default 100)\n"
+		<< "  --sketch-precision N\n"
+		<< "                     distinct item registers are 2^N, 4 to 18 "
+		<< "(default 14)\n"
+		<< "  --memory-budget MB count exactly in about MB MiB, spilling to "
+		<< "disk when\n                     the items don't fit; only "
+		<< "--output (text), --query,\n                     --query-file "
+		<< "and --revenue are answered\n"
+		<< "  --spill-dir DIR    where --memory-budget spills to (default "
+		<< "the system's\n                     temporary folder)\n"
+		<< "  --threads N        ingest threads, shared out between input "
+		<< "files, 0\n                     (default) for one per core, at "
+		<< "most 1024\n"
+		<< "  --help             show this message\n";
+}
+
+/*counts every input file into one engine, then exports, charts and answers
+* queries and rankings from it. Each step's results are added to one
+* RecordWriter, which writes them to stdout in one go at the end, or, when
+* following, at the end of every read.*/
+int RunBatch(const BatchOptions& options) {
+	RecordWriter records(options.output_style);
+	FrequencyEngine engine;
+	SnapshotPublisher snapshots; //what the query server answers from
+	QueryServer server(snapshots); //stopped before snapshots goes
+	std::unique_ptr<SketchEngine> sketch; //only made when estimating
+	if (options.approximate) {
+		sketch.reset(new SketchEngine(options.sketch));
+		sketch->set_thread_count(options.thread_count);
+	}
+	engine.set_thread_count(options.thread_count);
+	if (!options.windows.empty()) {
+		engine.EnableTimeWindows(options.window_buckets);
+	}
+
+	try {
+		/*followed or snapshotted input is read through the follower, so it
+		* knows where it stopped. Anything else is counted as one partition
+		* per file.*/
+		std::unique_ptr<LogFollower> follower;
+		MultiFileIngest ingest;
+		bool checkpoint = !options.checkpoint_file.empty();
+		std::vector<std::string> queries = options.queries;
+		if (!options.query_file.empty()) {
+			ReadQueryFile(options.query_file, queries);
+		}
+		std::vector<std::string_view> names(queries.begin(), queries.end());
+		if (sketch != nullptr) {
+			CountSketch(options, *sketch, records);
+		}
+		else if (options.bounded) {
+			CountExternal(options, names, records);
+		}
+		else if (options.follow || checkpoint) {
+			auto start = std::chrono::steady_clock::now();
+			follower.reset(new LogFollower(options.input_files[0], engine));
+			uint64_t offset = 0; //where the snapshot left off
+			if (checkpoint && LoadCheckpoint(options.checkpoint_file,
+				                             options.input_files[0], engine,
+				                             offset)) {
+				follower->ResumeAt(offset);
+				records.WriteSnapshot(options.checkpoint_file, "loaded",
+					                  offset, engine.Items().size());
+			}
+			follower->Poll();
+			if (!follower->file_open()) { //CountFile would have thrown
+				throw std::runtime_error("Error opening File: " +
+					                     options.input_files[0]);
+			}
+			std::chrono::duration<double> elapsed =
+				std::chrono::steady_clock::now() - start;
+			records.WriteIngest(options.input_files[0], engine.Items().size(),
+				                engine.TotalUnits(), elapsed.count());
+			if (checkpoint) {
+				WriteCheckpoint(options.checkpoint_file, engine, *follower);
+				records.WriteSnapshot(options.checkpoint_file, "saved",
+					                  follower->offset(),
+					                  engine.Items().size());
+			}
+		}
+		else {
+			for (const std::string& input_file : options.input_files) {
+				ingest.AddInput(input_file);
+			}
+			ingest.set_thread_count(options.thread_count);
+			ingest.Run(engine);
+
+			//report each file's own counts, not the running total
+			for (std::size_t i = 0; i < ingest.size(); ++i) {
+				const IngestPartition& partition = ingest.partition(i);
+				records.WriteIngest(partition.file_name,
+					                partition.counts.Items().size(),
+					                partition.counts.TotalUnits(),
+					                partition.seconds);
+			}
+		}
+
+		if (sketch != nullptr) {
+			WriteResults(options, sketch->Report(), nullptr, sketch.get(),
+				         names, records);
+		}
+		else if (!options.bounded) { //CountExternal wrote its own
+			WriteResults(options, engine,
+				         follower == nullptr ? &ingest : nullptr, nullptr,
+				         names, records);
+		}
+
+		bool serving = !options.serve_address.empty();
+		if (serving) {
+			snapshots.Publish(engine.Items());
+			server.Start(options.serve_address);
+			records.WriteServe(options.serve_address, "started", 0);
+		}
+
+		/*following: wait for the file to change, read what was added, and
+		* redo the results whenever anything was read. Snapshots are saved
+		* at most every checkpoint_seconds, and once more when following
+		* stops, if anything was read since the last one. Serving without
+		* following just waits, while the server answers on its thread.*/
+		auto stop = std::chrono::steady_clock::now() +
+			std::chrono::seconds(options.follow_seconds);
+		auto last_saved = std::chrono::steady_clock::now();
+		bool unsaved = false; //read something since the last snapshot
+		while (options.follow || serving) {
+			records.Flush(); //everything so far is out before waiting
+			unsigned wait = options.poll_milliseconds;
+			if (options.follow_seconds != 0) {
+				auto left = std::chrono::duration_cast<
+					std::chrono::milliseconds>(
+						stop - std::chrono::steady_clock::now()).count();
+				if (left <= 0) { break; }
+				wait = static_cast<unsigned>(std::min<int64_t>(wait, left));
+			}
+			if (!options.follow) { //nothing to follow, only serving
+				std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+				continue;
+			}
+			follower->WaitForChange(wait);
+			FollowUpdate update = follower->Poll();
+			if (update.event == FollowEvent::kNone) { continue; }
+			if (serving) { snapshots.Publish(engine.Items()); }
+			records.WriteFollow(follower->file_name(), update.event,
+				                update.bytes, update.units,
+				                follower->offset());
+			WriteResults(options, engine, nullptr, nullptr, names, records);
+			unsaved = true;
+			if (checkpoint && std::chrono::steady_clock::now() - last_saved >=
+				std::chrono::seconds(options.checkpoint_seconds)) {
+				WriteCheckpoint(options.checkpoint_file, engine, *follower);
+				records.WriteSnapshot(options.checkpoint_file, "saved",
+					                  follower->offset(),
+					                  engine.Items().size());
+				last_saved = std::chrono::steady_clock::now();
+				unsaved = false;
+			}
+		}
+		if (checkpoint && unsaved) {
+			WriteCheckpoint(options.checkpoint_file, engine, *follower);
+			records.WriteSnapshot(options.checkpoint_file, "saved",
+				                  follower->offset(), engine.Items().size());
+		}
+		if (!options.history_file.empty()) {
+			RecordHistory(options, engine, names, records);
+		}
+		if (serving) {
+			server.Stop();
+			records.WriteServe(options.serve_address, "stopped",
+				               server.queries_answered());
+		}
+		if (!options.metrics_file.empty()) {
+			MetricsRegistry::Global().WriteFile(options.metrics_file,
+				                                options.metrics_format);
+			records.WriteMetrics(options.metrics_file, options.metrics_format,
+				                 MetricsRegistry::enabled());
+		}
+	}
+	catch (std::runtime_error& error) { //a file couldn't be read or written
+		records.Flush(); //keep whatever was done before the failure
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+RecordWriter::RecordWriter(OutputStyle style) : style_(style) {}
+
+void RecordWriter::WriteIngest(std::string_view file_name, uint64_t items,
+	                           int64_t units, double seconds) {
+	BeginRecord("ingest");
+	AddField("file", file_name);
+	AddField("items", static_cast<int64_t>(items));
+	AddField("units", units);
+	AddField("seconds", seconds);
+	EndRecord();
+}
+
+void RecordWriter::WriteExport(std::string_view file_name,
+	                           FrequencyFileFormat format, uint64_t items) {
+	BeginRecord("export");
+	AddField("file", file_name);
+	AddField("format", FormatName(format));
+	AddField("items", static_cast<int64_t>(items));
+	EndRecord();
+}
+
+void RecordWriter::WriteChart(std::string_view file_name, uint64_t rows) {
+	BeginRecord("chart");
+	AddField("file", file_name);
+	AddField("rows", static_cast<int64_t>(rows));
+	EndRecord();
+}
+
+void RecordWriter::WriteFollow(std::string_view file_name, FollowEvent event,
+	                           uint64_t bytes, int64_t units,
+	                           uint64_t offset) {
+	BeginRecord("follow");
+	AddField("file", file_name);
+	AddField("event", EventName(event));
+	AddField("bytes", static_cast<int64_t>(bytes));
+	AddField("units", units);
+	AddField("offset", static_cast<int64_t>(offset));
+	EndRecord();
+}
+
+void RecordWriter::WriteSketch(const SketchEngine& sketch) {
+	SketchErrorBounds bounds = sketch.ErrorBounds();
+	BeginRecord("sketch");
+	AddField("memory_bytes", static_cast<int64_t>(sketch.memory_bytes()));
+	AddField("units", sketch.TotalUnits());
+	AddField("distinct", sketch.DistinctItems());
+	AddField("distinct_error", bounds.distinct_error);
+	AddField("frequency_error", bounds.frequency_error);
+	AddField("confidence", bounds.confidence);
+	AddField("top", static_cast<int64_t>(sketch.Report().Items().size()));
+	EndRecord();
+}
+
+void RecordWriter::WriteExternal(const ExternalAggregator& aggregator,
+	                             uint64_t files, double seconds) {
+	BeginRecord("external");
+	AddField("files", static_cast<int64_t>(files));
+	AddField("items", static_cast<int64_t>(aggregator.items()));
+	AddField("units", aggregator.units());
+	AddField("budget_bytes",
+		     static_cast<int64_t>(aggregator.memory_budget()));
+	AddField("peak_bytes", static_cast<int64_t>(aggregator.peak_bytes()));
+	AddField("spills", static_cast<int64_t>(aggregator.spill_count()));
+	AddField("spilled_bytes",
+		     static_cast<int64_t>(aggregator.spilled_bytes()));
+	AddField("splits", static_cast<int64_t>(aggregator.split_count()));
+	AddField("seconds", seconds);
+	EndRecord();
+}
+
+void RecordWriter::WriteSnapshot(std::string_view file_name,
+	                             std::string_view event, uint64_t offset,
+	                             uint64_t items) {
+	BeginRecord("checkpoint");
+	AddField("file", file_name);
+	AddField("event", event);
+	AddField("offset", static_cast<int64_t>(offset));
+	AddField("items", static_cast<int64_t>(items));
+	EndRecord();
+}
+
+void RecordWriter::WriteItem(std::string_view item_name, int64_t count) {
+	BeginRecord("item");
+	AddField("name", item_name);
+	AddField("count", count);
+	EndRecord();
+}
+
+void RecordWriter::WriteRevenue(std::string_view item_name, int64_t count,
+	                            int64_t cents) {
+	BeginRecord("revenue");
+	AddField("name", item_name);
+	AddField("count", count);
+	AddField("cents", cents);
+	EndRecord();
+}
+
+void RecordWriter::WriteRevenueTotal(uint64_t items, int64_t units,
+	                                 int64_t cents) {
+	BeginRecord("revenue_total");
+	AddField("items", static_cast<int64_t>(items));
+	AddField("units", units);
+	AddField("cents", cents);
+	EndRecord();
+}
+
+void RecordWriter::WriteMatch(std::string_view search,
+	                          std::string_view item_name, int64_t count) {
+	BeginRecord("match");
+	AddField("search", search);
+	AddField("name", item_name);
+	AddField("count", count);
+	EndRecord();
+}
+
+void RecordWriter::WriteWindowItem(std::string_view item_name,
+	                               int64_t window, int64_t count,
+	                               int64_t until) {
+	BeginRecord("window_item");
+	AddField("name", item_name);
+	AddField("window", window);
+	AddField("count", count);
+	AddField("until", until);
+	EndRecord();
+}
+
+void RecordWriter::WriteFileItem(std::string_view file_name,
+	                             std::string_view item_name, int64_t count) {
+	BeginRecord("file_item");
+	AddField("file", file_name);
+	AddField("name", item_name);
+	AddField("count", count);
+	EndRecord();
+}
+
+void RecordWriter::WriteRank(const RankQuery& query, uint64_t rank,
+	                         std::string_view item_name, int64_t count) {
+	BeginRecord("rank");
+	AddField("query", RankKindName(query.kind));
+	AddField("value", query.value);
+	AddField("rank", static_cast<int64_t>(rank));
+	AddField("name", item_name);
+	AddField("count", count);
+	EndRecord();
+}
+
+void RecordWriter::WriteServe(std::string_view address,
+	                          std::string_view event, uint64_t queries) {
+	BeginRecord("serve");
+	AddField("address", address);
+	AddField("event", event);
+	AddField("queries", static_cast<int64_t>(queries));
+	EndRecord();
+}
+
+void RecordWriter::WriteHistory(std::string_view file_name,
+	                            std::string_view day, uint64_t items,
+	                            uint64_t days) {
+	BeginRecord("history");
+	AddField("file", file_name);
+	AddField("day", day);
+	AddField("items", static_cast<int64_t>(items));
+	AddField("days", static_cast<int64_t>(days));
+	EndRecord();
+}
+
+void RecordWriter::WriteHistoryDay(std::string_view item_name,
+	                               std::string_view day, int64_t count) {
+	BeginRecord(item_name.empty() ? "history_total" : "history_item");
+	if (!item_name.empty()) { AddField("name", item_name); }
+	AddField("day", day);
+	AddField("count", count);
+	EndRecord();
+}
+
+void RecordWriter::WriteMover(uint64_t rank, std::string_view item_name,
+	                          std::string_view day, int64_t this_week,
+	                          int64_t last_week) {
+	BeginRecord("mover");
+	AddField("rank", static_cast<int64_t>(rank));
+	AddField("name", item_name);
+	AddField("day", day);
+	AddField("this_week", this_week);
+	AddField("last_week", last_week);
+	EndRecord();
+}
+
+void RecordWriter::WriteMetrics(std::string_view file_name,
+	                            MetricsFormat format, bool enabled) {
+	BeginRecord("metrics");
+	AddField("file", file_name);
+	AddField("format", format == MetricsFormat::kJson ? "json" : "prometheus");
+	AddField("enabled", static_cast<int64_t>(enabled));
+	EndRecord();
+}
+
+void RecordWriter::WriteHistogram(uint64_t rows, std::string_view chart) {
+	BeginRecord("histogram");
+	AddField("rows", static_cast<int64_t>(rows));
+	AddField("chart", chart);
+	EndRecord();
+}
+
+void RecordWriter::WriteServed(uint64_t snapshot, uint64_t items,
+	                           int64_t units) {
+	BeginRecord("end");
+	AddField("snapshot", static_cast<int64_t>(snapshot));
+	AddField("items", static_cast<int64_t>(items));
+	AddField("units", units);
+	EndRecord();
+}
+
+void RecordWriter::WriteError(std::string_view message) {
+	BeginRecord("error");
+	AddField("message", message);
+	EndRecord();
+}
+
+//one fwrite for everything formatted so far
+void RecordWriter::Flush() {
+	if (buffer_.empty()) { return; }
+	std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+	std::fflush(stdout);
+	buffer_.clear();
+}
+
+void RecordWriter::MoveTo(std::string& out) {
+	out.append(buffer_);
+	buffer_.clear();
+}
+
+/*JSON records go straight into buffer_. CSV records are built in record_
+* and header_ first, since the header row (if one is needed) has to come
+* before the values.*/
+void RecordWriter::BeginRecord(std::string_view record) {
+	if (style_ == OutputStyle::kJsonLines) {
+		buffer_.append("{\"record\":");
+		AppendQuoted(buffer_, record);
+		return;
+	}
+	record_.assign(record);
+	header_.assign("record");
+}
+
+//text values are quoted and escaped
+void RecordWriter::AddField(std::string_view key, std::string_view value) {
+	std::string quoted; //small, and only built for text fields
+	AppendQuoted(quoted, value);
+	AddRawField(key, quoted);
+}
+
+//whole numbers are formatted with to_chars into a stack buffer
+void RecordWriter::AddField(std::string_view key, int64_t value) {
+	char text[24]; //big enough for any 64 bit integer
+	char* end = std::to_chars(text, text + sizeof(text), value).ptr;
+	AddRawField(key, std::string_view(text, end - text));
+}
+
+//decimals are printed to microsecond precision, plenty for timings
+void RecordWriter::AddField(std::string_view key, double value) {
+	char text[32];
+	int length = std::snprintf(text, sizeof(text), "%.6f", value);
+	AddRawField(key, std::string_view(text, length));
+}
+
+void RecordWriter::AddRawField(std::string_view key, std::string_view value) {
+	if (style_ == OutputStyle::kJsonLines) {
+		buffer_.append(",\"");
+		buffer_.append(key.data(), key.size());
+		buffer_.append("\":");
+		buffer_.append(value.data(), value.size());
+		return;
+	}
+	header_.push_back(',');
+	header_.append(key.data(), key.size());
+	record_.push_back(',');
+	record_.append(value.data(), value.size());
+}
+
+/*closes the JSON object, or writes the CSV row, with a header row first if
+* this is the first record of its kind*/
+void RecordWriter::EndRecord() {
+	if (style_ == OutputStyle::kJsonLines) {
+		buffer_.append("}\n");
+		return;
+	}
+	std::string_view kind(record_.data(), record_.find(','));
+	if (std::find(headed_records_.begin(), headed_records_.end(), kind) ==
+		headed_records_.end()) {
+		headed_records_.emplace_back(kind);
+		buffer_.append(header_);
+		buffer_.push_back('\n');
+	}
+	buffer_.append(record_);
+	buffer_.push_back('\n');
+}
+
+/*JSON: wrap in double quotes, backslash escape quotes, backslashes and
+* control characters. CSV: only quote when the text contains a comma, quote
+* or line break, doubling any quotes inside.*/
+void RecordWriter::AppendQuoted(std::string& out,
+	                            std::string_view text) const {
+	if (style_ == OutputStyle::kJsonLines) {
+		out.push_back('"');
+		for (char character : text) {
+			if (character == '"' || character == '\\') {
+				out.push_back('\\');
+				out.push_back(character);
+			}
+			else if (static_cast<unsigned char>(character) < 0x20) {
+				char escaped[8]; //"\u00XX" plus terminator
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+					          static_cast<unsigned>(character));
+				out.append(escaped);
+			}
+			else { out.push_back(character); }
+		}
+		out.push_back('"');
+		return;
+	}
+	if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+		out.append(text.data(), text.size());
+		return;
+	}
+	out.push_back('"');
+	for (char character : text) {
+		if (character == '"') { out.push_back('"'); } //"" is a quote in CSV
+		out.push_back(character);
+	}
+	out.push_back('"');
+}
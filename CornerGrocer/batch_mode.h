@@ -0,0 +1,254 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Batch Mode header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef BATCH_MODE_H
+#define BATCH_MODE_H
+#include "external_aggregation.h"
+#include "frequency_engine.h"
+#include "histogram.h"
+#include "item_search.h"
+#include "log_follower.h"
+#include "metrics.h"
+#include "multi_file_ingest.h"
+#include "ranking.h"
+#include "sketch_engine.h"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* This file implements the non-interactive side of CornerGrocer: everything
+* the menu does, driven by command line arguments instead of prompts, with
+* machine readable results written to stdout. It counts natively and never
+* starts Python, so it runs anywhere the program does, from cron or a
+* pipeline. Run with --help for the list of arguments. */
+
+//how results are written to stdout
+enum class OutputStyle { kJsonLines, kCsv };
+
+//everything a batch run was asked to do, filled in by ParseBatchOptions
+struct BatchOptions {
+	std::vector<std::string> input_files; //sales logs or directories of them
+	std::string output_file; //frequency file to export, empty for none
+	FrequencyFileFormat output_format = FrequencyFileFormat::kText;
+	RankQuery output_rank; //rank the export instead of writing every item
+	std::vector<std::string> queries; //item names to look up
+	std::string query_file; //file of item names, one per line
+	bool revenue = false; //also report queries' revenue, and the total
+	std::vector<std::string> searches; //text to search item names for
+	uint32_t search_limit = 10; //most items listed per search
+	OutputStyle output_style = OutputStyle::kJsonLines;
+	unsigned thread_count = 0; //ingest threads, 0 for one per core
+	std::string chart_file; //file to draw the histogram into, empty for none
+	HistogramOptions chart; //width, order and top of that histogram
+	std::vector<RankQuery> rankings; //--top, --bottom and --above, in order
+	std::vector<int64_t> windows; //seconds, queries are also answered over
+	TimeWindowOptions window_buckets; //bucket length and count for windows
+	bool per_file = false; //also answer queries from each file's own counts
+	std::string per_file_directory; //each file's frequency file goes here
+	bool follow = false; //keep reading the input as it grows
+	unsigned poll_milliseconds = 1000; //longest wait between follow reads
+	unsigned follow_seconds = 0; //stop following after this, 0 for never
+	std::string checkpoint_file; //snapshot to resume from and save to
+	unsigned checkpoint_seconds = 60; //least time between follow snapshots
+	bool approximate = false; //estimate counts in fixed memory instead
+	SketchOptions sketch; //how much memory estimating uses
+	bool bounded = false; //count exactly within a budget, spilling to disk
+	ExternalAggregationOptions external; //that budget, and where to spill
+	std::string serve_address; //where to answer queries, empty for nowhere
+	std::string metrics_file; //where to write timings, empty for nowhere
+	std::string history_file; //history to record the day in, empty for none
+	int64_t history_day = INT64_MIN; //day recorded, INT64_MIN for today
+	uint32_t history_days = 90; //days back queries are answered for
+	uint32_t mover_count = 10; //week over week movers listed
+	MetricsFormat metrics_format = MetricsFormat::kPrometheus;
+};
+
+/*Fills in options from the command line. Returns false and sets error to
+* a message for the user if an argument is unknown, is missing its value,
+* or has a value that doesn't make sense.*/
+bool ParseBatchOptions(int argc, char* argv[], BatchOptions& options,
+	                   std::string& error);
+
+//Prints the list of batch arguments and what they do
+void PrintBatchUsage(std::ostream& output);
+
+/*Runs ingest, export, chart, queries, searches and rankings, in that order, and
+* returns the process exit status: 0 on success, 1 if a file couldn't be read
+* or written. Errors are reported on stderr, results on stdout. Input files
+* are counted concurrently as separate partitions (see multi_file_ingest.h)
+* and merged in the order given, so the results don't depend on how many
+* threads there are. With per_file, queries are also answered, and with
+* per_file_directory frequency files also written, for each file. With
+* follow, the input is then read again every time it grows, and everything
+* after ingest is redone after every read, until follow_seconds pass (or
+* forever). With checkpoint_file, the input is resumed from its snapshot
+* (see checkpoint.h) if it has a valid one, and a snapshot is saved after
+* ingest and while following. With approximate, files are counted one
+* after another into a SketchEngine (see sketch_engine.h): queries are
+* answered with estimates, and exports, charts and rankings are made from
+* its best sellers. With serve_address, queries are also answered over a
+* socket (see query_server.h) from the counts after ingest and after every
+* follow read, until follow_seconds pass (or forever), following or not.
+* With metrics_file, the stage timings (see metrics.h) are written there
+* last of all. With revenue, each query's revenue, and all of it, are
+* written after the queries, from the prices in the log (see
+* sales_record.h). With history_file, the counts are recorded there as the
+* day's column (see history_store.h) once ingest, or following, is over, and
+* each query's units, and every item's, on each day of the last
+* history_days recorded are written, then the biggest movers. With
+* bounded, files are counted one after another through an
+* ExternalAggregator (see external_aggregation.h), and only the export,
+* queries and revenue are written. */
+int RunBatch(const BatchOptions& options);
+
+/*Formats batch results as JSON lines or CSV into one buffer, which is
+* written to stdout with a single call when Flush is called or the writer
+* leaves scope. Every record has a "record" field saying what it is, so
+* different kinds of record can share one stream. In CSV, the first record
+* of each kind is preceded by a header row ("record,<field>,...") naming
+* that kind's columns, so a reader can filter rows on the first column. */
+class RecordWriter {
+public:
+	explicit RecordWriter(OutputStyle style);
+	~RecordWriter() { Flush(); }
+
+	//one line per input file counted
+	void WriteIngest(std::string_view file_name, uint64_t items,
+		             int64_t units, double seconds);
+
+	//one line per frequency file written
+	void WriteExport(std::string_view file_name, FrequencyFileFormat format,
+		             uint64_t items);
+
+	//one line per histogram drawn, rows is how many items it charted
+	void WriteChart(std::string_view file_name, uint64_t rows);
+
+	/*one line per follow read that found something: what happened, bytes
+	* read, units added and how far into the file counting has got*/
+	void WriteFollow(std::string_view file_name, FollowEvent event,
+		             uint64_t bytes, int64_t units, uint64_t offset);
+
+	/*one line per approximate count: memory used, units, estimated distinct
+	* items, the error bounds and how many best sellers were kept*/
+	void WriteSketch(const SketchEngine& sketch);
+
+	/*one line per count made within a memory budget, for every input
+	* file at once: items, units, the budget and the most the table used,
+	* and what was spilled to disk to stay within it*/
+	void WriteExternal(const ExternalAggregator& aggregator, uint64_t files,
+		               double seconds);
+
+	/*one line per snapshot loaded or saved (event), with the offset into
+	* the input it was taken at and the items in it*/
+	void WriteSnapshot(std::string_view file_name, std::string_view event,
+		               uint64_t offset, uint64_t items);
+
+	//one line per item looked up, count is -1 if the item wasn't sold
+	void WriteItem(std::string_view item_name, int64_t count);
+
+	/*one line per item looked up for its revenue, in cents, both -1 if the
+	* item wasn't sold*/
+	void WriteRevenue(std::string_view item_name, int64_t count,
+		              int64_t cents);
+
+	//one line with every item's units and revenue, in cents, added up
+	void WriteRevenueTotal(uint64_t items, int64_t units, int64_t cents);
+
+	/*one line per item a search matched, in the order the search put them,
+	* with the text that was searched for*/
+	void WriteMatch(std::string_view search, std::string_view item_name,
+		            int64_t count);
+
+	/*one line per item and window looked up: units sold in the window
+	* seconds up to until (seconds since 1970)*/
+	void WriteWindowItem(std::string_view item_name, int64_t window,
+		                 int64_t count, int64_t until);
+
+	//one line per item looked up in one input file's own counts
+	void WriteFileItem(std::string_view file_name,
+		               std::string_view item_name, int64_t count);
+
+	/*one line per item a ranking picked, rank counting from 1 in the order
+	* the ranking put them*/
+	void WriteRank(const RankQuery& query, uint64_t rank,
+		           std::string_view item_name, int64_t count);
+
+	/*one line when the query server starts, and one when it stops with
+	* how many queries it answered*/
+	void WriteServe(std::string_view address, std::string_view event,
+		            uint64_t queries);
+
+	/*one line when a day is recorded in a history, with the items and days
+	* the history has after it*/
+	void WriteHistory(std::string_view file_name, std::string_view day,
+		              uint64_t items, uint64_t days);
+
+	/*one line per item looked up and day recorded in the history, or per
+	* day with every item's units added up (an empty item_name)*/
+	void WriteHistoryDay(std::string_view item_name, std::string_view day,
+		                 int64_t count);
+
+	/*one line per item whose sales changed the most, rank counting from
+	* 1, with its units in the week up to day and in the week before*/
+	void WriteMover(uint64_t rank, std::string_view item_name,
+		            std::string_view day, int64_t this_week,
+		            int64_t last_week);
+
+	/*one line when the timings are written, with whether this build
+	* records any (see metrics.h)*/
+	void WriteMetrics(std::string_view file_name, MetricsFormat format,
+		              bool enabled);
+
+	//a chart drawn for a query, and how many items it charted
+	void WriteHistogram(uint64_t rows, std::string_view chart);
+
+	/*the last line of every answer the query server sends: which snapshot
+	* it came from, and that snapshot's items and units*/
+	void WriteServed(uint64_t snapshot, uint64_t items, int64_t units);
+
+	//a query that couldn't be answered, and why
+	void WriteError(std::string_view message);
+
+	//writes everything buffered so far to stdout
+	void Flush();
+
+	/*moves everything buffered so far onto the end of out instead, for
+	* records sent somewhere other than stdout*/
+	void MoveTo(std::string& out);
+
+private:
+	/*starts a record: "{"record":"<record>"" for JSON, "<record>" for CSV.
+	* Fields are then added with the Add functions and the record ended with
+	* EndRecord.*/
+	void BeginRecord(std::string_view record);
+	void AddField(std::string_view key, std::string_view value);
+	void AddField(std::string_view key, int64_t value);
+	void AddField(std::string_view key, double value);
+	void EndRecord();
+
+	//appends text to out as a JSON string or CSV field, quoted and escaped
+	void AppendQuoted(std::string& out, std::string_view text) const;
+
+	//adds key and an already formatted value to the current record
+	void AddRawField(std::string_view key, std::string_view value);
+
+	OutputStyle style_; //JSON lines or CSV
+	std::string buffer_; //formatted records not yet written
+	std::string record_; //CSV row being built, starting with its kind
+	std::string header_; //CSV header row of the record being built
+	std::vector<std::string> headed_records_; //kinds with a CSV header out
+};
+#endif
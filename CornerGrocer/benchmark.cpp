@@ -0,0 +1,1041 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Benchmark definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "python_functions.h"
+#include "checkpoint.h"
+#include "concurrent_count_table.h"
+#include "external_aggregation.h"
+#include "frequency_engine.h"
+#include "frequency_file.h"
+#include "histogram.h"
+#include "history_store.h"
+#include "item_search.h"
+#include "line_scanner.h"
+#include "log_follower.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "query_server.h"
+#include "ranking.h"
+#include "sales_log_generator.h"
+#include "sales_record.h"
+#include "sketch_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef CORNER_GROCER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/* This file is the benchmark program, a separate executable from
+* CornerGrocer (CornerGrocerBenchmark in the solution, or the Makefile in
+* CornerGrocerBenchmark/ on Linux). It generates a synthetic sales log (see
+* sales_log_generator.h), then times every stage of the program on it:
+* scanning, ingest, single and batch lookup, frequency file write and read,
+* and histogram rendering, natively and through ProduceManager.py. Each
+* stage is run --repeat times and the fastest run kept, since slower runs
+* only measure interference from the rest of the machine. Results are
+* written as one JSON document, so runs of different versions can be
+* compared stage by stage. ProduceManager.py has to be importable, so run
+* it from CornerGrocer/ with PYTHONPATH=. (or pass --no-python). */
+
+namespace {
+//everything the command line can change
+struct BenchmarkOptions {
+	SalesLogOptions log; //shape of the generated log
+	std::string log_file; //existing log to use instead of generating one
+	std::string work_directory = "."; //where generated files are written
+	std::string output_file = "benchmark_results.json"; //"-" for stdout
+	unsigned thread_count = 0; //parallel ingest threads, 0 for one per core
+	unsigned repeat = 3; //runs of each stage, the fastest is kept
+	uint64_t query_count = 100000; //names looked up by the lookup stages
+	std::size_t chart_width = 100; //columns the histogram is scaled to
+	bool run_python = true; //false skips every ProduceManager stage
+	bool keep_files = false; //true leaves generated files behind
+};
+
+//one timed stage, one entry of the "results" array
+struct StageResult {
+	std::string stage; //what was timed, e.g. "ingest"
+	std::string backend; //"native", "python", "approximate", or a shared table
+	unsigned threads; //threads the stage used
+	unsigned runs; //times it was run
+	double seconds; //fastest run
+	uint64_t bytes; //bytes processed per run, 0 if not meaningful
+	uint64_t operations; //lines, lookups or rows per run
+};
+
+/*runs work repeat times and returns the fastest run in seconds. work
+* returns nothing; anything it computes should be kept somewhere the
+* compiler can't throw away.*/
+template<typename Work> double FastestRun(unsigned repeat, Work work) {
+	double fastest = 0;
+	for (unsigned run = 0; run < repeat; ++run) {
+		auto start = std::chrono::steady_clock::now();
+		work();
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		if (run == 0 || elapsed.count() < fastest) {
+			fastest = elapsed.count();
+		}
+	}
+	return fastest;
+}
+
+/*returns the value following argument index, moving index onto it, or
+* throws if the argument was the last one*/
+const char* TakeValue(int argc, char* argv[], int& index) {
+	if (index + 1 >= argc) {
+		throw std::invalid_argument(std::string("Missing value for ") +
+			                        argv[index]);
+	}
+	return argv[++index];
+}
+
+//parses a whole, non-negative number or throws
+uint64_t TakeCount(int argc, char* argv[], int& index) {
+	const char* argument = argv[index];
+	int64_t value = 0;
+	if (!ParseInteger(TakeValue(argc, argv, index), value) || value < 0) {
+		throw std::invalid_argument(std::string(argument) +
+			                        " needs a whole number");
+	}
+	return static_cast<uint64_t>(value);
+}
+
+void PrintUsage(std::ostream& output) {
+	output << "Usage: CornerGrocerBenchmark [arguments]\n"
+		<< "  --lines N          lines in the generated log (default 1000000)\n"
+		<< "  --items N          distinct items in the log (default 1000)\n"
+		<< "  --skew S           Zipf skew, 0 for uniform (default 1.0)\n"
+		<< "  --seed N           random seed for the log\n"
+		<< "  --log FILE         benchmark an existing log instead\n"
+		<< "  --threads N        parallel ingest threads, 0 (default) for "
+		<< "one per core\n"
+		<< "  --repeat N         runs per stage, fastest kept (default 3)\n"
+		<< "  --queries N        lookups per lookup stage (default 100000)\n"
+		<< "  --chart-width N    histogram width in columns (default 100)\n"
+		<< "  --work-dir DIR     where generated files go (default .)\n"
+		<< "  --output FILE      JSON results, - for stdout (default "
+		<< "benchmark_results.json)\n"
+		<< "  --no-python        skip the ProduceManager.py stages\n"
+		<< "  --keep-files       keep the generated log and frequency files\n"
+		<< "  --help             show this message\n";
+}
+
+/*fills in options from the command line. Returns false for --help, throws
+* std::invalid_argument for anything it doesn't understand.*/
+bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options) {
+	for (int index = 1; index < argc; ++index) {
+		std::string argument = argv[index];
+		if (argument == "--help" || argument == "-h") { return false; }
+		else if (argument == "--lines") {
+			options.log.line_count = TakeCount(argc, argv, index);
+		}
+		else if (argument == "--items") {
+			uint64_t items = TakeCount(argc, argv, index);
+			if (items == 0 || items > UINT32_MAX) {
+				throw std::invalid_argument("--items must be 1 to 4294967295");
+			}
+			options.log.item_count = static_cast<uint32_t>(items);
+		}
+		else if (argument == "--skew") {
+			const char* value = TakeValue(argc, argv, index);
+			char* end = nullptr;
+			options.log.skew = std::strtod(value, &end);
+			if (*end != '\0' || options.log.skew < 0) {
+				throw std::invalid_argument("--skew needs a number, 0 or more");
+			}
+		}
+		else if (argument == "--seed") {
+			options.log.seed = TakeCount(argc, argv, index);
+		}
+		else if (argument == "--log") {
+			options.log_file = TakeValue(argc, argv, index);
+		}
+		else if (argument == "--threads") {
+			options.thread_count =
+				static_cast<unsigned>(TakeCount(argc, argv, index));
+		}
+		else if (argument == "--repeat") {
+			options.repeat = static_cast<unsigned>(
+				std::max<uint64_t>(1, TakeCount(argc, argv, index)));
+		}
+		else if (argument == "--queries") {
+			options.query_count = TakeCount(argc, argv, index);
+		}
+		else if (argument == "--chart-width") {
+			options.chart_width = TakeCount(argc, argv, index);
+		}
+		else if (argument == "--work-dir") {
+			options.work_directory = TakeValue(argc, argv, index);
+		}
+		else if (argument == "--output") {
+			options.output_file = TakeValue(argc, argv, index);
+		}
+		else if (argument == "--no-python") { options.run_python = false; }
+		else if (argument == "--keep-files") { options.keep_files = true; }
+		else {
+			throw std::invalid_argument("Unknown argument: " + argument);
+		}
+	}
+	return true;
+}
+
+//how much of a rewritten log WriteEveryLine builds before each write
+const std::size_t kWriteBlockBytes = 1 << 20;
+
+/*writes a copy of every line of log to file_name, each one appended to the
+* block by write_line(line_number, line, block), a block at a time like
+* SalesLogGenerator::WriteLog, so a log as big as the disk never has to fit
+* in memory. Throws std::runtime_error if the file can't be written.*/
+template<typename WriteLine>
+void WriteEveryLine(const MappedFile& log, const std::string& file_name,
+	                WriteLine write_line) {
+	std::ofstream output(file_name, std::ios::out | std::ios::binary);
+	if (!output.is_open()) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	std::string block;
+	block.reserve(kWriteBlockBytes + 256);
+	LineScanner lines(log.data(), log.size());
+	uint64_t line_number = 0;
+	for (std::string_view line; lines.Next(line); ++line_number) {
+		write_line(line_number, line, block);
+		if (block.size() >= kWriteBlockBytes) {
+			output.write(block.data(), block.size());
+			block.clear();
+		}
+	}
+	output.write(block.data(), block.size());
+	output.close();
+	if (!output) {
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+}
+
+/*names looked up by the lookup stages: drawn from the same distribution as
+* the log (so popular items are asked about more often), with every tenth
+* one an item that was never sold, so misses are timed too*/
+std::vector<std::string> MakeQueries(const SalesLogOptions& log,
+	                                 uint64_t query_count) {
+	SalesLogOptions query_log = log;
+	query_log.seed = log.seed + 1; //different draws from the same items
+	SalesLogGenerator generator(query_log);
+	std::vector<std::string> queries;
+	queries.reserve(query_count);
+	for (uint64_t query = 0; query < query_count; ++query) {
+		if (query % 10 == 9) {
+			queries.push_back("Unsold-" + std::to_string(query));
+		}
+		else { queries.push_back(generator.ItemName(generator.NextItem())); }
+	}
+	return queries;
+}
+
+//appends text to json as a quoted, escaped JSON string
+void AppendJsonString(std::string& json, const std::string& text) {
+	json.push_back('"');
+	for (char character : text) {
+		if (character == '"' || character == '\\') { json.push_back('\\'); }
+		if (static_cast<unsigned char>(character) < 0x20) { continue; }
+		json.push_back(character);
+	}
+	json.push_back('"');
+}
+
+//appends a number to json, as an integer or with six decimal places
+void AppendJsonNumber(std::string& json, uint64_t value) {
+	json.append(std::to_string(value));
+}
+void AppendJsonNumber(std::string& json, double value) {
+	char text[48];
+	int length = std::snprintf(text, sizeof(text), "%.6f", value);
+	json.append(text, length);
+}
+
+//one result as a JSON object, with rates worked out from the raw numbers
+void AppendJsonResult(std::string& json, const StageResult& result) {
+	json.append("    {\"stage\": ");
+	AppendJsonString(json, result.stage);
+	json.append(", \"backend\": ");
+	AppendJsonString(json, result.backend);
+	json.append(", \"threads\": ");
+	AppendJsonNumber(json, static_cast<uint64_t>(result.threads));
+	json.append(", \"runs\": ");
+	AppendJsonNumber(json, static_cast<uint64_t>(result.runs));
+	json.append(", \"seconds\": ");
+	AppendJsonNumber(json, result.seconds);
+	json.append(", \"bytes\": ");
+	AppendJsonNumber(json, result.bytes);
+	json.append(", \"operations\": ");
+	AppendJsonNumber(json, result.operations);
+	double seconds = std::max(result.seconds, 1e-9); //no dividing by 0
+	json.append(", \"mb_per_second\": ");
+	AppendJsonNumber(json, result.bytes / seconds / 1e6);
+	json.append(", \"ns_per_operation\": ");
+	AppendJsonNumber(json, result.operations == 0 ? 0.0 :
+		             result.seconds * 1e9 / result.operations);
+	json.append("}");
+}
+
+/*runs every ProduceManager stage, appending to results. Returns false if
+* ProduceManager.py couldn't be imported. Python's counts are checked
+* against native_counts, and any difference reported on stderr.*/
+bool RunPythonStages(const BenchmarkOptions& options,
+	                 const std::string& log_file,
+	                 const std::string& python_output_file,
+	                 const std::vector<std::string>& queries,
+	                 const FrequencyEngine& native_counts,
+	                 std::vector<StageResult>& results) {
+	InitPython(); //call function to initialize Python, import ProduceManager
+	PyObject* module = PyImport_AddModule("ProduceManager");
+	if (module == NULL || !PyObject_HasAttrString(module, "ProduceManager")) {
+		std::cerr << "ProduceManager.py couldn't be imported, skipping "
+			<< "Python stages (run from CornerGrocer/ with PYTHONPATH=.)"
+			<< std::endl;
+		Py_Finalize();
+		return false;
+	}
+	uint64_t log_bytes = MappedFile(log_file).size();
+	uint64_t log_lines = static_cast<uint64_t>(native_counts.TotalUnits());
+
+	/*one instance for every run, since totalProduceFrequencies empties its
+	* dictionary before counting*/
+	PyObject* instance = CallClassConstructor(*log_file.c_str(),
+		                                      *python_output_file.c_str());
+	double seconds = FastestRun(options.repeat, [&]() {
+		CallObjectMethod<void>(instance, *"totalProduceFrequencies");
+	});
+	results.push_back({"ingest", "python", 1, options.repeat, seconds,
+		               log_bytes, log_lines});
+
+	int64_t checksum = 0; //sum of every answer, so no lookup is skipped
+	seconds = FastestRun(options.repeat, [&]() {
+		for (const std::string& query : queries) {
+			checksum += CallObjectMethod<int>(instance,
+				                              *"returnProduceFrequency",
+				                              *query.c_str());
+		}
+	});
+	results.push_back({"lookup", "python", 1, options.repeat, seconds, 0,
+		               queries.size()});
+
+	/*Python has no batch lookup of its own: the batch path copies the whole
+	* table across with exportFrequencyTable, then answers natively*/
+	FrequencyTable python_counts;
+	std::vector<int64_t> answers(queries.size());
+	seconds = FastestRun(options.repeat, [&]() {
+		FetchFrequencyTable(instance, *"exportFrequencyTable", python_counts);
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			uint32_t id = python_counts.Find(queries[i]);
+			answers[i] = id == ItemDictionary::kNotFound ? -1 :
+				python_counts.Count(id);
+		}
+	});
+	results.push_back({"batch_lookup", "python", 1, options.repeat, seconds,
+		               0, queries.size()});
+
+	seconds = FastestRun(options.repeat, [&]() {
+		CallObjectMethod<void>(instance, *"writeFrequencyFile");
+	});
+	results.push_back({"write_text", "python", 1, options.repeat, seconds,
+		               MappedFile(python_output_file).size(),
+		               python_counts.size()});
+
+	//both backends should have counted exactly the same thing
+	uint32_t mismatches = 0;
+	const FrequencyTable& native_items = native_counts.Items();
+	for (uint32_t id = 0; id < python_counts.size(); ++id) {
+		uint32_t native_id = native_items.Find(python_counts.Name(id));
+		if (native_id == ItemDictionary::kNotFound ||
+			native_items.Count(native_id) != python_counts.Count(id)) {
+			++mismatches;
+		}
+	}
+	if (mismatches != 0 || python_counts.size() != native_items.size()) {
+		std::cerr << "Python and native counts differ for " << mismatches
+			<< " items" << std::endl;
+	}
+	if (checksum == 0) { std::cerr << "No Python lookup found an item\n"; }
+	FinalizePython(instance); //clean up the instance and the interpreter
+	return true;
+}
+
+/*what ConcurrentCountTable is measured against: the obvious way to make a
+* count table safe to share, one lock around a std::unordered_map, taken
+* for every line and every lookup*/
+class MutexCountMap {
+public:
+	void Add(std::string_view item_name, int64_t amount) {
+		std::string key(item_name); //made before locking, not while held
+		std::lock_guard<std::mutex> lock(mutex_);
+		counts_[key] += amount;
+	}
+
+	int64_t Count(std::string_view item_name) const {
+		std::string key(item_name);
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto found = counts_.find(key);
+		return found != counts_.end() ? found->second : -1;
+	}
+
+	/*the same line handling as ConcurrentCountTable::CountBuffer, so both
+	* parse quantities (returns too) and drop prices the same way*/
+	void CountBuffer(const char* data, std::size_t size) {
+		LineScanner lines(data, size);
+		for (std::string_view line; lines.Next(line);) {
+			std::string_view item_name = TrimWhitespace(line);
+			int64_t seconds = 0;
+			SplitTimestamp(item_name, seconds, item_name);
+			SalesRecord record;
+			ParseSalesRecord(item_name, record);
+			if (!record.item_name.empty()) {
+				Add(record.item_name, record.quantity);
+			}
+		}
+	}
+
+private:
+	mutable std::mutex mutex_; //held for every Add and Count
+	std::unordered_map<std::string, int64_t> counts_; //name -> units
+};
+
+/*the stress test and benchmark of a table shared between threads. threads
+* writers count a piece of the log each into a fresh CountTable while as
+* many readers look queries up in it, round and round, until the writers
+* are done. The fastest run's time is the "concurrent_count" stage, and
+* the lookups its readers made in that time the "concurrent_read" stage.
+* Then the finished table is only read, every thread taking a share of the
+* queries, as "concurrent_lookup". However the writers' lines interleaved,
+* the finished table has to match native_counts, which hold what a serial
+* count of the log gives, exactly; any difference is reported on stderr.
+* Counts seen part way can go down, since returns are negative, so only
+* the final totals are checked.*/
+template<typename CountTable>
+void RunConcurrentStages(const char* backend, const MappedFile& log,
+	                     unsigned threads, unsigned repeat,
+	                     uint64_t line_count,
+	                     const std::vector<std::string>& queries,
+	                     const FrequencyEngine& native_counts,
+	                     std::vector<StageResult>& results) {
+	std::vector<const char*> bounds = SplitAtLines(log.data(), log.size(),
+		                                           threads);
+	std::unique_ptr<CountTable> table;
+	double fastest = 0;
+	uint64_t fastest_lookups = 0; //readers' lookups during the fastest run
+	for (unsigned run = 0; run < repeat; ++run) {
+		table.reset(new CountTable());
+		std::atomic<bool> counting{true};
+		std::atomic<uint64_t> lookups{0};
+		std::atomic<int64_t> seen_sum{0}; //so no lookup is skipped
+		std::vector<std::thread> readers;
+		for (unsigned reader = 0; reader < threads && !queries.empty();
+			 ++reader) {
+			readers.emplace_back([&, reader]() {
+				int64_t sum = 0;
+				uint64_t made = 0;
+				for (std::size_t i = reader % queries.size(); counting.load();
+					 i = (i + 1) % queries.size(), ++made) {
+					sum += table->Count(queries[i]);
+				}
+				lookups += made;
+				seen_sum += sum;
+			});
+		}
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> writers;
+		for (std::size_t chunk = 0; chunk + 1 < bounds.size(); ++chunk) {
+			writers.emplace_back([&, chunk]() {
+				table->CountBuffer(bounds[chunk],
+					               bounds[chunk + 1] - bounds[chunk]);
+			});
+		}
+		for (std::thread& writer : writers) { writer.join(); }
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		counting.store(false);
+		for (std::thread& reader : readers) { reader.join(); }
+		if (run == 0 || elapsed.count() < fastest) {
+			fastest = elapsed.count();
+			fastest_lookups = lookups.load();
+		}
+	}
+	results.push_back({"concurrent_count", backend, threads, repeat, fastest,
+		               log.size(), line_count});
+	results.push_back({"concurrent_read", backend, threads, repeat, fastest,
+		               0, fastest_lookups});
+
+	std::atomic<int64_t> checksum{0}; //so no lookup is skipped
+	double seconds = FastestRun(repeat, [&]() {
+		std::vector<std::thread> readers;
+		for (unsigned reader = 0; reader < threads; ++reader) {
+			readers.emplace_back([&, reader]() {
+				int64_t sum = 0;
+				for (std::size_t i = reader; i < queries.size();
+					 i += threads) {
+					sum += table->Count(queries[i]);
+				}
+				checksum += sum;
+			});
+		}
+		for (std::thread& reader : readers) { reader.join(); }
+	});
+	results.push_back({"concurrent_lookup", backend, threads, repeat,
+		               seconds, 0, queries.size()});
+
+	const FrequencyTable& items = native_counts.Items();
+	uint32_t mismatches = 0;
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		if (table->Count(items.Name(id)) != items.Count(id)) { ++mismatches; }
+	}
+	if (mismatches != 0) {
+		std::cerr << backend << " table got " << mismatches
+			<< " counts wrong" << std::endl;
+	}
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+	BenchmarkOptions options;
+	try {
+		if (!ParseOptions(argc, argv, options)) {
+			PrintUsage(std::cout);
+			return 0;
+		}
+	}
+	catch (std::invalid_argument& error) {
+		std::cerr << error.what() << std::endl;
+		PrintUsage(std::cerr);
+		return 2;
+	}
+
+	unsigned parallel_threads = options.thread_count != 0 ?
+		options.thread_count :
+		std::max(1u, std::thread::hardware_concurrency());
+	std::string prefix = options.work_directory + "/benchmark_";
+	std::string log_file = options.log_file.empty() ?
+		prefix + "log.txt" : options.log_file;
+	std::string text_file = prefix + "frequency.dat";
+	std::string binary_file = prefix + "frequency.bin";
+	std::string python_file = prefix + "python_frequency.dat";
+	std::string checkpoint_file = prefix + "checkpoint";
+	std::string history_file = prefix + "history";
+	std::string gzip_file = prefix + "log.txt.gz";
+	std::string priced_file = prefix + "priced_log.txt";
+	std::string timed_file = prefix + "timed_log.txt";
+	std::vector<StageResult> results;
+	uint64_t line_count = 0; //lines in the log, counted by the scan stage
+
+	try {
+		//the log itself, unless an existing one was given
+		if (options.log_file.empty()) {
+			SalesLogGenerator generator(options.log);
+			auto start = std::chrono::steady_clock::now();
+			generator.WriteLog(log_file);
+			std::chrono::duration<double> elapsed =
+				std::chrono::steady_clock::now() - start;
+			results.push_back({"generate", "native", 1, 1, elapsed.count(),
+				               MappedFile(log_file).size(),
+				               options.log.line_count});
+		}
+		MappedFile log(log_file);
+		uint64_t log_bytes = log.size();
+
+		//raw scanning speed, the ceiling for everything that reads the log
+		std::size_t newlines = 0;
+		double seconds = FastestRun(options.repeat, [&]() {
+			newlines = CountNewlines(log.data(), log.size());
+		});
+		results.push_back({"scan_newlines", "native", 1, options.repeat,
+			               seconds, log_bytes, newlines});
+		seconds = FastestRun(options.repeat, [&]() {
+			LineScanner lines(log.data(), log.size());
+			line_count = 0;
+			for (std::string_view line; lines.Next(line);) { ++line_count; }
+		});
+		results.push_back({"scan_lines", "native", 1, options.repeat,
+			               seconds, log_bytes, line_count});
+
+		//ingest, serially and then in parallel if there is more than 1 core
+		FrequencyEngine engine;
+		std::vector<unsigned> ingest_threads = {1};
+		if (parallel_threads > 1) {
+			ingest_threads.push_back(parallel_threads);
+		}
+		for (unsigned threads : ingest_threads) {
+			engine.set_thread_count(threads);
+			seconds = FastestRun(options.repeat, [&]() {
+				engine.Clear();
+				engine.CountFile(log_file);
+			});
+			results.push_back({"ingest", "native", threads, options.repeat,
+				               seconds, log_bytes, line_count});
+		}
+
+		/*the same sales with a quantity and price on every line (see
+		* sales_record.h), counted from a file like the plain log, for what
+		* parsing them costs over bare names*/
+		WriteEveryLine(log, priced_file, [](uint64_t line_number,
+			                                std::string_view line,
+			                                std::string& block) {
+			block.append(line);
+			block.append(line_number % 4 == 0 ? " 3 0.45\n" : " 1 2.50\n");
+		});
+		FrequencyEngine priced_engine;
+		priced_engine.set_thread_count(ingest_threads.back());
+		seconds = FastestRun(options.repeat, [&]() {
+			priced_engine.Clear();
+			priced_engine.CountFile(priced_file);
+		});
+		results.push_back({"ingest_priced", "native", ingest_threads.back(),
+			               options.repeat, seconds,
+			               MappedFile(priced_file).size(), line_count});
+		if (priced_engine.Items().TotalRevenue() == 0) {
+			std::cerr << "Priced ingest found no revenue" << std::endl;
+		}
+
+		/*the same sales stamped with a time in one hour, every fourth one a
+		* return of 2 units, counted into time buckets. The hour's window
+		* has to add up to each item's total, returns and all.*/
+		WriteEveryLine(log, timed_file, [](uint64_t line_number,
+			                               std::string_view line,
+			                               std::string& block) {
+			char stamp[32]; //seconds since 1970 and a space
+			std::snprintf(stamp, sizeof(stamp), "%llu ",
+				          1619172000ULL + line_number % 3600);
+			block.append(stamp);
+			block.append(line);
+			block.append(line_number % 4 == 0 ? " -2\n" : "\n");
+		});
+		FrequencyEngine timed_engine;
+		timed_engine.set_thread_count(ingest_threads.back());
+		timed_engine.EnableTimeWindows(TimeWindowOptions());
+		seconds = FastestRun(options.repeat, [&]() {
+			timed_engine.Clear();
+			timed_engine.CountFile(timed_file);
+		});
+		results.push_back({"ingest_timed", "native", ingest_threads.back(),
+			               options.repeat, seconds,
+			               MappedFile(timed_file).size(), line_count});
+		const FrequencyTable& timed_items = timed_engine.Items();
+		uint32_t window_mismatches = 0;
+		for (uint32_t id = 0; id < timed_items.size(); ++id) {
+			if (timed_engine.time_windows()->WindowCount(id, 3600) !=
+				timed_items.Count(id)) {
+				++window_mismatches;
+			}
+		}
+		if (window_mismatches != 0) {
+			std::cerr << "Time windows got " << window_mismatches
+				<< " items with returns wrong" << std::endl;
+		}
+
+#ifdef CORNER_GROCER_HAVE_ZLIB
+		/*the log gzipped, at the fastest level as an archiving job might,
+		* then counted through the decompressing reader. Bytes are the
+		* compressed ones, what the disk has to supply.*/
+		gzFile gzip_output = gzopen(gzip_file.c_str(), "wb1");
+		if (gzip_output == nullptr) {
+			throw std::runtime_error("Error creating File: " + gzip_file);
+		}
+		for (uint64_t written = 0; written < log_bytes;) {
+			unsigned step = static_cast<unsigned>(
+				std::min<uint64_t>(log_bytes - written, 1 << 20));
+			gzwrite(gzip_output, log.data() + written, step);
+			written += step;
+		}
+		gzclose(gzip_output);
+		FrequencyEngine gzip_engine;
+		gzip_engine.set_thread_count(ingest_threads.back());
+		seconds = FastestRun(options.repeat, [&]() {
+			gzip_engine.Clear();
+			gzip_engine.CountFile(gzip_file);
+		});
+		results.push_back({"ingest_gzip", "native", ingest_threads.back(),
+			               options.repeat, seconds,
+			               MappedFile(gzip_file).size(), line_count});
+		if (gzip_engine.TotalUnits() != engine.TotalUnits()) {
+			std::cerr << "The gzipped log didn't count the same" << std::endl;
+		}
+#endif
+
+		/*the log counted exactly in the smallest memory budget, spilling to
+		* runs in the work directory and adding them up again, with the
+		* frequency file written as it goes*/
+		ExternalAggregationOptions external_options;
+		external_options.memory_budget = uint64_t(1) << 20;
+		external_options.spill_directory = options.work_directory;
+		int64_t external_units = 0;
+		std::vector<std::string_view> no_names; //nothing is looked up
+		std::vector<int64_t> no_counts;
+		std::vector<int64_t> no_revenue;
+		seconds = FastestRun(options.repeat, [&]() {
+			ExternalAggregator aggregator(external_options);
+			aggregator.CountFile(log_file);
+			aggregator.Finish(text_file, no_names, no_counts, no_revenue);
+			external_units = aggregator.units();
+		});
+		results.push_back({"ingest_external", "native", 1, options.repeat,
+			               seconds, log_bytes, line_count});
+		if (external_units != engine.TotalUnits()) {
+			std::cerr << "Counting within a budget didn't count the same"
+				<< std::endl;
+		}
+
+		//lookups, one name at a time and all at once
+		std::vector<std::string> queries =
+			MakeQueries(options.log, options.query_count);
+		int64_t checksum = 0; //sum of every answer, so no lookup is skipped
+		seconds = FastestRun(options.repeat, [&]() {
+			for (const std::string& query : queries) {
+				checksum += engine.ItemFrequency(query);
+			}
+		});
+		results.push_back({"lookup", "native", 1, options.repeat, seconds, 0,
+			               queries.size()});
+		std::vector<std::string_view> names(queries.begin(), queries.end());
+		std::vector<int64_t> answers;
+		seconds = FastestRun(options.repeat, [&]() {
+			engine.ItemFrequencies(names, answers);
+		});
+		results.push_back({"batch_lookup", "native", 1, options.repeat,
+			               seconds, 0, queries.size()});
+
+		/*the search index built over every item, then the same names
+		* matched ignoring case, and their first three letters searched for
+		* the first 10 items with a word starting that way*/
+		ItemSearchIndex search_index;
+		seconds = FastestRun(options.repeat, [&]() {
+			search_index.Build(engine.Items());
+		});
+		results.push_back({"search_build", "native", 1, options.repeat,
+			               seconds, 0, engine.Items().size()});
+		std::vector<uint32_t> matches;
+		std::size_t match_count = 0; //so no search is skipped either
+		seconds = FastestRun(options.repeat, [&]() {
+			for (const std::string& query : queries) {
+				search_index.FindExact(query, matches);
+				match_count += matches.size();
+			}
+		});
+		results.push_back({"search_exact", "native", 1, options.repeat,
+			               seconds, 0, queries.size()});
+		seconds = FastestRun(options.repeat, [&]() {
+			for (const std::string& query : queries) {
+				search_index.Search(std::string_view(query).substr(0, 3), 10,
+					                matches);
+				match_count += matches.size();
+			}
+		});
+		results.push_back({"search_prefix", "native", 1, options.repeat,
+			               seconds, 0, queries.size()});
+		if (match_count == 0) {
+			std::cerr << "No search matched an item" << std::endl;
+		}
+
+		/*counting and lookups from many threads at once, into a table they
+		* all share, lock-free and then behind a mutex*/
+		unsigned shared_threads = std::max(2u, parallel_threads);
+		RunConcurrentStages<ConcurrentCountTable>("lock_free", log,
+			shared_threads, options.repeat, line_count, queries, engine,
+			results);
+		RunConcurrentStages<MutexCountMap>("mutex_map", log, shared_threads,
+			options.repeat, line_count, queries, engine, results);
+
+		/*the counts copied into a snapshot for the query server, then the
+		* same names asked for one "item" query at a time and answered the
+		* way the server answers them, sockets aside*/
+		SnapshotPublisher snapshots;
+		seconds = FastestRun(options.repeat, [&]() {
+			snapshots.Publish(engine.Items());
+		});
+		results.push_back({"snapshot_publish", "native", 1, options.repeat,
+			               seconds, 0, engine.Items().size()});
+		std::string query_line; //"item <name>"
+		std::string answer; //JSON lines, cleared for every query
+		seconds = FastestRun(options.repeat, [&]() {
+			for (const std::string& query : queries) {
+				query_line.assign("item ").append(query);
+				answer.clear();
+				AnswerQuery(snapshots.Current().get(), query_line, answer);
+			}
+		});
+		results.push_back({"serve_item", "native", 1, options.repeat,
+			               seconds, 0, queries.size()});
+
+		/*what one timed stage costs with metrics compiled in (the class is
+		* there either way): two clock reads and a histogram update*/
+		const uint64_t kTimedCalls = 1000000;
+		seconds = FastestRun(options.repeat, [&]() {
+			for (uint64_t call = 0; call < kTimedCalls; ++call) {
+				ScopedMetricTimer timer(MetricStage::kLookup);
+			}
+		});
+		MetricsRegistry::Global().stage(MetricStage::kLookup).Reset();
+		results.push_back({"metrics_timer", "native", 1, options.repeat,
+			               seconds, 0, kTimedCalls});
+
+		//frequency files, written and read back in both formats
+		uint32_t item_count = engine.Items().size();
+		seconds = FastestRun(options.repeat, [&]() {
+			engine.WriteFrequencyFile(text_file, FrequencyFileFormat::kText);
+		});
+		results.push_back({"write_text", "native", 1, options.repeat, seconds,
+			               MappedFile(text_file).size(), item_count});
+		seconds = FastestRun(options.repeat, [&]() {
+			engine.WriteFrequencyFile(binary_file,
+				                      FrequencyFileFormat::kBinary);
+		});
+		results.push_back({"write_binary", "native", 1, options.repeat,
+			               seconds, MappedFile(binary_file).size(),
+			               item_count});
+		FrequencyEngine reader;
+		seconds = FastestRun(options.repeat, [&]() {
+			reader.Clear();
+			reader.CountFrequencyFile(text_file);
+		});
+		results.push_back({"read_text", "native", 1, options.repeat, seconds,
+			               MappedFile(text_file).size(), item_count});
+		int64_t binary_total = 0;
+		seconds = FastestRun(options.repeat, [&]() {
+			FrequencyFileView view(binary_file);
+			binary_total = 0;
+			for (uint32_t row = 0; row < view.size(); ++row) {
+				binary_total += view.Count(row);
+			}
+		});
+		results.push_back({"read_binary", "native", 1, options.repeat,
+			               seconds, MappedFile(binary_file).size(),
+			               item_count});
+		if (reader.TotalUnits() != engine.TotalUnits() ||
+			binary_total != engine.TotalUnits()) {
+			std::cerr << "Frequency files didn't read back the same totals"
+				<< std::endl;
+		}
+
+		/*a snapshot saved, then loaded the way a restart would, to set
+		* against recounting the whole log with the ingest stage*/
+		FrequencyEngine followed;
+		LogFollower follower(log_file, followed);
+		follower.Poll();
+		seconds = FastestRun(options.repeat, [&]() {
+			WriteCheckpoint(checkpoint_file, followed, follower);
+		});
+		results.push_back({"checkpoint_write", "native", 1, options.repeat,
+			               seconds, MappedFile(checkpoint_file).size(),
+			               item_count});
+		FrequencyEngine restored;
+		uint64_t resume_offset = 0;
+		seconds = FastestRun(options.repeat, [&]() {
+			LoadCheckpoint(checkpoint_file, log_file, restored,
+				           resume_offset);
+		});
+		results.push_back({"checkpoint_load", "native", 1, options.repeat,
+			               seconds, MappedFile(checkpoint_file).size(),
+			               item_count});
+		if (restored.TotalUnits() != engine.TotalUnits() ||
+			resume_offset != log_bytes) {
+			std::cerr << "The snapshot didn't load back the same counts"
+				<< std::endl;
+		}
+
+		/*90 days of the same counts recorded in a history, then opened and
+		* asked what the history options ask: each query over every day, the
+		* day totals, and the movers on the last day*/
+		const int64_t kHistoryDays = 90;
+		std::remove(history_file.c_str()); //appended to, so start afresh
+		auto history_start = std::chrono::steady_clock::now();
+		for (int64_t day = 0; day < kHistoryDays; ++day) {
+			AppendHistoryDay(history_file, day, engine.Items());
+		}
+		std::chrono::duration<double> history_elapsed =
+			std::chrono::steady_clock::now() - history_start;
+		results.push_back({"history_append", "native", 1, 1,
+			               history_elapsed.count(),
+			               MappedFile(history_file).size(), kHistoryDays});
+		std::vector<HistoryPoint> points;
+		std::vector<HistoryMover> movers;
+		int64_t history_total = 0; //every item's units, on the last day
+		seconds = FastestRun(options.repeat, [&]() {
+			HistoryStore history(history_file);
+			for (const std::string& query : queries) {
+				uint32_t id = history.Find(query);
+				if (id == ItemDictionary::kNotFound) { continue; }
+				history.ItemHistory(id, 0, kHistoryDays - 1, points);
+				checksum += points.back().count;
+			}
+			history.DayTotals(0, kHistoryDays - 1, points);
+			history_total = points.back().count;
+			history.TopMovers(kHistoryDays - 1, 10, movers);
+		});
+		results.push_back({"history_query", "native", 1, options.repeat,
+			               seconds, MappedFile(history_file).size(),
+			               queries.size()});
+		if (history_total != engine.TotalUnits() || !movers.empty()) {
+			std::cerr << "The history didn't read back the same counts"
+				<< std::endl;
+		}
+
+		/*the whole table charted best sellers first, then just the top 20:
+		* both scaled to chart_width, with one renderer so the second chart
+		* reuses the first one's buffer*/
+		HistogramOptions chart_options;
+		chart_options.width = options.chart_width;
+		chart_options.order = HistogramOrder::kCountDescending;
+		HistogramRenderer renderer(chart_options);
+		std::size_t chart_bytes = 0;
+		seconds = FastestRun(options.repeat, [&]() {
+			chart_bytes = renderer.Render(engine.Items()).size();
+		});
+		results.push_back({"histogram", "native", 1, options.repeat, seconds,
+			               chart_bytes, item_count});
+		chart_options.top = 20;
+		renderer.set_options(chart_options);
+		seconds = FastestRun(options.repeat, [&]() {
+			chart_bytes = renderer.Render(engine.Items()).size();
+		});
+		results.push_back({"histogram_top", "native", 1, options.repeat,
+			               seconds, chart_bytes, renderer.row_count()});
+
+		/*the top 20 through the bounded heap, against sorting every item
+		* and keeping the first 20, the way an external sort would*/
+		std::vector<uint32_t> ranked_ids;
+		seconds = FastestRun(options.repeat, [&]() {
+			RankItems(engine.Items(), 20, true, ranked_ids);
+		});
+		results.push_back({"rank_top", "native", 1, options.repeat, seconds,
+			               0, item_count});
+		seconds = FastestRun(options.repeat, [&]() {
+			ranked_ids.resize(item_count);
+			std::iota(ranked_ids.begin(), ranked_ids.end(), 0);
+			const FrequencyTable& items = engine.Items();
+			std::sort(ranked_ids.begin(), ranked_ids.end(),
+				      [&items](uint32_t a, uint32_t b) {
+				return RanksBefore(items, true, a, b);
+			});
+			ranked_ids.resize(20);
+		});
+		results.push_back({"rank_top_full_sort", "native", 1, options.repeat,
+			               seconds, 0, item_count});
+
+		/*the same log estimated in fixed memory, and the same lookups
+		* answered from the sketch, which must never be below the exact
+		* counts*/
+		SketchEngine sketch;
+		for (unsigned threads : ingest_threads) {
+			sketch.set_thread_count(threads);
+			seconds = FastestRun(options.repeat, [&]() {
+				sketch.Clear();
+				sketch.CountFile(log_file);
+			});
+			results.push_back({"ingest", "approximate", threads,
+				               options.repeat, seconds, log_bytes,
+				               line_count});
+		}
+		std::vector<int64_t> estimates;
+		seconds = FastestRun(options.repeat, [&]() {
+			sketch.ItemFrequencies(names, estimates);
+		});
+		results.push_back({"batch_lookup", "approximate", 1, options.repeat,
+			               seconds, 0, queries.size()});
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			if (estimates[i] < answers[i]) {
+				std::cerr << "Approximate count of " << queries[i]
+					<< " is below the exact count" << std::endl;
+				break;
+			}
+		}
+
+		if (checksum == 0 || answers.size() != queries.size()) {
+			std::cerr << "No native lookup found an item" << std::endl;
+		}
+		if (options.run_python) {
+			RunPythonStages(options, log_file, python_file, queries, engine,
+				            results);
+		}
+	}
+	catch (std::runtime_error& error) { //a file couldn't be read or written
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	//everything in one JSON document
+	std::string json = "{\n  \"benchmark\": \"CornerGrocer\",\n";
+	json.append("  \"format_version\": 1,\n  \"scanner\": ");
+	AppendJsonString(json, ScannerInstructionSet());
+	json.append(",\n  \"hardware_threads\": ");
+	uint64_t hardware_threads = std::thread::hardware_concurrency();
+	AppendJsonNumber(json, hardware_threads);
+	json.append(",\n  \"log\": {\"file\": ");
+	AppendJsonString(json, log_file);
+	json.append(", \"generated\": ");
+	json.append(options.log_file.empty() ? "true" : "false");
+	json.append(", \"lines\": ");
+	AppendJsonNumber(json, line_count);
+	json.append(", \"items\": ");
+	AppendJsonNumber(json, static_cast<uint64_t>(options.log.item_count));
+	json.append(", \"skew\": ");
+	AppendJsonNumber(json, options.log.skew);
+	json.append(", \"seed\": ");
+	AppendJsonNumber(json, options.log.seed);
+	json.append("},\n  \"results\": [\n");
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		AppendJsonResult(json, results[i]);
+		json.append(i + 1 < results.size() ? ",\n" : "\n");
+	}
+	json.append("  ]\n}\n");
+
+	if (options.output_file == "-") {
+		std::fwrite(json.data(), 1, json.size(), stdout);
+	}
+	else {
+		std::FILE* output = std::fopen(options.output_file.c_str(), "wb");
+		if (output == nullptr) {
+			std::cerr << "Error creating File: " << options.output_file
+				<< std::endl;
+			return 1;
+		}
+		std::fwrite(json.data(), 1, json.size(), output);
+		std::fclose(output);
+		std::cout << "Wrote " << results.size() << " results to "
+			<< options.output_file << std::endl;
+	}
+
+	if (!options.keep_files) { //generated files are only needed while timing
+		if (options.log_file.empty()) { std::remove(log_file.c_str()); }
+		std::remove(text_file.c_str());
+		std::remove(binary_file.c_str());
+		std::remove(python_file.c_str());
+		std::remove(checkpoint_file.c_str());
+		std::remove(history_file.c_str());
+		std::remove(gzip_file.c_str());
+		std::remove(priced_file.c_str());
+		std::remove(timed_file.c_str());
+		std::remove((checkpoint_file + ".1").c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,348 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Checkpoint definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "checkpoint.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+//first eight bytes of every snapshot
+const char kMagic[8] = {'C', 'G', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+//most bytes fingerprinted at each end of the part of the log counted
+const uint64_t kFingerprintBytes = 64 * 1024;
+
+//rounds size up to the next multiple of 8, so every section is aligned
+uint64_t AlignTo8(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+//appends the raw bytes of an array to buffer
+template <typename T>
+void AppendArray(std::string& buffer, const T* values, std::size_t count) {
+	buffer.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+/*copies count values from data into values and moves data past them.
+* Returns false, copying nothing, if there aren't that many bytes left.*/
+template <typename T>
+bool ReadArray(const char*& data, const char* end, T* values,
+	           std::size_t count) {
+	if (static_cast<std::size_t>(end - data) / sizeof(T) < count) {
+		return false;
+	}
+	std::memcpy(values, data, count * sizeof(T));
+	data += count * sizeof(T);
+	return true;
+}
+
+//CRC32 of the log's first head_bytes and of the tail_bytes before offset
+void FingerprintInput(const MappedFile& input, uint64_t offset,
+	                  uint64_t head_bytes, uint64_t tail_bytes,
+	                  uint32_t& head_crc, uint32_t& tail_crc) {
+	head_crc = Crc32(input.data(), static_cast<std::size_t>(head_bytes));
+	tail_crc = Crc32(input.data() + (offset - tail_bytes),
+		             static_cast<std::size_t>(tail_bytes));
+}
+
+#ifdef _WIN32
+/*writes contents to file_name, replacing it, and returns once it is on the
+* disk rather than only in the cache*/
+void WriteDurably(const std::string& file_name, const std::string& contents) {
+	HANDLE file = CreateFileA(file_name.c_str(), GENERIC_WRITE, 0, NULL,
+		                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	std::size_t written = 0;
+	while (written < contents.size()) {
+		DWORD wrote = 0;
+		DWORD wanted = static_cast<DWORD>(std::min<std::size_t>(
+			contents.size() - written, 1 << 30));
+		if (!WriteFile(file, contents.data() + written, wanted, &wrote,
+			           NULL)) {
+			break;
+		}
+		written += wrote;
+	}
+	bool flushed = FlushFileBuffers(file) != 0;
+	CloseHandle(file);
+	if (written != contents.size() || !flushed) {
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+}
+
+/*renames from to to, replacing to. Returns false if from doesn't exist,
+* throws if it exists but couldn't be renamed.*/
+bool RenameOver(const std::string& from, const std::string& to) {
+	if (MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING |
+		            MOVEFILE_WRITE_THROUGH)) {
+		return true;
+	}
+	if (GetLastError() == ERROR_FILE_NOT_FOUND) { return false; }
+	throw std::runtime_error("Error renaming File: " + from);
+}
+
+//MOVEFILE_WRITE_THROUGH already waited for the rename to reach the disk
+void SyncDirectoryOf(const std::string&) {}
+#else
+void WriteDurably(const std::string& file_name, const std::string& contents) {
+	int descriptor = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+		                  0644);
+	if (descriptor == -1) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	std::size_t written = 0;
+	while (written < contents.size()) {
+		ssize_t wrote = write(descriptor, contents.data() + written,
+			                  contents.size() - written);
+		if (wrote < 0 && errno == EINTR) { continue; } //interrupted, again
+		if (wrote <= 0) { break; }
+		written += static_cast<std::size_t>(wrote);
+	}
+	bool flushed = fsync(descriptor) == 0;
+	close(descriptor);
+	if (written != contents.size() || !flushed) {
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+}
+
+bool RenameOver(const std::string& from, const std::string& to) {
+	if (rename(from.c_str(), to.c_str()) == 0) { return true; }
+	if (errno == ENOENT) { return false; }
+	throw std::runtime_error("Error renaming File: " + from);
+}
+
+/*a rename is only on the disk once the directory holding it is, so the
+* directory is synced too. Failing to is no worse than not trying.*/
+void SyncDirectoryOf(const std::string& file_name) {
+	std::size_t slash = file_name.rfind('/');
+	std::string directory = slash == std::string::npos ? "." :
+		file_name.substr(0, slash + 1);
+	int descriptor = open(directory.c_str(), O_RDONLY);
+	if (descriptor == -1) { return; }
+	fsync(descriptor);
+	close(descriptor);
+}
+#endif
+
+/*loads the snapshot in file_name, checking every checksum and the log's
+* fingerprints before engine is touched*/
+bool LoadSnapshot(const std::string& file_name,
+	              const std::string& input_file, FrequencyEngine& engine,
+	              uint64_t& input_offset) {
+	try {
+		MappedFile snapshot(file_name);
+		CheckpointHeader header;
+		if (snapshot.size() < sizeof(header)) { return false; }
+		std::memcpy(&header, snapshot.data(), sizeof(header));
+		uint32_t header_crc = header.header_crc;
+		header.header_crc = 0;
+		const char* payload = snapshot.data() + sizeof(header);
+		if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+			header.version < 1 || header.version > kCheckpointVersion ||
+			Crc32(reinterpret_cast<const char*>(&header), sizeof(header)) !=
+			header_crc ||
+			header.payload_bytes != snapshot.size() - sizeof(header) ||
+			Crc32(payload, static_cast<std::size_t>(header.payload_bytes)) !=
+			header.payload_crc) {
+			return false; //not a snapshot, or a damaged one
+		}
+
+		MappedFile input(input_file);
+		uint32_t head_crc = 0;
+		uint32_t tail_crc = 0;
+		if (input.size() < header.input_offset ||
+			header.head_bytes > header.input_offset ||
+			header.tail_bytes > header.input_offset) {
+			return false; //the log is shorter than what was counted
+		}
+		FingerprintInput(input, header.input_offset, header.head_bytes,
+			             header.tail_bytes, head_crc, tail_crc);
+		if (head_crc != header.head_crc || tail_crc != header.tail_crc) {
+			return false; //a different log
+		}
+
+		//every item needs at least its size and count, so check before sizing
+		const char* at = payload;
+		const char* end = payload + header.payload_bytes;
+		if (header.item_count > header.payload_bytes / 12) { return false; }
+		std::vector<uint32_t> name_sizes(
+			static_cast<std::size_t>(header.item_count));
+		if (!ReadArray(at, end, name_sizes.data(), name_sizes.size())) {
+			return false;
+		}
+		const char* names = at;
+		uint64_t names_bytes = 0;
+		for (uint32_t name_size : name_sizes) { names_bytes += name_size; }
+		uint64_t counts_offset = AlignTo8(names - snapshot.data() +
+			                              names_bytes);
+		if (counts_offset > snapshot.size()) { return false; }
+		at = snapshot.data() + counts_offset;
+		std::vector<int64_t> counts(name_sizes.size());
+		if (!ReadArray(at, end, counts.data(), counts.size())) {
+			return false;
+		}
+		std::vector<int64_t> revenue; //stays empty without the flag
+		if ((header.flags & kCheckpointHasRevenue) != 0) {
+			revenue.resize(name_sizes.size());
+			if (!ReadArray(at, end, revenue.data(), revenue.size())) {
+				return false;
+			}
+		}
+
+		/*buckets saved with other options, or as 32 bit counts before
+		* version 3, can't be carried on with, and without saved buckets the
+		* history before the snapshot is lost*/
+		TimeWindowCounter* windows = engine.time_windows();
+		bool has_windows = (header.flags & kCheckpointHasWindows) != 0;
+		TimeWindowCounter restored_windows(
+			windows != nullptr ? windows->options() : TimeWindowOptions());
+		if (windows != nullptr && (!has_windows || header.version < 3 ||
+			!restored_windows.ReadState(at, end))) {
+			return false;
+		}
+
+		engine.Clear();
+		for (std::size_t id = 0; id < name_sizes.size(); ++id) {
+			engine.Add(std::string_view(names, name_sizes[id]), counts[id],
+				       revenue.empty() ? 0 : revenue[id]);
+			names += name_sizes[id];
+		}
+		if (windows != nullptr) { *windows = std::move(restored_windows); }
+		input_offset = header.input_offset;
+		return true;
+	}
+	catch (std::runtime_error&) { //the snapshot or the log is missing
+		return false;
+	}
+}
+}  // namespace
+
+/*the byte at a time table method: one lookup per byte, with the table made
+* the first time it is needed*/
+uint32_t Crc32(const char* data, std::size_t size, uint32_t crc) {
+	static const std::array<uint32_t, 256> table = []() {
+		std::array<uint32_t, 256> entries = {};
+		for (uint32_t byte = 0; byte < 256; ++byte) {
+			uint32_t entry = byte;
+			for (int bit = 0; bit < 8; ++bit) {
+				entry = (entry & 1) != 0 ? 0xEDB88320u ^ (entry >> 1) :
+					entry >> 1;
+			}
+			entries[byte] = entry;
+		}
+		return entries;
+	}();
+	crc = ~crc;
+	for (std::size_t i = 0; i < size; ++i) {
+		crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^
+			(crc >> 8);
+	}
+	return ~crc;
+}
+
+/*the snapshot is laid out in a string like the binary frequency file:
+* header space first, filled in last once the payload's checksum is known*/
+void WriteCheckpoint(const std::string& file_name,
+	                 const FrequencyEngine& engine,
+	                 const LogFollower& follower) {
+	CheckpointHeader header = {};
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kCheckpointVersion;
+	header.input_offset = follower.offset();
+	{
+		MappedFile input(follower.file_name());
+		if (input.size() < header.input_offset) {
+			throw std::runtime_error("Log shrank while being saved: " +
+				                     follower.file_name());
+		}
+		header.head_bytes = std::min(header.input_offset, kFingerprintBytes);
+		header.tail_bytes = header.head_bytes;
+		FingerprintInput(input, header.input_offset, header.head_bytes,
+			             header.tail_bytes, header.head_crc,
+			             header.tail_crc);
+	}
+
+	/*an item only the unfinished line has named is left out altogether,
+	* it is the last one*/
+	const FrequencyTable& items = engine.Items();
+	uint32_t item_count = items.size() - (follower.provisional_added() ? 1 : 0);
+	header.item_count = item_count;
+	std::string buffer(sizeof(header), '\0'); //room for the header
+	for (uint32_t id = 0; id < item_count; ++id) {
+		uint32_t name_size = static_cast<uint32_t>(items.Name(id).size());
+		AppendArray(buffer, &name_size, 1);
+	}
+	for (uint32_t id = 0; id < item_count; ++id) {
+		buffer.append(items.Name(id).data(), items.Name(id).size());
+	}
+	buffer.resize(AlignTo8(buffer.size()), '\0');
+
+	//the unfinished line will be read again, so it mustn't be counted here
+	uint32_t provisional_id = follower.provisional().empty() ?
+		ItemDictionary::kNotFound : items.Find(follower.provisional());
+	for (uint32_t id = 0; id < item_count; ++id) {
+		int64_t count = items.Count(id) -
+			(id == provisional_id ? follower.provisional_quantity() : 0);
+		AppendArray(buffer, &count, 1);
+	}
+	if (items.has_revenue()) {
+		header.flags |= kCheckpointHasRevenue;
+		for (uint32_t id = 0; id < item_count; ++id) {
+			int64_t cents = items.Revenue(id) -
+				(id == provisional_id ? follower.provisional_revenue() : 0);
+			AppendArray(buffer, &cents, 1);
+		}
+	}
+	if (engine.time_windows() != nullptr) {
+		header.flags |= kCheckpointHasWindows;
+		engine.time_windows()->AppendState(buffer);
+	}
+
+	header.payload_bytes = buffer.size() - sizeof(header);
+	header.payload_crc = Crc32(buffer.data() + sizeof(header),
+		                       buffer.size() - sizeof(header));
+	header.header_crc = Crc32(reinterpret_cast<const char*>(&header),
+		                      sizeof(header));
+	std::memcpy(&buffer[0], &header, sizeof(header));
+
+	//the new snapshot is whole on the disk before anything is renamed
+	std::string temporary_name = file_name + ".tmp";
+	WriteDurably(temporary_name, buffer);
+	RenameOver(file_name, file_name + ".1"); //no old snapshot the first time
+	if (!RenameOver(temporary_name, file_name)) {
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+	SyncDirectoryOf(file_name);
+}
+
+bool LoadCheckpoint(const std::string& file_name,
+	                const std::string& input_file, FrequencyEngine& engine,
+	                uint64_t& input_offset) {
+	return LoadSnapshot(file_name, input_file, engine, input_offset) ||
+		LoadSnapshot(file_name + ".1", input_file, engine, input_offset);
+}
@@ -0,0 +1,98 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Checkpoint header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "frequency_engine.h"
+#include "log_follower.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* This file saves counts to a snapshot file, so a restart can load them and
+* read only the sales logged since, instead of recounting a log of many
+* gigabytes. A snapshot is laid out like this:
+*
+*   header       CheckpointHeader, 72 bytes
+*   name sizes   uint32_t[item_count], in ID order
+*   names        every name's characters, back to back, padded to 8 bytes
+*   counts       int64_t[item_count], in ID order
+*   revenue      int64_t[item_count] in cents, in ID order, if its flag is
+*                set (see sales_record.h)
+*   windows      TimeWindowCounter::AppendState, if its flag is set
+*
+* Items are kept in ID order, so a restored table lists items in the order
+* they were first seen, just like counting the log again would.
+*
+* The header records how far into the log the counts go, and CRC32s of the
+* log's first bytes and of the bytes just before that offset, so a log that
+* was replaced, rotated or cut shorter since isn't resumed in the wrong
+* place. The header and everything after it are checksummed as well.
+*
+* Snapshots are written to "<file>.tmp", flushed to disk, and only then
+* renamed over the old snapshot, which is kept as "<file>.1". A crash at any
+* point leaves either the old snapshot or the new one, never half of one,
+* and a snapshot that is damaged anyway is ignored in favour of "<file>.1",
+* then of recounting the log. Numbers are stored in the byte order of the
+* machine that wrote them, like the binary frequency file. */
+
+//the fixed size block at the start of every snapshot
+struct CheckpointHeader {
+	char magic[8]; //"CGSNAP" followed by two zero bytes
+	uint32_t version; //kCheckpointVersion when written
+	uint32_t flags; //kCheckpointHas... bits for what follows the counts
+	uint64_t input_offset; //bytes of the log the counts cover
+	uint64_t head_bytes; //bytes at the start of the log fingerprinted
+	uint64_t tail_bytes; //bytes just before input_offset fingerprinted
+	uint32_t head_crc; //CRC32 of the head bytes
+	uint32_t tail_crc; //CRC32 of the tail bytes
+	uint64_t item_count; //number of items
+	uint64_t payload_bytes; //bytes after the header
+	uint32_t payload_crc; //CRC32 of those bytes
+	uint32_t header_crc; //CRC32 of the header, with this field zero
+};
+
+/*current version of the format, bumped whenever the layout changes.
+* Version 1 snapshots are the same without revenue, and versions 1 and 2
+* saved time buckets as 32 bit counts. Both are still read, except that
+* their time buckets aren't, so they're only resumed from without windows.*/
+const uint32_t kCheckpointVersion = 3;
+
+//flag bits set in CheckpointHeader::flags when time buckets, or revenue,
+//are saved
+const uint32_t kCheckpointHasWindows = 1;
+const uint32_t kCheckpointHasRevenue = 2;
+
+/*CRC32 (the zlib and PNG polynomial) of size bytes at data. Pass a
+* previous result as crc to carry on over more bytes.*/
+uint32_t Crc32(const char* data, std::size_t size, uint32_t crc = 0);
+
+/*Saves engine's counts and time buckets, without the provisional count of
+* a line follower hasn't finished reading, as a snapshot of the log up to
+* follower.offset(). The snapshot replaces file_name as described above.
+* Throws std::runtime_error if the log can't be read or the snapshot can't
+* be written, leaving any older snapshot as it was. */
+void WriteCheckpoint(const std::string& file_name,
+	                 const FrequencyEngine& engine,
+	                 const LogFollower& follower);
+
+/*Replaces engine's counts with the newest valid snapshot of input_file,
+* file_name or failing that "<file_name>.1", and sets input_offset to where
+* reading should carry on. Returns false and leaves engine alone if there
+* is no snapshot, or it is damaged, or the log no longer matches it, or
+* engine keeps time buckets with options the snapshot wasn't saved with.*/
+bool LoadCheckpoint(const std::string& file_name,
+	                const std::string& input_file, FrequencyEngine& engine,
+	                uint64_t& input_offset);
+#endif
@@ -0,0 +1,351 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Compressed Input definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "compressed_input.h"
+#include "metrics.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+#ifdef CORNER_GROCER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CORNER_GROCER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+//most output asked of the library at once, well inside its int sizes
+const std::size_t kDecodeStepBytes = 256 * 1024;
+
+//thrown for a file that ends part way through a member, see cut_short
+class TruncatedError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/*one compressed stream, from a position in the mapping to its end, turned
+* back into text a step at a time. Members or frames that follow one
+* another are decoded as one stream.*/
+class StreamDecoder {
+public:
+	StreamDecoder(InputCompression compression, const char* begin,
+		          const char* end, const std::string& file_name);
+	~StreamDecoder();
+	StreamDecoder(const StreamDecoder&) = delete;
+	StreamDecoder& operator=(const StreamDecoder&) = delete;
+
+	/*decodes up to capacity bytes into out and returns how many, which is
+	* 0 only once finished() is true. Throws if the data is damaged or
+	* ends part way through a member.*/
+	std::size_t Decode(char* out, std::size_t capacity);
+
+	//true once every member has been decoded
+	bool finished() const { return finished_; }
+
+	//compressed bytes decoded so far
+	uint64_t consumed() const { return consumed_; }
+
+private:
+	//throw the errors for data that ends part way through, or is damaged
+	[[noreturn]] void Truncated() const;
+	[[noreturn]] void Damaged() const;
+
+	InputCompression compression_; //which library decodes
+	const char* begin_; //the compressed bytes left to hand the library
+	const char* end_; //end of the compressed bytes
+	std::string file_name_; //for error messages
+	bool finished_ = false; //see finished
+	bool mid_member_ = false; //a member was started but hasn't ended
+	uint64_t consumed_ = 0; //see consumed
+#ifdef CORNER_GROCER_HAVE_ZLIB
+	z_stream gzip_ = {}; //zlib's state, for gzip
+#endif
+#ifdef CORNER_GROCER_HAVE_ZSTD
+	ZSTD_DStream* zstd_ = nullptr; //libzstd's state, for zstd
+#endif
+};
+
+/*16 + MAX_WBITS makes zlib expect a gzip header and trailer rather than
+* zlib's own*/
+StreamDecoder::StreamDecoder(InputCompression compression, const char* begin,
+	                         const char* end, const std::string& file_name)
+	: compression_(compression), begin_(begin), end_(end),
+	  file_name_(file_name) {
+#ifdef CORNER_GROCER_HAVE_ZLIB
+	if (compression_ == InputCompression::kGzip &&
+		inflateInit2(&gzip_, 16 + MAX_WBITS) != Z_OK) {
+		throw std::runtime_error("Error decompressing File: " + file_name_);
+	}
+#endif
+#ifdef CORNER_GROCER_HAVE_ZSTD
+	if (compression_ == InputCompression::kZstd) {
+		zstd_ = ZSTD_createDStream();
+		if (zstd_ == nullptr || ZSTD_isError(ZSTD_initDStream(zstd_))) {
+			ZSTD_freeDStream(zstd_);
+			throw std::runtime_error("Error decompressing File: " +
+				                     file_name_);
+		}
+	}
+#endif
+}
+
+StreamDecoder::~StreamDecoder() {
+#ifdef CORNER_GROCER_HAVE_ZLIB
+	if (compression_ == InputCompression::kGzip) { inflateEnd(&gzip_); }
+#endif
+#ifdef CORNER_GROCER_HAVE_ZSTD
+	ZSTD_freeDStream(zstd_);
+#endif
+}
+
+#if defined(CORNER_GROCER_HAVE_ZLIB) || defined(CORNER_GROCER_HAVE_ZSTD)
+void StreamDecoder::Truncated() const {
+	throw TruncatedError("Truncated compressed File: " + file_name_);
+}
+
+void StreamDecoder::Damaged() const {
+	throw std::runtime_error("Damaged compressed File: " + file_name_);
+}
+#endif
+
+/*zlib is handed at most a step of input at a time, as its sizes are
+* unsigned ints. At the end of a member it is reset for the next one, if
+* there are more bytes; input that runs out inside a member is an error,
+* since the rest of that member's lines are missing. Built with neither
+* library, there is nothing to decode and out is never written.*/
+std::size_t StreamDecoder::Decode([[maybe_unused]] char* out,
+	                              [[maybe_unused]] std::size_t capacity) {
+	std::size_t produced = 0;
+#ifdef CORNER_GROCER_HAVE_ZLIB
+	if (compression_ == InputCompression::kGzip) {
+		gzip_.next_out = reinterpret_cast<Bytef*>(out);
+		gzip_.avail_out = static_cast<uInt>(std::min(capacity,
+			                                         kDecodeStepBytes));
+		while (gzip_.avail_out != 0 && !finished_) {
+			if (gzip_.avail_in == 0) {
+				if (begin_ == end_) {
+					if (mid_member_) { Truncated(); }
+					finished_ = true;
+					break;
+				}
+				std::size_t step = std::min<std::size_t>(end_ - begin_,
+					                                     kDecodeStepBytes);
+				gzip_.next_in = reinterpret_cast<Bytef*>(
+					const_cast<char*>(begin_));
+				gzip_.avail_in = static_cast<uInt>(step);
+				begin_ += step;
+			}
+			mid_member_ = true;
+			uInt had = gzip_.avail_in;
+			int status = inflate(&gzip_, Z_NO_FLUSH);
+			consumed_ += had - gzip_.avail_in;
+			if (status == Z_STREAM_END) {
+				mid_member_ = false;
+				if (gzip_.avail_in != 0 || begin_ != end_) {
+					inflateReset(&gzip_); //another member follows
+				}
+			}
+			else if (status != Z_OK && status != Z_BUF_ERROR) {
+				Damaged();
+			}
+		}
+		produced = reinterpret_cast<char*>(gzip_.next_out) - out;
+	}
+#endif
+#ifdef CORNER_GROCER_HAVE_ZSTD
+	/*ZSTD_decompressStream returns 0 exactly when a frame is done and
+	* every byte of it has been handed out*/
+	if (compression_ == InputCompression::kZstd) {
+		ZSTD_outBuffer output = {out, capacity, 0};
+		while (output.pos < output.size && !finished_) {
+			if (begin_ == end_ && !mid_member_) {
+				finished_ = true;
+				break;
+			}
+			std::size_t step = std::min<std::size_t>(end_ - begin_,
+				                                     kDecodeStepBytes);
+			ZSTD_inBuffer input = {begin_, step, 0};
+			std::size_t had = output.pos; //to tell whether anything came out
+			std::size_t hint = ZSTD_decompressStream(zstd_, &output, &input);
+			if (ZSTD_isError(hint)) { Damaged(); }
+			begin_ += input.pos;
+			consumed_ += input.pos;
+			mid_member_ = hint != 0;
+			if (mid_member_ && input.pos == 0 && begin_ == end_ &&
+				output.pos == had) {
+				Truncated(); //wants more input, and there is none
+			}
+		}
+		produced = output.pos;
+	}
+#endif
+	return produced;
+}
+}  // namespace
+
+InputCompression DetectCompression(const char* data, std::size_t size) {
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+	if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+		return InputCompression::kGzip;
+	}
+	if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 &&
+		bytes[2] == 0x2f && bytes[3] == 0xfd) {
+		return InputCompression::kZstd;
+	}
+	return InputCompression::kNone;
+}
+
+const char* CompressionName(InputCompression compression) {
+	switch (compression) {
+	case InputCompression::kGzip: return "gzip";
+	case InputCompression::kZstd: return "zstd";
+	default: return "none";
+	}
+}
+
+bool CompressionSupported(InputCompression compression) {
+	switch (compression) {
+#ifdef CORNER_GROCER_HAVE_ZLIB
+	case InputCompression::kGzip: return true;
+#endif
+#ifdef CORNER_GROCER_HAVE_ZSTD
+	case InputCompression::kZstd: return true;
+#endif
+	default: return false;
+	}
+}
+
+/*the format is checked here, on the caller's thread, so a file that can't
+* be read fails straight away instead of from the first Next*/
+DecompressingReader::DecompressingReader(const std::string& file_name,
+	                                     uint64_t start,
+	                                     std::size_t buffer_bytes,
+	                                     std::size_t buffer_count)
+	: file_(file_name), file_name_(file_name),
+	  start_(std::min<uint64_t>(start, file_.size())),
+	  compression_(DetectCompression(file_.data() + start_,
+		                             file_.size() - start_)),
+	  buffer_bytes_(std::max<std::size_t>(buffer_bytes, 1)),
+	  buffers_(std::max<std::size_t>(buffer_count, 1)) {
+	if (compression_ == InputCompression::kNone && start_ != file_.size()) {
+		throw std::runtime_error("Not a compressed File: " + file_name);
+	}
+	if (compression_ != InputCompression::kNone &&
+		!CompressionSupported(compression_)) {
+		throw std::runtime_error(std::string("Built without ") +
+			                     CompressionName(compression_) +
+			                     " support, can't read File: " + file_name);
+	}
+	for (std::size_t i = 0; i < buffers_.size(); ++i) { free_.push_back(i); }
+	thread_ = std::thread(&DecompressingReader::Decompress, this);
+}
+
+DecompressingReader::~DecompressingReader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	buffer_freed_.notify_all();
+	thread_.join();
+}
+
+bool DecompressingReader::Next(std::string_view& lines) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (held_ != SIZE_MAX) { //done with, so it can be filled again
+		free_.push_back(held_);
+		held_ = SIZE_MAX;
+		buffer_freed_.notify_one();
+	}
+	buffer_filled_.wait(lock, [this]() {
+		return !full_.empty() || finished_;
+	});
+	if (full_.empty()) { //finished, and everything was handed out
+		if (!error_.empty()) { throw std::runtime_error(error_); }
+		return false;
+	}
+	held_ = full_.front();
+	full_.pop_front();
+	lines = buffers_[held_];
+	return true;
+}
+
+/*each buffer starts with the unfinished line the last one ended with, then
+* is filled until it holds buffer_bytes_ and a line end, and cut after its
+* last one. A line longer than a buffer simply makes the buffer grow.*/
+void DecompressingReader::Decompress() {
+	std::string carry; //unfinished last line of the buffer before
+	try {
+		if (compression_ == InputCompression::kNone) { //nothing after start
+			std::lock_guard<std::mutex> lock(mutex_);
+			finished_ = true;
+			buffer_filled_.notify_all();
+			return;
+		}
+		StreamDecoder decoder(compression_, file_.data() + start_,
+			                  file_.data() + file_.size(), file_name_);
+		while (!decoder.finished()) {
+			std::size_t index;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				buffer_freed_.wait(lock, [this]() {
+					return !free_.empty() || stopping_;
+				});
+				if (stopping_) { return; }
+				index = free_.front();
+				free_.pop_front();
+			}
+
+			std::string& buffer = buffers_[index];
+			buffer.assign(carry);
+			carry.clear();
+			std::size_t last_newline = std::string::npos;
+			{
+				CORNER_GROCER_TIME_STAGE(kDecompress);
+				while (!decoder.finished() &&
+					   (buffer.size() < buffer_bytes_ ||
+						last_newline == std::string::npos)) {
+					std::size_t filled = buffer.size();
+					buffer.resize(filled + kDecodeStepBytes);
+					std::size_t got = decoder.Decode(&buffer[filled],
+						                             kDecodeStepBytes);
+					buffer.resize(filled + got);
+					//only the new bytes, carry has no line end in it
+					std::size_t newline = std::string_view(buffer).substr(
+						filled).rfind('\n');
+					if (newline != std::string_view::npos) {
+						last_newline = filled + newline;
+					}
+				}
+				consumed_.store(decoder.consumed());
+			}
+			if (!decoder.finished() && last_newline != std::string::npos) {
+				carry.assign(buffer, last_newline + 1, std::string::npos);
+				buffer.resize(last_newline + 1);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			full_.push_back(index);
+			finished_ = decoder.finished();
+			buffer_filled_.notify_one();
+		}
+	}
+	catch (std::runtime_error& error) { //handed to Next, after the rest
+		std::lock_guard<std::mutex> lock(mutex_);
+		error_ = error.what();
+		cut_short_ = dynamic_cast<TruncatedError*>(&error) != nullptr;
+		finished_ = true;
+		buffer_filled_.notify_one();
+	}
+}
@@ -0,0 +1,131 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Compressed Input header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef COMPRESSED_INPUT_H
+#define COMPRESSED_INPUT_H
+#include "mapped_file.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/* This file reads sales logs that were archived compressed, with gzip or
+* zstd, without decompressing them to disk first. Which one a file is, if
+* either, is told from its first bytes, not its name, so every place a log
+* is counted accepts all three kinds.
+*
+* A DecompressingReader decompresses on a thread of its own into a few
+* buffers that are used over and over. Each one is handed to the counter
+* holding only whole lines, while the thread fills the next, so counting
+* and decompressing overlap, and memory stays at a few buffers however big
+* the log is. When the counter falls behind, the thread waits for a buffer
+* to come back instead of running ahead.
+*
+* A file may be several compressed members (or frames) back to back, as
+* "cat a.gz b.gz" or appending to an archive makes, and they are read as
+* one log. gzip needs zlib, and zstd libzstd: each is only understood when
+* built with CORNER_GROCER_HAVE_ZLIB or CORNER_GROCER_HAVE_ZSTD defined and
+* the library linked, and a file in a format that wasn't built in is
+* reported as an error rather than counted as text. */
+
+//how a file is compressed, if it is
+enum class InputCompression { kNone, kGzip, kZstd };
+
+//bytes decompressed into each buffer before its last line end is found
+const std::size_t kDecompressBufferBytes = std::size_t(4) << 20;
+
+/*buffers each reader keeps: one being counted, one being filled, and one
+* spare so neither side waits on the other for long*/
+const std::size_t kDecompressBufferCount = 3;
+
+/*how the size bytes at data are compressed, told from their magic bytes:
+* 1f 8b for gzip, 28 b5 2f fd for zstd*/
+InputCompression DetectCompression(const char* data, std::size_t size);
+
+//"gzip", "zstd" or "none"
+const char* CompressionName(InputCompression compression);
+
+//true if this build can decompress compression
+bool CompressionSupported(InputCompression compression);
+
+/*Decompresses a gzip or zstd file, from start to its end, on a thread of
+* its own, see above. Throws std::runtime_error from the constructor if the
+* file can't be mapped, isn't compressed or is compressed in a format this
+* build doesn't read, and from Next if it turns out to be damaged or cut
+* short. */
+class DecompressingReader {
+public:
+	/*starts decompressing file_name from start, which must be the start of
+	* a member, into buffer_count buffers of about buffer_bytes each*/
+	explicit DecompressingReader(
+		const std::string& file_name, uint64_t start = 0,
+		std::size_t buffer_bytes = kDecompressBufferBytes,
+		std::size_t buffer_count = kDecompressBufferCount);
+
+	//stops the thread, if it is still going, and waits for it
+	~DecompressingReader();
+
+	//a reader owns a thread and a mapping, so it can't be copied
+	DecompressingReader(const DecompressingReader&) = delete;
+	DecompressingReader& operator=(const DecompressingReader&) = delete;
+
+	/*waits for the next buffer and sets lines to it, whole lines only but
+	* for the very last, then returns true. The buffer lines viewed before
+	* goes back to be filled again, so lines is only valid until the next
+	* call. Returns false at the end of the file.*/
+	bool Next(std::string_view& lines);
+
+	//compressed bytes from start that have been decompressed so far
+	uint64_t consumed() const { return consumed_.load(); }
+
+	//compressed bytes from start to the end of the file
+	uint64_t size() const { return file_.size() - start_; }
+
+	InputCompression compression() const { return compression_; }
+
+	/*true once Next has thrown because the file ends part way through a
+	* member, as one that is still being written does, rather than because
+	* it is damaged*/
+	bool cut_short() const { return cut_short_.load(); }
+
+private:
+	//the thread's loop: fills free buffers until the end or a stop
+	void Decompress();
+
+	MappedFile file_; //the compressed file
+	std::string file_name_; //for error messages
+	uint64_t start_; //where decompressing started
+	InputCompression compression_; //told from the bytes at start_
+	std::size_t buffer_bytes_; //see the constructor
+	std::vector<std::string> buffers_; //reused, capacity and all
+	std::deque<std::size_t> free_; //buffers_ waiting to be filled
+	std::deque<std::size_t> full_; //buffers_ waiting to be counted
+	std::size_t held_ = SIZE_MAX; //buffer Next last handed out, if any
+	bool finished_ = false; //the thread has filled its last buffer
+	bool stopping_ = false; //the thread should stop at its next wait
+	std::string error_; //why the thread stopped early, if it did
+	std::mutex mutex_; //guards everything from free_ to error_
+	std::condition_variable buffer_freed_; //free_ gained a buffer
+	std::condition_variable buffer_filled_; //full_ gained one, or finished_
+	std::atomic<uint64_t> consumed_{0}; //see consumed
+	std::atomic<bool> cut_short_{false}; //see cut_short
+	std::thread thread_; //runs Decompress, started last
+};
+#endif
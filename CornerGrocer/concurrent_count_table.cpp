@@ -0,0 +1,212 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Concurrent Count Table definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "concurrent_count_table.h"
+#include "item_dictionary.h"
+#include "line_scanner.h"
+#include "sales_record.h"
+#include "time_window.h"
+
+namespace {
+//slots in a new table's first array, enough for a store's worth of items
+const std::size_t kInitialCapacity = 1024;
+}  // namespace
+
+//the () zero initializes every slot, so they all start empty
+ConcurrentCountTable::Table::Table(std::size_t capacity)
+	: slots(new std::atomic<uintptr_t>[capacity]()), mask(capacity - 1) {}
+
+ConcurrentCountTable::ConcurrentCountTable()
+	: current_(new Table(kInitialCapacity)) {}
+
+//nothing else can be using the table by now, so no care is needed
+ConcurrentCountTable::~ConcurrentCountTable() {
+	for (Entry* entry = newest_.load(); entry != nullptr;) {
+		Entry* older = entry->older;
+		delete entry;
+		entry = older;
+	}
+	for (Table* table = current_.load(); table != nullptr;) {
+		Table* next = table->next.load();
+		delete table;
+		table = next;
+	}
+	for (Table* table = retired_.load(); table != nullptr;) {
+		Table* retired = table->retired;
+		delete table;
+		table = retired;
+	}
+}
+
+void ConcurrentCountTable::Add(std::string_view item_name, int64_t amount) {
+	FindOrAdd(item_name, ItemDictionary::Hash(item_name))->count.fetch_add(
+		amount, std::memory_order_relaxed);
+}
+
+int64_t ConcurrentCountTable::Count(std::string_view item_name) const {
+	const Entry* entry = Find(item_name, ItemDictionary::Hash(item_name));
+	return entry != nullptr ?
+		entry->count.load(std::memory_order_relaxed) : -1;
+}
+
+//the same line handling as FrequencyEngine::CountRange
+void ConcurrentCountTable::CountBuffer(const char* data, std::size_t size) {
+	LineScanner lines(data, size);
+	for (std::string_view line; lines.Next(line);) {
+		std::string_view item_name = TrimWhitespace(line);
+		int64_t seconds = 0; //dropped, there are no time buckets here
+		SplitTimestamp(item_name, seconds, item_name);
+		SalesRecord record; //prices are dropped too, only units are kept
+		ParseSalesRecord(item_name, record);
+		if (!record.item_name.empty()) {
+			Add(record.item_name, record.quantity);
+		}
+	}
+}
+
+void ConcurrentCountTable::CopyTo(FrequencyTable& items) const {
+	for (const Entry* entry = newest_.load(); entry != nullptr;
+		 entry = entry->older) {
+		items.Add(entry->name, entry->count.load(std::memory_order_relaxed));
+	}
+}
+
+/*an empty slot means the name isn't in this array, and wasn't in any
+* later one either when the slot was read, since a name only goes to a
+* later array once its first empty slot here has been marked moved*/
+ConcurrentCountTable::Entry* ConcurrentCountTable::Find(
+	std::string_view item_name, uint64_t hash) const {
+	for (const Table* table = current_.load(); table != nullptr;
+		 table = table->next.load()) {
+		std::size_t index = hash & table->mask;
+		for (std::size_t probe = 0; probe <= table->mask; ++probe) {
+			uintptr_t value = table->slots[index].load();
+			if (value == 0) { return nullptr; }
+			if (value == kMovedEmpty) { break; } //carry on in the next one
+			Entry* entry = EntryOf(value);
+			if (entry->hash == hash && entry->name == item_name) {
+				return entry;
+			}
+			index = (index + 1) & table->mask;
+		}
+	}
+	return nullptr;
+}
+
+/*like Find, but an empty slot is claimed for a new entry. A thread that
+* loses the race for the slot looks at what won it, which may well be the
+* same name from another thread, before probing on.*/
+ConcurrentCountTable::Entry* ConcurrentCountTable::FindOrAdd(
+	std::string_view item_name, uint64_t hash) {
+	std::unique_ptr<Entry> made; //only made once a slot is worth claiming
+	Table* table = current_.load();
+	while (true) {
+		std::size_t index = hash & table->mask;
+		for (std::size_t probe = 0; probe <= table->mask; ++probe) {
+			std::atomic<uintptr_t>& slot = table->slots[index];
+			uintptr_t value = slot.load();
+			if (value == 0) {
+				if (made == nullptr) {
+					made.reset(new Entry());
+					made->hash = hash;
+					made->name.assign(item_name);
+				}
+				if (slot.compare_exchange_strong(
+					value, reinterpret_cast<uintptr_t>(made.get()))) {
+					Entry* entry = made.release();
+					entry->older = newest_.load();
+					while (!newest_.compare_exchange_weak(entry->older,
+						                                  entry)) {}
+					++item_count_;
+					if (table->used.fetch_add(1) + 1 > (table->mask + 1) / 2) {
+						Grow(table);
+					}
+					return entry;
+				}
+				//lost the race, value is now whatever won it
+			}
+			if (value == kMovedEmpty) { break; }
+			Entry* entry = EntryOf(value);
+			if (entry->hash == hash && entry->name == item_name) {
+				return entry;
+			}
+			index = (index + 1) & table->mask;
+		}
+		Table* next = table->next.load();
+		table = next != nullptr ? next : Grow(table); //moved, or full
+	}
+}
+
+/*entry is already in the table, so it can't meet its own name in another
+* entry here, only itself if another thread placed it first*/
+void ConcurrentCountTable::Place(Table* table, Entry* entry) {
+	while (true) {
+		std::size_t index = entry->hash & table->mask;
+		for (std::size_t probe = 0; probe <= table->mask; ++probe) {
+			std::atomic<uintptr_t>& slot = table->slots[index];
+			uintptr_t value = slot.load();
+			if (value == 0 && slot.compare_exchange_strong(
+				value, reinterpret_cast<uintptr_t>(entry))) {
+				if (table->used.fetch_add(1) + 1 > (table->mask + 1) / 2) {
+					Grow(table);
+				}
+				return;
+			}
+			if (value == kMovedEmpty) { break; }
+			if (EntryOf(value) == entry) { return; }
+			index = (index + 1) & table->mask;
+		}
+		Table* next = table->next.load();
+		table = next != nullptr ? next : Grow(table);
+	}
+}
+
+/*only the thread that links the bigger array moves anything, so each slot
+* is moved once. An entry is placed in the bigger array before its old slot
+* is tagged, so there is never a moment it can't be found.*/
+ConcurrentCountTable::Table* ConcurrentCountTable::Grow(Table* table) {
+	Table* next = table->next.load();
+	if (next != nullptr) { return next; }
+	Table* bigger = new Table((table->mask + 1) * 2);
+	if (!table->next.compare_exchange_strong(next, bigger)) {
+		delete bigger; //another thread linked one first
+		return next;
+	}
+	for (std::size_t index = 0; index <= table->mask; ++index) {
+		std::atomic<uintptr_t>& slot = table->slots[index];
+		uintptr_t value = 0;
+		if (slot.compare_exchange_strong(value, kMovedEmpty)) { continue; }
+		Place(bigger, EntryOf(value));
+		slot.store(value | kMovedTag);
+	}
+	table->moved.store(true);
+	RetireMoved();
+	return bigger;
+}
+
+/*arrays are moved in the order they were linked, but the moves can finish
+* in any order, so whichever thread finishes one walks current_ as far
+* forward as it can*/
+void ConcurrentCountTable::RetireMoved() {
+	Table* table = current_.load();
+	while (table->moved.load()) {
+		Table* next = table->next.load();
+		if (!current_.compare_exchange_strong(table, next)) {
+			continue; //another thread moved it on, table is where to
+		}
+		table->retired = retired_.load();
+		while (!retired_.compare_exchange_weak(table->retired, table)) {}
+		table = next;
+	}
+}
@@ -0,0 +1,142 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Concurrent Count Table header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef CONCURRENT_COUNT_TABLE_H
+#define CONCURRENT_COUNT_TABLE_H
+#include "frequency_engine.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/* This file is an item count table any number of threads can add to and
+* look up in at the same time, with no locks. FrequencyTable is faster for
+* one thread, and FrequencyEngine gets its parallelism by giving each thread
+* a table of its own, but neither can be read while it is being counted
+* into; this can.
+*
+* Each item is an Entry holding its name, hash and an atomic count, and is
+* never moved or freed while the table exists. The hash table itself is an
+* open addressing array of pointers to entries, probed linearly:
+*
+*   lookups   probe the array with atomic loads and never write, so a
+*             lookup finishes in a bounded number of steps whatever other
+*             threads do (wait-free)
+*   adding    to an item already there is one fetch_add on its count
+*   new item  an entry is made and compare_exchanged into the first empty
+*             slot; a thread that loses the race to another adding the same
+*             name finds that name in the slot and uses it instead
+*
+* An array more than half full grows: a twice as big one is linked after it
+* and the thread that linked it moves every entry pointer across, marking
+* each old slot as moved as it goes (an empty slot can't be filled after
+* that, an entry's pointer is kept with a tag bit, so it is still found).
+* Other threads carry on meanwhile, going on to the new array whenever they
+* meet a moved empty slot, so nobody waits for the move. Counts live in the
+* entries, not the arrays, so moving loses no increments.
+*
+* Arrays that have been moved out of may still be read by a lookup that
+* started earlier. Rather than tracking readers, which would cost every
+* lookup a shared write, they are kept until the table is destroyed: they
+* halve in size going back, so together they are smaller than the current
+* array. */
+class ConcurrentCountTable {
+public:
+	ConcurrentCountTable();
+	~ConcurrentCountTable();
+
+	//a table owns its entries and arrays, so it can't be copied
+	ConcurrentCountTable(const ConcurrentCountTable&) = delete;
+	ConcurrentCountTable& operator=(const ConcurrentCountTable&) = delete;
+
+	/*adds amount (which may be negative) to the count of item_name, adding
+	* the item with a count of zero first if it isn't there. Safe to call
+	* from any number of threads at once.*/
+	void Add(std::string_view item_name, int64_t amount);
+
+	/*returns the count of item_name, or -1 if it was never added, like
+	* FrequencyEngine::ItemFrequency. Wait-free, and safe to call while
+	* other threads add.*/
+	int64_t Count(std::string_view item_name) const;
+
+	/*counts every line of a buffer the way FrequencyEngine does (trimmed,
+	* blank lines skipped, any timestamp dropped). Several threads can count
+	* separate buffers, or pieces of one, at once.*/
+	void CountBuffer(const char* data, std::size_t size);
+
+	//number of distinct items added so far
+	uint64_t size() const { return item_count_.load(); }
+
+	/*adds every item to items, newest first. Each count is exact as of the
+	* moment it is read, but if other threads are still adding, the counts
+	* aren't all read at the same moment.*/
+	void CopyTo(FrequencyTable& items) const;
+
+private:
+	//one item, allocated once and never moved, so its count can be shared
+	struct alignas(64) Entry {
+		std::atomic<int64_t> count{0}; //alone on its cache line with name
+		uint64_t hash = 0; //ItemDictionary::Hash of name
+		std::string name; //the item name, never changed once published
+		Entry* older = nullptr; //the entry added before this one
+	};
+
+	//one open addressing array of entry pointers, see above
+	struct Table {
+		explicit Table(std::size_t capacity);
+		std::unique_ptr<std::atomic<uintptr_t>[]> slots; //see kMovedEmpty
+		std::size_t mask; //capacity - 1, capacity is a power of two
+		std::atomic<std::size_t> used{0}; //slots holding an entry
+		std::atomic<Table*> next{nullptr}; //the bigger array, once linked
+		std::atomic<bool> moved{false}; //true once every slot is moved
+		Table* retired = nullptr; //the array retired before this one
+	};
+
+	/*slot values: 0 is empty, kMovedEmpty an empty slot that can no longer
+	* be filled, anything else an Entry pointer, with kMovedTag set once it
+	* has been copied into the next array. Entries are 64 byte aligned, so
+	* the tag bit is never part of a pointer.*/
+	static const uintptr_t kMovedEmpty = 1;
+	static const uintptr_t kMovedTag = 1;
+
+	static Entry* EntryOf(uintptr_t slot) {
+		return reinterpret_cast<Entry*>(slot & ~kMovedTag);
+	}
+
+	//the entry for item_name with the given hash, or nullptr
+	Entry* Find(std::string_view item_name, uint64_t hash) const;
+
+	//the entry for item_name, added if it isn't there yet
+	Entry* FindOrAdd(std::string_view item_name, uint64_t hash);
+
+	/*puts entry in table, or the array after it if that slot was moved.
+	* Does nothing if another thread already put it there.*/
+	void Place(Table* table, Entry* entry);
+
+	/*links a bigger array after table, if no thread has yet, and if this
+	* thread linked it, moves table's entries across. Returns the array
+	* after table.*/
+	Table* Grow(Table* table);
+
+	//moves current_ past every array that has been moved out of
+	void RetireMoved();
+
+	std::atomic<Table*> current_; //oldest array still in use
+	std::atomic<Table*> retired_{nullptr}; //arrays moved out of, newest first
+	std::atomic<Entry*> newest_{nullptr}; //every entry, newest first
+	std::atomic<uint64_t> item_count_{0}; //entries added
+};
+#endif
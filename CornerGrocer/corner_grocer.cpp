@@ -14,15 +14,61 @@
 */
 #include "python_functions.h"
 #include "corner_grocer.h"
+#include "compressed_input.h"
+#include "mapped_file.h"
+#include "metrics.h"
 #include <iostream>
 #include <iomanip>
-#include <fstream>
-#include <vector>
 #include <regex>
 
+namespace {
+//most items option 2 lists when what was typed isn't a whole name
+const std::size_t kSearchResultLimit = 10;
+
+//the most of the input the approximate backend counts between checks
+const std::size_t kIngestPieceBytes = std::size_t(64) << 20;
+
+/*counts file_name into sketch a piece at a time, each cut at a line end,
+* so progress can be shown and counting stopped between pieces. Each piece
+* is still shared out between the sketch's threads. A compressed file's
+* pieces are the reader's buffers, and progress is in compressed bytes.*/
+void CountFileInPieces(const std::string& file_name, SketchEngine& sketch,
+	                   TaskProgress& progress) {
+	MappedFile input(file_name);
+	if (DetectCompression(input.data(), input.size()) !=
+		InputCompression::kNone) {
+		DecompressingReader reader(file_name);
+		progress.set_total(reader.size());
+		std::string_view lines; //the buffer being counted
+		while (!progress.cancelled() && reader.Next(lines)) {
+			sketch.CountBuffer(lines.data(), lines.size());
+			progress.set_done(reader.consumed());
+		}
+		return;
+	}
+	std::string_view rest(input.data(), input.size()); //not counted yet
+	progress.set_total(input.size());
+	while (!rest.empty() && !progress.cancelled()) {
+		std::size_t piece = rest.size();
+		if (piece > kIngestPieceBytes) {
+			//up to the last line end that fits, or the first if none does
+			piece = rest.rfind('\n', kIngestPieceBytes - 1);
+			if (piece == std::string_view::npos) {
+				piece = rest.find('\n', kIngestPieceBytes);
+			}
+			piece = piece == std::string_view::npos ? rest.size() : piece + 1;
+		}
+		sketch.CountBuffer(rest.data(), piece);
+		rest.remove_prefix(piece);
+		progress.set_done(input.size() - rest.size());
+	}
+}
+}  // namespace
+
 /*Parameterized constructor, see corner_grocer.h for usage details*/
 CornerGrocer::CornerGrocer(const char* input_file_name, 
-	                       const char* output_file_name) {
+	                       const char* output_file_name,
+	                       CountingBackend backend) : backend_(backend) {
 
 	InitPython(); //call function to initialize Python, import ProduceManager
 
@@ -60,6 +106,36 @@ void CornerGrocer::SetInputFileName(std::string fileName) {
 void CornerGrocer::SetOutputFileName(std::string fileName) {
 	this->output_file_name_ = fileName; //set given string as output file name
 }
+void CornerGrocer::SetIngestThreads(unsigned thread_count) {
+	//the engines split the input file into one chunk per thread
+	frequency_engine_.set_thread_count(thread_count);
+	sketch_engine_.set_thread_count(thread_count);
+}
+void CornerGrocer::SetOutputFormat(FrequencyFileFormat format) {
+	output_format_ = format; //used the next time the output file is written
+}
+
+void CornerGrocer::SetTimeWindows(const TimeWindowOptions& options) {
+	frequency_engine_.EnableTimeWindows(options); //filled in when counting
+}
+
+void CornerGrocer::SetCheckpointFile(const std::string& file_name) {
+	checkpoint_file_name_ = file_name; //loaded and saved when counting
+}
+
+void CornerGrocer::SetHistoryFile(const std::string& file_name) {
+	history_file_name_ = file_name; //added to when the output file is
+}
+
+void CornerGrocer::SetSketchOptions(const SketchOptions& options) {
+	unsigned thread_count = sketch_engine_.thread_count(); //kept as it was
+	sketch_engine_ = SketchEngine(options);
+	sketch_engine_.set_thread_count(thread_count);
+}
+
+void CornerGrocer::SetHistogramOptions(const HistogramOptions& options) {
+	histogram_renderer_.set_options(options); //used by the next chart drawn
+}
 
 /*Specialized declaration of ValidateInput for being called to return an 
 * integer. Takes one string argument, prompt, which is the prompt to give to 
@@ -111,8 +187,9 @@ std::string CornerGrocer::ValidateInput<std::string>(std::string prompt) {
 	//string match object to hold matches and indicate if a match was found
 	std::smatch matches;
 
-	// set up regex, matches any string of only alphabet characters
-	std::regex input_filter("^[a-zA-Z]*$"); 
+	/*set up regex, matches letters, digits, spaces and the punctuation found
+	* in item names, so names of more than one word can be typed*/
+	std::regex input_filter("^[a-zA-Z0-9 '&.,-]*$");
 	std::string input = ""; //initialize empty string to hold input.
 	while (true) { //infinite loop, return statement will exit function
 		try {
@@ -121,7 +198,7 @@ std::string CornerGrocer::ValidateInput<std::string>(std::string prompt) {
 			if (input == "") { //if no input was entered ... 
 				throw std::invalid_argument("No input detected!");
 			}
-			//if inpu tmatches any sequence of only alphabet characters...
+			//if input matches any sequence of item name characters...
 			if (regex_match(input, matches, input_filter)) { 
 				return input; //...return input
 			}
@@ -152,34 +229,67 @@ void CornerGrocer::UserMenu() {
 	std::cout << "2: View Amount Sold of Specific Item" << std::endl;
 	std::cout << "3: View Graph of All Items Sold Today" << std::endl;
 	std::cout << "4: Exit" << std::endl;
+	std::cout << "5: Compare Native Counts With Python Counts" << std::endl;
+	std::cout << "6: Refresh Counts With New Sales" << std::endl;
+	std::cout << "7: View Best Selling Items" << std::endl;
+	std::cout << "8: View Worst Selling Items" << std::endl;
+	std::cout << "9: View Items Sold More Than a Quantity" << std::endl;
+	std::cout << "10: View Amount of an Item Sold Recently" << std::endl;
+	std::cout << "11: View Timing Statistics" << std::endl;
+	std::cout << "12: View Sales History of an Item" << std::endl;
+	if (background_.running()) { //say what the menu is sharing its time with
+		std::cout << "In the background: " << background_.Describe()
+			<< std::endl;
+	}
 }
 
 /*This function works as the primary function of CornerGrocer instances.
 * Other than the constructor, it is the only function that has to be caleld
 * from elsewhere. */
 void CornerGrocer::Application() {
-	/*Calls ProduceManager's totalProduceFrequencies function, which sets up a 
-	* Python dictionary in the ProduceManager instance, making the data 
-	* persistent across all method calls in Python. Program must be reloaded if
+	/*The menu lets go of the GIL for as long as it runs, so a background
+	* Python job is never held up by a prompt waiting on the user. Each
+	* Python call the menu makes takes it back with a ScopedGil. */
+	{
+		ScopedGilRelease gil_released;
+		RunMenu();
+	}
+
+	/*Call FinalizePython, pass ProduceManager instance, clean up, with the
+	* GIL held again*/
+	FinalizePython(produce_manager_instance_);
+}
+
+//Counts the input file, then shows the menu until option 4 is chosen
+void CornerGrocer::RunMenu() {
+	/*Starts ProduceManager's totalProduceFrequencies function (or the native
+	* count) in the background, which sets up a Python dictionary in the 
+	* ProduceManager instance, making the data persistent across all method
+	* calls in Python. The menu is shown straight away, and options that need
+	* the counts wait until they are done. Program must be reloaded if
 	*  input file  is changed, as the input data is only processed once. */
-	CallObjectMethod<void>(produce_manager_instance_, 
-		                   *"total_produce_frequencies");
+	CountItemFrequencies();
 	do { //while condition is "true"- infinite loop until a value is returned
+		//a background job that is over has its errors, if any, shown first
+		if (background_.started() && !background_.running()) {
+			FinishBackground();
+		}
 		UserMenu();
 		try {
 
 			//assign the integer returned by ValidateInput to choice
 			int choice = ValidateInput<int>("Please choose an option number:");
-			if (choice > 4 || choice < 1) { //check if choice is a valid option
+			if (choice > 12 || choice < 1) { //check if choice is a valid option
 				throw(std::invalid_argument("Input error:"));
 			}
+			else if (WaitingOnBackground(choice)) {
+				continue; //told the user what it is waiting on
+			}
 			else if (choice == 1) { //if choice is 1...
-				/*...Call python_functions' CallObjectMethod, which in turn 
-				* calls ProduceManager's "printAllProduceFrequencies" method
-				* See ProduceManager.py for details, essentially prints all 
-				* item names and quantities sold*/
-				CallObjectMethod<void>(produce_manager_instance_, 
-					                   *"print_all_produce_frequencies");
+				/*...print all item names and quantities sold, either through
+				* ProduceManager's "printAllProduceFrequencies" method or
+				* natively, see PrintAllItemFrequencies for details*/
+				PrintAllItemFrequencies();
 				ClearScreen();
 			}
 			else if (choice == 2) {//if choice is 2...
@@ -189,26 +299,69 @@ void CornerGrocer::Application() {
 			}
 			else if (choice == 3) { //if choice is 3...
 
-				/*...Call python_functions' CallObjectMethod, which in turn 
-				* calls the instance of ProduceManager's "writeFrequencyFile" 
-				* method. See ProduceManager.py for details, but essentially 
-				* writes item names and item quantities from input file to an 
-				* output file*/
-				CallObjectMethod<void>(produce_manager_instance_, 
-					                   *"write_frequency_file");
+				/*...start writing item names and item quantities from input
+				* file to the output file in the background, see
+				* WriteFrequencyFile for details*/
+				WriteFrequencyFile();
 
 				/*This function prints a slightly prettified histogram in text 
 				* format, graphically displaying the items sold that day and 
-				* quantity sold. uses file produced by above Method call to 
-				* ProduceManager */
-				PrintFrequencyHistogram(output_file_name_);
+				* quantity sold. Every backend's counts (Python's copied
+				* across after counting) are already in memory and are charted
+				* directly, without waiting for the file. */
+				RenderFrequencyHistogram(CountedItems());
 			}
 			else if (choice == 4) {
-				/*Call FinalizePython, pass ProduceManager instance, clean up*/
-				FinalizePython(produce_manager_instance_);
-				//Exit Program
+				/*stop counting part way, or wait for a write to finish, so
+				* nothing is still using Python when it is finalized*/
+				if (background_.running()) {
+					std::cout << "Stopping: " << background_.Describe()
+						<< std::endl;
+				}
+				background_.Cancel();
+				if (produce_manager_instance_ != nullptr) {
+					//a Python count checks this flag rather than background_
+					ScopedGil gil;
+					SetObjectFlag(produce_manager_instance_,
+						          *"countCancelled", true);
+				}
+				FinishBackground();
+
+				//Exit menu, Application finalizes Python
 				return;
 			}
+			else if (choice == 5) { //if choice is 5...
+				//...check the native counts against the Python reference
+				CompareBackends();
+			}
+			else if (choice == 6) { //if choice is 6...
+				//...count whatever the registers added since the last read
+				RefreshItemFrequencies();
+			}
+			else if (choice == 7) { //if choice is 7...
+				//...rank the best sellers, see PrintRankedItems for details
+				PrintRankedItems(RankKind::kTop);
+			}
+			else if (choice == 8) { //if choice is 8...
+				//...rank the worst sellers
+				PrintRankedItems(RankKind::kBottom);
+			}
+			else if (choice == 9) { //if choice is 9...
+				//...rank every item that sold more than a quantity
+				PrintRankedItems(RankKind::kAbove);
+			}
+			else if (choice == 10) { //if choice is 10...
+				//...look an item up in the recent time buckets
+				CheckRecentItemFrequency();
+			}
+			else if (choice == 11) { //if choice is 11...
+				//...show where the time has gone so far, see metrics.h
+				PrintTimingStatistics();
+			}
+			else if (choice == 12) { //if choice is 12...
+				//...show earlier days' sales, see history_store.h
+				PrintSalesHistory();
+			}
 		}
 		/*catch exception thrown if user input is not a valid choice, even 
 		* though it is an integer */
@@ -230,29 +383,60 @@ void CornerGrocer::CheckSingleItemFrequency() {
 		ClearScreen(); //clear screen
 
 		/*Call ValidateInput to set string item_name to a valid string 
-		* consisting of alphabetic characters*/
+		* consisting of item name characters*/
 		std::string item_name = ValidateInput<std::string>
 			("Please enter an item to see quantity sold ('quit' to quit): ");
-		
-		/*convert first letter of item_name to uppercase, so it matches the 
-		* file. DOes nothing if already uppercase.
-		item_name[0] = std::toupper(item_name[0]); 
-
-		/*call ProduceManager instance's returnProduceFrequency with item name 
-		* converted to c-style string. Store resulting integer in item_qty */
-		int item_qty = CallObjectMethod<int>(produce_manager_instance_,
-			                                 *"return_produce_frequency", 
-			                                 *item_name.c_str());
-
-		//method returns -1 if no match is found, if that's not the case...
-		if (item_qty != -1) {
+
+		/*match item_name ignoring case and spacing. The approximate backend
+		* only indexes its best sellers, so failing that, look it up as
+		* typed. Matching names are collected in names.*/
+		const FrequencyTable& items = CountedItems();
+		std::vector<uint32_t> ids; //matching item IDs in items
+		search_index_.FindExact(item_name, ids);
+		std::vector<std::string> names;
+		for (uint32_t id : ids) { names.emplace_back(items.Name(id)); }
+		if (names.empty() && LookupItemFrequency(item_name) != -1) {
+			names.push_back(item_name);
+		}
+		bool exact = !names.empty(); //false if only part of a name matched
+
+		//if user enters 'quit' in any case, and no item is called that...
+		if (!exact && NormalizeItemName(item_name) == "quit") {
+			ClearScreen(); //...clear screen
+			return; //exit function
+		}
+		if (!exact) { //list items with words starting with what was typed
+			search_index_.Search(item_name, kSearchResultLimit, ids);
+			for (uint32_t id : ids) { names.emplace_back(items.Name(id)); }
+		}
+
+		//if anything matched...
+		if (!names.empty()) {
+			if (!exact) {
+				std::cout << "No item is called \"" << item_name
+					<< "\", but these match it:" << std::endl;
+			}
 			/*...use the following cout statements to print a prettified 
-			* version of the provided item_name and its returned quantity 
+			* version of each item name and its returned quantity 
 			* justifying output as necessary, and setting field widths. */
-			std::cout << " ======================= " << std::endl
-				<< "|" << std::left << std::setw(12) << item_name << "\t"
-				<< std::right << std::setw(8) << item_qty << "|" << std::endl
-				<< " ----------------------- " << std::endl;
+			std::cout << " ======================= " << std::endl;
+			for (const std::string& name : names) {
+				std::cout << "|" << std::left << std::setw(12) << name << "\t"
+					<< std::right << std::setw(8) << LookupItemFrequency(name)
+					<< "|" << std::endl;
+			}
+			std::cout << " ----------------------- " << std::endl;
+			/*revenue, when the log gave prices, is only kept by the native
+			* backend (see sales_record.h)*/
+			if (backend_ == CountingBackend::kNative &&
+				frequency_engine_.Items().has_revenue()) {
+				for (const std::string& name : names) {
+					std::cout << name << " revenue: $" << std::fixed
+						<< std::setprecision(2)
+						<< frequency_engine_.ItemRevenue(name) / 100.0
+						<< std::defaultfloat << std::endl;
+				}
+			}
 
 			std::cout << "Press Enter to continue..."; //wait for input
 			std::cin.get(); //get whatever the user typed on the buffer
@@ -260,12 +444,7 @@ void CornerGrocer::CheckSingleItemFrequency() {
 			ClearScreen(); //clearscreen
 			return;
 		} 
-		//if user enters 'quit' or 'Quit', (string capitalized by function) ...
-		else if (item_name == "Quit") {
-			ClearScreen(); //...clear screen
-			return; //exit function
-		}
-		else { //if item_qty is -1 (match not found)...
+		else { //if nothing matched...
 			//output item_name and message
 			std::cout << "\"" << item_name << "\" not found in today's sales!" 
 				<< std::endl;
@@ -278,92 +457,585 @@ void CornerGrocer::CheckSingleItemFrequency() {
 
 /*This function prints a slightly prettified histogram in text format,
 * graphically displaying the items sold that day and quantity sold.
-* takes the name of an input file as an argument. */
+* takes the name of an input file as an argument. A binary frequency file is
+* mapped and charted in place. A text file is read into a FrequencyTable, 
+* which interns each name once, and then charted. */
 void CornerGrocer::PrintFrequencyHistogram(std::string &dataFile) {
-	std::ifstream fileReader; //create ifstream to read in from file
-
-	//set exception mask, error thrown if badbit caught (file missing, etc.)
-	fileReader.exceptions(std::ifstream::badbit); 
-	try { 
-		//open file with the name of argument, setting fileReader to "in" mode
-		fileReader.open(dataFile, std::ifstream::in); 
-		if (fileReader.is_open()) { //if  file is open...
-			int largest_qty = 0;  //highest qty found (used to print chart)
-			int longest_string = 0; //longest name length (used to print chart)
-			
-			//setting up a string vector to hold all item names
-			std::vector<std::string> item_names; 
-			
-			//setting up an integer vector to hold all quantities
-			std::vector<int> item_qtys; 
-
-			//read from file until getline returns an EOF character
-			for (std::string line; std::getline(fileReader, line);) { 
-
-				/*find the position of the first space in each line. As the 
-				* output file is written with the itemname separated by a 
-				* single space, this gives the itemname before that position,
-				*  and the item qty after it */
-				int space_pos = line.find(" ", 0); 
-				
-				/*find the item_name, which is the substring from the 0 (first)
-				* position to the position of the space*/
-				std::string item_name = line.substr(0, space_pos); 
-				
-				/*find the item_qty, which is the substring from the space 
-				* position to end of line (converted to int by stoi()) */
-				int item_qty = stoi(line.substr(space_pos, std::string::npos)); 
-				item_names.push_back(item_name); //add item_name to vector
-				item_qtys.push_back(item_qty); //add item_qty to vector
-
-				//replaces largest_qty with item_qty if item_qty is larger
-				if (item_qty > largest_qty) { largest_qty = item_qty; } 
-				
-				/*since the position of the space indicates the length of each 
-				* itemname, if space position is greater than the current 
-				* longest string, assign longest string the value of the space 
-				* character's position */
-				if (space_pos > longest_string) { longest_string = space_pos; }
-			}
-			
-			/*used to determine how long (wide) the header row should be. Five 
-			* added to account for spaces */
-			size_t chart_width = longest_string + largest_qty + 5; 
-
-			/*make header a string filled with a number of "=" characters 
-			*equivalent to chart_width */
-			std::string header(chart_width, '='); 
-			ClearScreen(); //clear screen
-			std::cout << " " << header << " " << std::endl;//print chart header
-
-			/*loop until i is the same as the size of item_names, i.e., 
-			* until the vector of item_names has been gone through, 
-			* printing a line of the chart until complete*/
-			for (int i = 0; i < item_names.size(); i++) { 
-				/*print edge of chart, right justify the current item_name from
-				*  the vector, set the fieldwidth to the width of the longest 
-				* itemname, print item name, print separator*/
-				std::cout << "| "  << std::right << std::setw(longest_string) 
-					<< item_names[i] << " | "; 
-				/*create a string of '*' characters equal to the number of 
-				* current item_qty from integer vector, right justify, set 
-				* width to highest item_qty in vector. print endline*/
-				std::cout << std::left << std::setw(largest_qty) 
-					<< std::string(item_qtys[i], '*') << " |" << std::endl;
-			}
-			//print chart header again, to close off the chart
-			std::cout << " " << header << " " << std::endl;
-		} 
-		std::cout << "Press Enter to continue..."; //pause for user input
-		std::cin.get(); //get whatever the user typed on the buffer
-		std::cin.ignore(0); //discard EOF
-		ClearScreen(); //clear screen
+	FrequencyEngine file_counts; //holds the items read from a text file
+	std::unique_ptr<FrequencyFileView> file_view; //set for binary files
+	try {
+		CORNER_GROCER_TIME_STAGE(kFileRead); //reading only, not charting
+		MappedFile file(dataFile); //map file just to look at its first bytes
+		if (IsBinaryFrequencyFile(file.data(), file.size())) {
+			//binary file, no parsing needed, chart straight from the mapping
+			file_view.reset(new FrequencyFileView(dataFile));
+			CORNER_GROCER_COUNT(kBytesRead, file.size());
+		}
+		else {
+			//read each "<itemName> <itemQty>" line of the file into the table
+			file_counts.CountFrequencyFile(dataFile);
+		}
 	}
-
-	//if file can't be opened (ifstream's badbit gets set)...
-	catch (std::ifstream::failure fileError) { 
+	//if file can't be opened or mapped...
+	catch (std::runtime_error& fileError) { 
 		/*...print an error. This function does not loop and simply exits, 
 		* asthere is no action that can be taken to fix the file in situ*/
 		std::cerr << "Error opening File!"; 
+		return;
+	}
+	if (file_view != nullptr) { RenderFrequencyHistogram(*file_view); }
+	else { RenderFrequencyHistogram(file_counts.Items()); }
+}
+
+/*This function draws the histogram for item_counts, laid out as set by
+* SetHistogramOptions. The whole chart is built in the renderer's buffer 
+* (see histogram.h) and written in one call, instead of one stream call 
+* per row. */
+template<typename RowSource> 
+void CornerGrocer::RenderHistogramRows(const RowSource& item_counts) {
+	const std::string& chart = histogram_renderer_.Render(item_counts);
+	ClearScreen(); //clear screen
+	{
+		//flushed inside the timer, or the time would show up at the prompt
+		CORNER_GROCER_TIME_STAGE(kTerminalOutput);
+		CORNER_GROCER_COUNT(kTerminalBytes, chart.size());
+		std::cout.write(chart.data(), chart.size());
+		std::cout.flush();
+	}
+	std::cout << "Press Enter to continue..."; //pause for user input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
+
+//charts items in memory, in ID (first seen) order
+void CornerGrocer::RenderFrequencyHistogram(const FrequencyTable& item_counts) {
+	RenderHistogramRows(item_counts);
+}
+
+//charts the rows of a binary frequency file, in name order
+void CornerGrocer::RenderFrequencyHistogram(
+	const FrequencyFileView& item_counts) {
+	RenderHistogramRows(item_counts);
+}
+
+/*This function starts counting the input file, on background_, with
+* whichever backend was chosen at construction. The Python backend builds
+* ProduceManager's dictionary, the native backend fills frequency_engine_
+* and the approximate backend sketch_engine_. Errors opening the file leave
+* the counts empty, just like the Python version, and are reported by
+* FinishBackground once counting is over. */
+void CornerGrocer::CountItemFrequencies() {
+	FinishBackground(); //nothing else may be running
+	background_job_ = BackgroundJob::kIngest;
+	if (backend_ == CountingBackend::kPython) {
+		StartPythonCount();
+		return;
+	}
+	if (backend_ == CountingBackend::kApproximate) {
+		background_.Start("Estimating " + input_file_name_,
+			              [this](TaskProgress& progress) {
+			sketch_engine_.Clear();
+			try {
+				CountFileInPieces(input_file_name_, sketch_engine_, progress);
+			}
+			catch (std::runtime_error&) { //file missing or unreadable
+				RebuildSearchIndex();
+				throw;
+			}
+			RebuildSearchIndex();
+		});
+		return;
+	}
+	background_.Start("Counting " + input_file_name_,
+		              [this](TaskProgress& progress) {
+		try {
+			log_follower_.reset(new LogFollower(input_file_name_,
+				                                frequency_engine_));
+
+			/*with a snapshot of this log, carry on from where it was taken.
+			* Otherwise the first poll reads the whole file. A cancelled
+			* poll stops at a block boundary, and what was read by then is
+			* snapshotted too, so the next start carries on from there.*/
+			uint64_t offset = 0;
+			if (!checkpoint_file_name_.empty() &&
+				LoadCheckpoint(checkpoint_file_name_, input_file_name_,
+					           frequency_engine_, offset)) {
+				log_follower_->ResumeAt(offset);
+			}
+			log_follower_->set_progress(&progress);
+			log_follower_->Poll();
+			log_follower_->set_progress(nullptr); //refreshes aren't tracked
+			if (!log_follower_->file_open()) { //no such file
+				throw std::runtime_error("Error opening File: " +
+					                     input_file_name_);
+			}
+			if (!checkpoint_file_name_.empty()) {
+				WriteCheckpoint(checkpoint_file_name_, frequency_engine_,
+					            *log_follower_);
+			}
+		}
+		catch (std::runtime_error&) { //file missing or couldn't be read
+			RebuildSearchIndex();
+			throw;
+		}
+		RebuildSearchIndex();
+	});
+}
+
+/*ProduceManager can't see background_'s cancel, so exiting sets its
+* countCancelled flag too, which it checks before every line. The flag is
+* cleared here, before the job starts, rather than by the job, so a cancel
+* can never be cleared by the job it was meant to stop.*/
+void CornerGrocer::StartPythonCount() {
+	FinishBackground(); //nothing else may be using Python
+	{
+		ScopedGil gil; //the menu doesn't hold it otherwise
+		SetObjectFlag(produce_manager_instance_, *"countCancelled", false);
+	}
+	background_.Start("Counting " + input_file_name_ + " in Python",
+		              [this](TaskProgress&) {
+		ScopedGil gil; //the menu never holds it
+		CountPythonFrequencies();
+	});
+}
+
+/*Calls ProduceManager's totalProduceFrequencies method, which sets up a
+* Python dictionary in the ProduceManager instance, making the data
+* persistent across all method calls in Python. The dictionary is emptied
+* first, so this can be called again to recount the file. */
+void CornerGrocer::CountPythonFrequencies() {
+	CallObjectMethod<void>(produce_manager_instance_,
+		                   *"totalProduceFrequencies");
+
+	//copy the whole dictionary across once, so lookups stay on this side
+	FetchFrequencyTable(produce_manager_instance_, *"exportFrequencyTable",
+		                python_counts_);
+	RebuildSearchIndex();
+}
+
+/*the snapshot is replaced whole each time, so a crash part way through
+* leaves the previous one (see checkpoint.h)*/
+void CornerGrocer::SaveCheckpoint() {
+	if (checkpoint_file_name_.empty() || log_follower_ == nullptr) { return; }
+	try {
+		WriteCheckpoint(checkpoint_file_name_, frequency_engine_,
+			            *log_follower_);
 	}
-}
\ No newline at end of file
+	catch (std::runtime_error& error) { //couldn't be written, counts are fine
+		std::cerr << error.what() << std::endl;
+	}
+}
+
+/*sorting every name takes a few milliseconds even for 100,000 items, so
+* the index is simply built again rather than updated in place*/
+void CornerGrocer::RebuildSearchIndex() {
+	search_index_.Build(CountedItems());
+}
+
+/*The native backend polls log_follower_, which reads only what was added
+* since the last read. The Python backend calls ProduceManager's
+* updateProduceFrequencies method, which does the same in Python, then
+* copies Python's counts across again. The approximate backend keeps no
+* place in the file, so it says so instead. */
+void CornerGrocer::RefreshItemFrequencies() {
+	int64_t new_units = 0; //sales counted by this refresh
+	std::string note; //what happened to the file, if anything unusual
+	if (backend_ == CountingBackend::kApproximate) {
+		note = " (approximate counts can't be refreshed, restart to recount)";
+	}
+	else if (backend_ == CountingBackend::kPython) {
+		int64_t units_before = python_counts_.TotalUnits();
+		ScopedGil gil; //the menu doesn't hold it otherwise
+		CallObjectMethod<void>(produce_manager_instance_,
+			                   *"updateProduceFrequencies");
+		FetchFrequencyTable(produce_manager_instance_, *"exportFrequencyTable",
+			                python_counts_);
+		new_units = python_counts_.TotalUnits() - units_before;
+	}
+	else if (log_follower_ != nullptr) {
+		try {
+			FollowUpdate update = log_follower_->Poll();
+			new_units = update.units;
+			if (update.event != FollowEvent::kNone) { SaveCheckpoint(); }
+			if (update.event == FollowEvent::kTruncated) {
+				note = " (the log was truncated and read from the top)";
+			}
+			else if (update.event == FollowEvent::kRotated) {
+				note = " (the log was rotated, the new one was read)";
+			}
+		}
+		catch (std::runtime_error& error) { //file couldn't be read
+			std::cerr << error.what() << std::endl;
+		}
+	}
+	RebuildSearchIndex(); //new items can be searched for too
+	ClearScreen(); //clear screen
+	std::cout << new_units << " new sales counted" << note << "." << std::endl;
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
+
+/*This function prints all item names and quantities sold. The Python
+* backend calls ProduceManager's printAllProduceFrequencies method, the
+* native backend prints the same table from frequency_engine_, and the
+* approximate backend prints its best sellers, then how far off they may be.
+*/
+void CornerGrocer::PrintAllItemFrequencies() {
+	if (backend_ == CountingBackend::kPython) {
+		ScopedGil gil; //the menu doesn't hold it otherwise
+		CallObjectMethod<void>(produce_manager_instance_,
+			                   *"printAllProduceFrequencies");
+		return;
+	}
+
+	const FrequencyTable& items = CountedItems();
+	{
+		//the table only, the prompt below waits on the user
+		CORNER_GROCER_TIME_STAGE(kTerminalOutput);
+		//same layout as the Python table: 12 wide name, tab, 8 wide quantity
+		std::cout << " ======================= " << std::endl
+			<< "|" << std::left << std::setw(12) << "Produce Name" << "\t"
+			<< std::right << std::setw(8) << "Quantity" << "|" << std::endl
+			<< "|=======================|" << std::endl;
+		for (uint32_t id = 0; id < items.size(); ++id) {
+			std::cout << "|" << std::left << std::setw(12) << items.Name(id)
+				<< "\t" << std::right << std::setw(8) << items.Count(id)
+				<< "|" << '\n';
+		}
+		std::cout << "|-----------------------|" << std::endl;
+	}
+	if (backend_ == CountingBackend::kApproximate) {
+		SketchErrorBounds bounds = sketch_engine_.ErrorBounds();
+		std::cout << "Estimated: the top " << items.size() << " of about "
+			<< sketch_engine_.DistinctItems() << " items (+/- "
+			<< std::fixed << std::setprecision(1)
+			<< bounds.distinct_error * 100 << "%)." << std::endl
+			<< "Each quantity is at most " << bounds.frequency_error
+			<< " too high, with " << std::setprecision(1)
+			<< bounds.confidence * 100 << "% confidence." << std::endl
+			<< std::defaultfloat;
+	}
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+}
+
+/*Both backends rank natively: the Python backend's counts were copied into
+* python_counts_ after counting, so ranking them never calls into Python.*/
+void CornerGrocer::PrintRankedItems(RankKind kind) {
+	RankQuery query;
+	query.kind = kind;
+	query.value = ValidateInput<int>(kind == RankKind::kAbove ?
+		"Show items that sold more than:" : "How many items?");
+	std::vector<uint32_t> ids; //picked items, best (or worst) first
+	const FrequencyTable& items = CountedItems();
+	RunRankQuery(items, query, ids);
+
+	ClearScreen(); //clear screen
+	//same layout as the full table, with each item's rank in front
+	std::cout << " ============================ " << std::endl
+		<< "|Rank " << std::left << std::setw(12) << "Produce Name" << "\t"
+		<< std::right << std::setw(8) << "Quantity" << "|" << std::endl
+		<< "|============================|" << std::endl;
+	for (std::size_t rank = 0; rank < ids.size(); ++rank) {
+		std::cout << "|" << std::right << std::setw(4) << rank + 1 << " "
+			<< std::left << std::setw(12) << items.Name(ids[rank]) << "\t"
+			<< std::right << std::setw(8) << items.Count(ids[rank]) << "|"
+			<< '\n';
+	}
+	std::cout << "|----------------------------|" << std::endl;
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
+
+void CornerGrocer::PrintTimingStatistics() {
+	ClearScreen(); //clear screen
+	MetricsRegistry::Global().PrintTable(std::cout);
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
+
+/*the 90 days end at the latest day recorded rather than today, so a
+* history that hasn't been added to lately still shows its last days*/
+void CornerGrocer::PrintSalesHistory() {
+	const int64_t kHistoryDays = 90; //days shown, and the movers' last day
+	const uint32_t kMoverCount = 5; //movers shown
+	ClearScreen(); //clear screen
+	std::unique_ptr<HistoryStore> history;
+	if (!history_file_name_.empty()) {
+		try {
+			history.reset(new HistoryStore(history_file_name_));
+		}
+		catch (std::runtime_error&) {} //not written yet, said below
+	}
+	if (history == nullptr || history->day_count() == 0) {
+		std::cout << "No sales history has been recorded. Choose 3 to "
+			<< "record today's." << std::endl;
+	}
+	else {
+		std::string item_name = ValidateInput<std::string>(
+			"Please enter an item to see its sales history: ");
+		int64_t newest = history->newest_day();
+		std::vector<HistoryPoint> points;
+		uint32_t id = history->Find(item_name);
+		if (id != ItemDictionary::kNotFound) {
+			history->ItemHistory(id, newest - kHistoryDays + 1, newest,
+				                 points);
+		}
+		ClearScreen(); //clear screen
+		std::cout << item_name << ", the last " << kHistoryDays
+			<< " days recorded:" << std::endl
+			<< " ======================= " << std::endl
+			<< "|" << std::left << std::setw(12) << "Date" << "	"
+			<< std::right << std::setw(8) << "Quantity" << "|" << std::endl
+			<< "|=======================|" << std::endl;
+		for (const HistoryPoint& point : points) {
+			std::cout << "|" << std::left << std::setw(12)
+				<< FormatIsoDate(point.day) << "	" << std::right
+				<< std::setw(8) << point.count << "|" << '\n';
+		}
+		std::cout << "|-----------------------|" << std::endl;
+
+		std::vector<HistoryMover> movers;
+		history->TopMovers(newest, kMoverCount, movers);
+		std::cout << "Biggest changes, the week up to "
+			<< FormatIsoDate(newest) << " against the week before:"
+			<< std::endl;
+		for (const HistoryMover& mover : movers) {
+			std::cout << "  " << std::left << std::setw(12)
+				<< history->Name(mover.id) << std::right << std::setw(8)
+				<< mover.last_week << " -> " << mover.this_week << '\n';
+		}
+		std::cout << std::flush;
+	}
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
+
+/*Windows end at the newest timestamp in the log rather than the clock, so
+* a log from earlier in the day still answers for its own last minutes.*/
+void CornerGrocer::CheckRecentItemFrequency() {
+	const TimeWindowCounter* windows = frequency_engine_.time_windows();
+	ClearScreen(); //clear screen
+	if (backend_ != CountingBackend::kNative || windows == nullptr ||
+		!windows->has_times()) {
+		std::cout << "No timestamped sales have been counted." << std::endl;
+	}
+	else {
+		std::string item_name = ValidateInput<std::string>(
+			"Please enter an item to see recent quantity sold: ");
+		int minutes = ValidateInput<int>("How many minutes back?");
+		uint32_t id = frequency_engine_.Items().Find(item_name);
+		int64_t item_qty = id == ItemDictionary::kNotFound ? 0 :
+			windows->WindowCount(id, int64_t(minutes) * 60);
+
+		//the newest bucket's start, as a UTC time of day
+		int64_t newest = windows->newest_time() % 86400;
+		if (newest < 0) { newest += 86400; }
+		ClearScreen(); //clear screen
+		std::cout << item_name << " sold " << item_qty << " in the "
+			<< minutes << " minutes up to " << std::setfill('0')
+			<< std::setw(2) << newest / 3600 << ":" << std::setw(2)
+			<< newest / 60 % 60 << " UTC" << std::setfill(' ') << std::endl;
+		if (int64_t(minutes) * 60 > windows->options().bucket_seconds *
+			windows->options().bucket_count) { //asked past the history kept
+			std::cout << "(only the last "
+				<< windows->options().bucket_seconds *
+				windows->options().bucket_count / 60
+				<< " minutes are kept)" << std::endl;
+		}
+	}
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
+
+const FrequencyTable& CornerGrocer::CountedItems() const {
+	if (backend_ == CountingBackend::kApproximate) {
+		return sketch_engine_.Report().Items();
+	}
+	return backend_ == CountingBackend::kNative ? frequency_engine_.Items() :
+		python_counts_;
+}
+
+/*This function returns the quantity sold of item_name, or -1 if it wasn't
+* sold today. The Python backend calls ProduceManager's
+* returnProduceFrequency method, the native backend uses the hash table and
+* the approximate backend estimates. */
+int64_t CornerGrocer::LookupItemFrequency(const std::string& item_name) {
+	CORNER_GROCER_TIME_STAGE(kLookup);
+	CORNER_GROCER_COUNT(kItemsLookedUp, 1);
+	if (backend_ == CountingBackend::kNative) {
+		return frequency_engine_.ItemFrequency(item_name);
+	}
+	if (backend_ == CountingBackend::kApproximate) {
+		return sketch_engine_.ItemFrequency(item_name);
+	}
+
+	//Python's counts were copied across after ingest, look the name up there
+	uint32_t id = python_counts_.Find(item_name);
+	return id != ItemDictionary::kNotFound ? python_counts_.Count(id) : -1;
+}
+
+/*native lookups go to the engine as one batch. Python lookups are answered
+* from the copy of Python's table, one hash probe per name.*/
+std::vector<int64_t> CornerGrocer::LookupItemFrequencies(
+	const std::vector<std::string>& item_names) {
+	CORNER_GROCER_TIME_STAGE(kLookup); //one call, however many names
+	CORNER_GROCER_COUNT(kItemsLookedUp, item_names.size());
+	std::vector<int64_t> item_qtys; //one quantity per requested name
+	if (backend_ != CountingBackend::kPython) {
+		//views of the caller's strings, nothing is copied
+		std::vector<std::string_view> names(item_names.begin(),
+			                                item_names.end());
+		if (backend_ == CountingBackend::kNative) {
+			frequency_engine_.ItemFrequencies(names, item_qtys);
+		}
+		else {
+			sketch_engine_.ItemFrequencies(names, item_qtys);
+		}
+		return item_qtys;
+	}
+	item_qtys.reserve(item_names.size());
+	for (const std::string& item_name : item_names) {
+		uint32_t id = python_counts_.Find(item_name);
+		item_qtys.push_back(id != ItemDictionary::kNotFound ?
+			                python_counts_.Count(id) : -1);
+	}
+	return item_qtys;
+}
+
+/*This function starts writing item names and item quantities from input
+* file to the output file, in the format "<itemName> <itemQty>\n", on
+* background_. The Python backend calls ProduceManager's writeFrequencyFile
+* method. A file half written is worse than none, so writing is never
+* stopped part way; exiting waits for it. */
+void CornerGrocer::WriteFrequencyFile() {
+	FinishBackground(); //nothing else may be running
+	background_job_ = BackgroundJob::kExport;
+	if (backend_ == CountingBackend::kPython) {
+		background_.Start("Writing " + output_file_name_ + " in Python",
+			              [this](TaskProgress&) {
+			{
+				ScopedGil gil; //the menu never holds it
+				CallObjectMethod<void>(produce_manager_instance_,
+					                   *"writeFrequencyFile");
+			}
+			RecordHistory(); //from python_counts_, without Python
+		});
+		return;
+	}
+	//tell the user which file to look for, like the Python version does
+	std::cout << "File Name: " << output_file_name_ << std::endl;
+	background_.Start("Writing " + output_file_name_,
+		              [this](TaskProgress&) {
+		//the approximate backend writes its best sellers' estimates
+		const FrequencyEngine& engine =
+			backend_ == CountingBackend::kApproximate ?
+			sketch_engine_.Report() : frequency_engine_;
+		engine.WriteFrequencyFile(output_file_name_, output_format_);
+		RecordHistory();
+	});
+}
+
+void CornerGrocer::RecordHistory() {
+	if (history_file_name_.empty() ||
+		backend_ == CountingBackend::kApproximate) {
+		return;
+	}
+	AppendHistoryDay(history_file_name_, CurrentDay(), CountedItems());
+}
+
+/*errors are printed here, on the menu's thread, rather than by the job, so
+* they never land in the middle of whatever the menu is showing*/
+void CornerGrocer::FinishBackground() {
+	std::string error = background_.Wait(); //what the job threw, if anything
+	if (!error.empty()) { std::cerr << error << std::endl; }
+	background_job_ = BackgroundJob::kNone;
+}
+
+/*counting changes what every option but 4, 11 and 12 reads, so they all
+* wait for it. Writing only reads the counts, so only what changes them
+* (5, 6), another write (3), the history it adds to (12) and anything
+* needing Python, which the writer holds, waits for that.*/
+bool CornerGrocer::WaitingOnBackground(int choice) {
+	if (!background_.running() || choice == 4 || choice == 11 ||
+		(choice == 12 && background_job_ == BackgroundJob::kIngest)) {
+		return false;
+	}
+	if (background_job_ == BackgroundJob::kExport && choice != 3 &&
+		choice != 5 && choice != 6 && choice != 12 &&
+		!(choice == 1 && backend_ == CountingBackend::kPython)) {
+		return false;
+	}
+	ClearScreen(); //clear screen
+	std::cout << "Still busy: " << background_.Describe() << std::endl
+		<< "That option can be chosen once it is done. Choose 11 to see "
+		<< "timings, or 4 to\nstop and exit." << std::endl;
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+	return true;
+}
+
+/*This function counts the input file with both backends and compares them.
+* Every native item is looked up in the copy of Python's dictionary, and the 
+* number of distinct items is compared, so an item only Python found is also
+* caught. Python counts on background_, like every other count, while the
+* native count runs here.*/
+void CornerGrocer::CompareBackends() {
+	FinishBackground(); //nothing else may be running
+	background_job_ = BackgroundJob::kIngest;
+	StartPythonCount(); //count the file as it is now in Python
+
+	//count natively into a separate engine, so the live one is untouched
+	FrequencyEngine native_engine;
+	try {
+		native_engine.CountFile(input_file_name_);
+	}
+	catch (std::runtime_error& error) { //file missing or couldn't be mapped
+		FinishBackground();
+		std::cerr << error.what() << std::endl;
+		return;
+	}
+	FinishBackground(); //Python's counts are needed from here on
+
+	int mismatches = 0; //number of items whose counts disagree
+	const FrequencyTable& items = native_engine.Items();
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		uint32_t python_id = python_counts_.Find(items.Name(id));
+		int64_t python_qty = python_id != ItemDictionary::kNotFound ?
+			python_counts_.Count(python_id) : -1;
+		if (python_qty != items.Count(id)) { //counts disagree, report it
+			std::cout << items.Name(id) << ": native " << items.Count(id)
+				<< ", python " << python_qty << std::endl;
+			++mismatches;
+		}
+	}
+
+	//an item only Python found shows up as a difference in item counts
+	if (python_counts_.size() != items.size()) {
+		std::cout << "Distinct items: native " << items.size()
+			<< ", python " << python_counts_.size() << std::endl;
+		++mismatches;
+	}
+	if (mismatches == 0) {
+		std::cout << "Native and Python counts match for all "
+			<< items.size() << " items." << std::endl;
+	}
+	std::cout << "Press Enter to continue..."; //pause for input
+	std::cin.get(); //get whatever the user typed on the buffer
+	std::cin.ignore(0); //discard EOF
+	ClearScreen(); //clear screen
+}
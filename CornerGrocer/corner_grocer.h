@@ -15,7 +15,19 @@
 #ifndef CORNER_GROCER_H
 #define CORNER_GROCER_H
 #include "python_functions.h"
+#include "background_task.h"
+#include "checkpoint.h"
+#include "frequency_engine.h"
+#include "frequency_file.h"
+#include "histogram.h"
+#include "history_store.h"
+#include "item_search.h"
+#include "log_follower.h"
+#include "ranking.h"
+#include "sketch_engine.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 /*This class is the "application" class so to speak- it manages the results 
 * between this program and python, holds and validates data, and manages 
@@ -26,8 +38,11 @@ public:
 	* But in case the default constructor is called, functions have been
 	* provided to allow users to set the input and output filenames. Once this
 	* is done you MUST call "CallClassConstructor" from python_functions.cpp
-	* in order for this program to work! */
-	CornerGrocer(const char* input_file_name, const char* output_file_name);
+	* in order for this program to work! The backend argument chooses whether
+	* the input file is counted by ProduceManager.py (the reference
+	* implementation) or natively by FrequencyEngine. */
+	CornerGrocer(const char* input_file_name, const char* output_file_name,
+		         CountingBackend backend = CountingBackend::kPython);
 	CornerGrocer();
 
 	/*These functions set the class' input_file_name  and output_file_name 
@@ -36,6 +51,47 @@ public:
 	void SetInputFileName(std::string fileName);
 	void SetOutputFileName(std::string fileName);
 
+	/*This function sets how many threads the native and approximate
+	* backends use to count the input file. 0 uses one thread per core, 1
+	* counts serially. Has no effect on the Python backend, which always
+	* counts on one thread.*/
+	void SetIngestThreads(unsigned thread_count);
+
+	/*This function sets the format the native backend writes the output file
+	* in. kText (the default) writes frequency.dat style text, kBinary the
+	* memory mappable format described in frequency_file.h. The Python
+	* backend always writes text.*/
+	void SetOutputFormat(FrequencyFileFormat format);
+
+	/*This function sets how option 3 draws its histogram: how wide (the
+	* terminal's width by default), in what order, and whether only the top
+	* best sellers are shown. See histogram.h for every option.*/
+	void SetHistogramOptions(const HistogramOptions& options);
+
+	/*This function makes the native backend keep time buckets for
+	* timestamped sales lines (see time_window.h), so option 10 can say how
+	* many of an item sold recently. Call it before Application.*/
+	void SetTimeWindows(const TimeWindowOptions& options);
+
+	/*This function makes the native backend save its counts to a snapshot
+	* file (see checkpoint.h) every time it counts or refreshes, and load
+	* the snapshot when it starts, so only sales logged since are read.
+	* Call it before Application. An empty name (the default) turns
+	* snapshots off.*/
+	void SetCheckpointFile(const std::string& file_name);
+
+	/*This function makes option 3 also record the day's counts in a
+	* history file (see history_store.h) every time it writes the output
+	* file, so option 12 can show how sales went on earlier days. The
+	* approximate backend's estimates aren't recorded. An empty name (the
+	* default) turns the history off.*/
+	void SetHistoryFile(const std::string& file_name);
+
+	/*This function sets how much memory the approximate backend counts in,
+	* which decides how close its estimates are (see sketch_engine.h). Call
+	* it before Application; counts already estimated are forgotten.*/
+	void SetSketchOptions(const SketchOptions& options);
+
 	/*This function, depending on how it is called, will return either an int 
 	* or a string in either case, it will use a regex to verify the data 
 	* matches the return type.*/
@@ -44,8 +100,18 @@ public:
 	/*This function prompts python to check its data for the quantity 
 	* associated with an item name. See python_functions.cpp for implementation
 	* details. This function then prints a slightly prettified text output that
-	* displays the requested item and number sold that day to the user.*/
+	* displays the requested item and number sold that day to the user. Names
+	* are matched ignoring case and spacing, and if none matches, the items
+	* with words starting with what was typed are shown (see item_search.h).*/
 	void CheckSingleItemFrequency();
+
+	/*This function returns the quantity sold of every item in item_names, in
+	* the same order, with -1 for items that weren't sold. The native backend
+	* answers the whole batch from its hash index in one call. The Python 
+	* backend answers from python_counts_, Python's table copied across once
+	* after ingest.*/
+	std::vector<int64_t> LookupItemFrequencies(
+		const std::vector<std::string>& item_names);
 	
 	//This function clears the screen upon request by printing 40 endls
 	void ClearScreen();
@@ -60,10 +126,103 @@ public:
 
 	/*This function prints a slightly prettified histogram in text format,
 	* graphically displaying the items sold that day and quantity sold.
-	* takes the name of an input file as an argument. */
+	* takes the name of an input file as an argument, which may be either a
+	* text or a binary frequency file. */
 	void PrintFrequencyHistogram(std::string &dataFile);
 
+	/*These functions draw the same histogram from counts already in memory,
+	* or from a mapped binary frequency file, so the chart never has to 
+	* re-parse text.*/
+	void RenderFrequencyHistogram(const FrequencyTable& item_counts);
+	void RenderFrequencyHistogram(const FrequencyFileView& item_counts);
+
+	/*This function counts the input file with both backends and reports any
+	* item whose native count differs from the Python reference count. */
+	void CompareBackends();
+
+	/*This function adds the sales appended to the input file since it was
+	* last read to the counts, without recounting the whole file, and tells
+	* the user how many were found. A rotated or truncated log is read again
+	* from the top, see log_follower.h. */
+	void RefreshItemFrequencies();
+
+	/*This function asks how many items (for kTop and kBottom) or what
+	* quantity (for kAbove), then prints the best sellers, worst sellers or
+	* items that sold more than that quantity, ranked, in the same table
+	* PrintAllItemFrequencies uses. See ranking.h for how they are picked. */
+	void PrintRankedItems(RankKind kind);
+
+	/*This function asks for an item and a number of minutes, then prints how
+	* many of that item sold in those last minutes of timestamped sales.
+	* Only the native backend keeps time buckets. */
+	void CheckRecentItemFrequency();
+
+	/*This function prints how long each instrumented stage of the program
+	* has taken so far, and the bytes and items behind it (see metrics.h),
+	* then waits for Enter. */
+	void PrintTimingStatistics();
+
+	/*This function asks for an item, then prints how many of it sold on
+	* each day recorded in the history over the last 90, and the items whose
+	* sales changed the most from the week before. */
+	void PrintSalesHistory();
+
 private:
+	//which kind of job background_ was last given
+	enum class BackgroundJob { kNone, kIngest, kExport };
+
+	/*Application's menu loop, run without the GIL. Returns when the user
+	* chooses option 4, with background_ stopped.*/
+	void RunMenu();
+
+	/*These functions hide which backend is in use from Application. Each one
+	* either calls the matching ProduceManager method or does the same work
+	* with frequency_engine_. Counting and writing the output file run on
+	* background_, so they return straight away. */
+	void CountItemFrequencies();
+	void PrintAllItemFrequencies();
+	int64_t LookupItemFrequency(const std::string& item_name);
+	void WriteFrequencyFile();
+
+	/*the counts in use: frequency_engine_'s, the sketch's heavy hitters, or
+	* the copy of Python's*/
+	const FrequencyTable& CountedItems() const;
+
+	/*Counts the input file in Python from scratch, then copies Python's
+	* counts across. Used by both backends. Needs the GIL. */
+	void CountPythonFrequencies();
+
+	/*Starts CountPythonFrequencies on background_, taking the GIL there.
+	* The caller sets background_job_.*/
+	void StartPythonCount();
+
+	//indexes CountedItems() for searching, after every count or refresh
+	void RebuildSearchIndex();
+
+	/*waits for background_'s job, if there is one, and prints whatever
+	* error it ran into*/
+	void FinishBackground();
+
+	/*returns true, after telling the user what is still running and how
+	* far it has got, if menu option choice can't run until background_'s
+	* job is done*/
+	bool WaitingOnBackground(int choice);
+
+	/*saves frequency_engine_ to checkpoint_file_name_, if it is set,
+	* reporting rather than throwing if the snapshot can't be written*/
+	void SaveCheckpoint();
+
+	/*appends CountedItems() to history_file_name_, if it is set, as
+	* today's counts. Throws like AppendHistoryDay.*/
+	void RecordHistory();
+
+	/*Draws the histogram for any source of rows with size(), Name(row) and
+	* Count(row). Both public RenderFrequencyHistogram overloads forward 
+	* here.*/
+	template<typename RowSource> void RenderHistogramRows(
+		const RowSource& item_counts);
+
+
 	//this function simply sets the filename to be used as an input
 	std::string input_file_name_;
 	
@@ -74,5 +233,45 @@ private:
 	* handles itself, and will be cleaned up when FinalizePython is called. 
 	* (This is done automatically when the user selects option 4.*/
 	PyObject* produce_manager_instance_;
+
+	//which implementation counts, looks up and writes item frequencies
+	CountingBackend backend_ = CountingBackend::kPython;
+
+	//native counts, only filled in when backend_ is kNative
+	FrequencyEngine frequency_engine_;
+
+	//estimated counts, only filled in when backend_ is kApproximate
+	SketchEngine sketch_engine_;
+
+	/*reads the input file into frequency_engine_, remembering how far it got
+	* so a refresh only reads new sales. Made when the file is first counted.*/
+	std::unique_ptr<LogFollower> log_follower_;
+
+	//snapshot of frequency_engine_, empty when snapshots are off
+	std::string checkpoint_file_name_;
+
+	//every day's counts, empty when the history is off
+	std::string history_file_name_;
+
+	//format the native backend writes output_file_name_ in
+	FrequencyFileFormat output_format_ = FrequencyFileFormat::kText;
+
+	/*ProduceManager's whole dictionary, fetched in one bulk call right after
+	* Python counts (see FetchFrequencyTable). Counts don't change after 
+	* ingest, so lookups are served from here without crossing into Python.*/
+	FrequencyTable python_counts_;
+
+	//draws every histogram, keeping its buffer between charts
+	HistogramRenderer histogram_renderer_;
+
+	//every counted item's name, normalized, for option 2's search
+	ItemSearchIndex search_index_;
+
+	//what background_ is doing, so the menu knows which options can run
+	BackgroundJob background_job_ = BackgroundJob::kNone;
+
+	/*counts and writes the output file while the menu carries on. Declared
+	* last, so it is stopped before anything its job uses is destroyed.*/
+	BackgroundTask background_;
 };
 #endif
\ No newline at end of file
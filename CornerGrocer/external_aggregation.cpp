@@ -0,0 +1,399 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * External Aggregation definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "external_aggregation.h"
+#include "compressed_input.h"
+#include "item_dictionary.h"
+#include "metrics.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+//smallest and largest piece of input counted between checks of the table
+const std::size_t kMinimumPieceBytes = 64 * 1024;
+const std::size_t kMaximumPieceBytes = std::size_t(4) << 20;
+
+/*times a run may be split, each split giving its items fresh bits of the
+* hash. Past this, the budget is too small for a handful of items.*/
+const uint32_t kMaximumSplitLevel = 8;
+
+//bytes before a run record's name: its count, revenue and name's size
+const std::size_t kRecordHeaderBytes = 2 * sizeof(int64_t) +
+	sizeof(uint32_t);
+
+/*the run an item goes to at level. The name hash is put through
+* splitmix64's finalizer, as the sketch does, seeded with the level so a
+* split spreads the items of one run over all of its new ones.*/
+uint32_t RunOf(uint64_t hash, uint32_t level, uint32_t run_count) {
+	hash += (uint64_t(level) + 1) * 0x9e3779b97f4a7c15ULL;
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+	return static_cast<uint32_t>(hash % run_count);
+}
+
+//appends one item's record to run and returns its size in bytes
+uint64_t WriteRecord(std::ofstream& run, std::string_view name,
+	                 int64_t count, int64_t cents) {
+	uint32_t name_size = static_cast<uint32_t>(name.size());
+	run.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	run.write(reinterpret_cast<const char*>(&cents), sizeof(cents));
+	run.write(reinterpret_cast<const char*>(&name_size), sizeof(name_size));
+	run.write(name.data(), name.size());
+	return kRecordHeaderBytes + name.size();
+}
+
+/*opens run_count runs, named file_name + "_0" on, for writing. Throws if
+* one can't be created.*/
+void OpenRuns(const std::string& file_name, uint32_t run_count,
+	          std::vector<std::ofstream>& runs) {
+	runs.clear();
+	runs.reserve(run_count);
+	for (uint32_t i = 0; i < run_count; ++i) {
+		std::string run_name = file_name + "_" + std::to_string(i);
+		runs.emplace_back(run_name, std::ios::out | std::ios::binary |
+			              std::ios::trunc);
+		if (!runs.back().is_open()) {
+			throw std::runtime_error("Error creating File: " + run_name);
+		}
+	}
+}
+
+//flushes and closes every run, throwing if any write failed
+void CloseRuns(const std::string& file_name,
+	           std::vector<std::ofstream>& runs) {
+	for (std::ofstream& run : runs) { run.close(); }
+	for (const std::ofstream& run : runs) {
+		if (!run) {
+			throw std::runtime_error("Error writing File: " + file_name);
+		}
+	}
+	runs.clear();
+}
+
+/*reads file_name a buffer of buffer_bytes at a time and calls visit with
+* each record's name, count and revenue, stopping early if visit returns
+* false. Returns false if it did. Throws if the file can't be read or ends
+* part way through a record.*/
+template <typename Visit>
+bool ReadRun(const std::string& file_name, std::size_t buffer_bytes,
+	         Visit visit) {
+	std::ifstream input(file_name, std::ios::in | std::ios::binary);
+	if (!input.is_open()) {
+		throw std::runtime_error("Error opening File: " + file_name);
+	}
+	std::string buffer; //read but not visited yet, from a record's start
+	std::size_t at = 0; //start of the first record not visited
+	for (bool more = true; more;) {
+		buffer.erase(0, at);
+		at = 0;
+		std::size_t kept = buffer.size();
+		buffer.resize(kept + buffer_bytes);
+		input.read(&buffer[kept], buffer_bytes);
+		buffer.resize(kept + static_cast<std::size_t>(input.gcount()));
+		if (input.bad()) {
+			throw std::runtime_error("Error reading File: " + file_name);
+		}
+		more = !input.eof();
+
+		while (buffer.size() - at >= kRecordHeaderBytes) {
+			int64_t count;
+			int64_t cents;
+			uint32_t name_size;
+			const char* record = buffer.data() + at;
+			std::memcpy(&count, record, sizeof(count));
+			std::memcpy(&cents, record + sizeof(count), sizeof(cents));
+			std::memcpy(&name_size, record + 2 * sizeof(int64_t),
+				        sizeof(name_size));
+			if (buffer.size() - at - kRecordHeaderBytes < name_size) {
+				break; //the rest of the name is in the next read
+			}
+			if (!visit(std::string_view(record + kRecordHeaderBytes,
+				                        name_size), count, cents)) {
+				return false;
+			}
+			at += kRecordHeaderBytes + name_size;
+		}
+	}
+	if (at != buffer.size()) {
+		throw std::runtime_error("Damaged spill File: " + file_name);
+	}
+	return true;
+}
+}  // namespace
+
+/*a piece is a 64th of the budget, within limits, and the table gets a
+* quarter of it, see the header*/
+ExternalAggregator::ExternalAggregator(
+	const ExternalAggregationOptions& options) : options_(options) {
+	options_.memory_budget = std::max<uint64_t>(options_.memory_budget,
+		                                        uint64_t(1) << 20);
+	options_.partition_count = std::max<uint32_t>(options_.partition_count,
+		                                          2);
+	piece_bytes_ = static_cast<std::size_t>(std::clamp<uint64_t>(
+		options_.memory_budget / 64, kMinimumPieceBytes, kMaximumPieceBytes));
+	table_limit_ = static_cast<std::size_t>(options_.memory_budget / 4);
+}
+
+ExternalAggregator::~ExternalAggregator() {
+	runs_.clear(); //closed before their folder goes
+	if (!spill_folder_.empty()) {
+		std::error_code error; //nothing to be done about it here
+		std::filesystem::remove_all(spill_folder_, error);
+	}
+}
+
+/*plain text is read with a buffer, carrying an unfinished last line over
+* to the next read, much as LogFollower does*/
+void ExternalAggregator::CountFile(const std::string& file_name) {
+	std::ifstream input(file_name, std::ios::in | std::ios::binary);
+	if (!input.is_open()) {
+		throw std::runtime_error("Error opening File: " + file_name);
+	}
+	char magic[4]; //enough to tell gzip and zstd apart from text
+	input.read(magic, sizeof(magic));
+	if (DetectCompression(magic, static_cast<std::size_t>(input.gcount())) !=
+		InputCompression::kNone) {
+		input.close();
+		DecompressingReader reader(file_name, 0, piece_bytes_);
+		for (std::string_view lines; reader.Next(lines);) {
+			CountBuffer(lines.data(), lines.size());
+		}
+		return;
+	}
+	input.clear(); //a file shorter than magic has set eof
+	input.seekg(0);
+
+	std::string piece; //read but not counted yet, from a line's start
+	for (bool more = true; more;) {
+		std::size_t kept = piece.size();
+		piece.resize(kept + piece_bytes_);
+		input.read(&piece[kept], piece_bytes_);
+		piece.resize(kept + static_cast<std::size_t>(input.gcount()));
+		if (input.bad()) {
+			throw std::runtime_error("Error reading File: " + file_name);
+		}
+		more = !input.eof();
+		std::size_t complete = piece.size(); //all of it, at the end
+		if (more) {
+			std::size_t last_newline = piece.rfind('\n');
+			complete = last_newline == std::string::npos ? 0 :
+				last_newline + 1;
+		}
+		CountBuffer(piece.data(), complete);
+		piece.erase(0, complete);
+	}
+}
+
+//cut at line ends like CountFileInPieces, the table checked after each
+void ExternalAggregator::CountBuffer(const char* data, std::size_t size) {
+	std::string_view rest(data, size); //not counted yet
+	while (!rest.empty()) {
+		std::size_t piece = rest.size();
+		if (piece > piece_bytes_) {
+			//up to the last line end that fits, or the first if none does
+			piece = rest.rfind('\n', piece_bytes_ - 1);
+			if (piece == std::string_view::npos) {
+				piece = rest.find('\n', piece_bytes_);
+			}
+			piece = piece == std::string_view::npos ? rest.size() : piece + 1;
+		}
+		engine_.CountBuffer(rest.data(), piece);
+		rest.remove_prefix(piece);
+		if (TableBytes() > table_limit_) { Spill(); }
+	}
+}
+
+/*the runs are opened by the first spill and stay open until Finish, so a
+* spill is one pass over the table, appending a record to a run per item*/
+void ExternalAggregator::Spill() {
+	CORNER_GROCER_TIME_STAGE(kSpill);
+	const FrequencyTable& items = engine_.Items();
+	if (items.size() == 0) { return; }
+	if (runs_.empty()) {
+		OpenRuns(SpillFolder() + "/run", options_.partition_count, runs_);
+	}
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		uint32_t run = RunOf(items.dictionary().NameHash(id), 0,
+			                 options_.partition_count);
+		spilled_bytes_ += WriteRecord(runs_[run], items.Name(id),
+			                          items.Count(id), items.Revenue(id));
+	}
+	++spill_count_;
+	ResetTable();
+}
+
+/*with nothing spilled, the table still holds everything and is written as
+* it is. Otherwise what is left in it is spilled too, so every item is in
+* exactly one run, and the runs are added up one after another.*/
+void ExternalAggregator::Finish(const std::string& output_file,
+	                            const std::vector<std::string_view>& item_names,
+	                            std::vector<int64_t>& item_qtys,
+	                            std::vector<int64_t>& item_revenue) {
+	item_qtys.assign(item_names.size(), -1);
+	item_revenue.assign(item_names.size(), -1);
+	items_ = 0;
+	units_ = 0;
+	revenue_ = 0;
+	std::ofstream output; //stays closed without an output file
+	if (!output_file.empty()) {
+		//binary mode, so Windows doesn't turn "\n" into "\r\n"
+		output.open(output_file, std::ios::out | std::ios::binary);
+		if (!output.is_open()) {
+			throw std::runtime_error("Error creating File: " + output_file);
+		}
+	}
+
+	if (spill_count_ == 0) {
+		EmitTable(output, item_names, item_qtys, item_revenue);
+	}
+	else {
+		Spill();
+		CloseRuns(SpillFolder(), runs_);
+		for (uint32_t run = 0; run < options_.partition_count; ++run) {
+			AggregateRun(SpillFolder() + "/run_" + std::to_string(run), 0,
+				         output, item_names, item_qtys, item_revenue);
+		}
+	}
+	ResetTable();
+
+	if (output.is_open()) {
+		output.close();
+		if (!output) {
+			throw std::runtime_error("Error writing File: " + output_file);
+		}
+	}
+}
+
+/*the run is added up record by record, watching the table. If it grows
+* past the limit, what was added is thrown away and the run is split by
+* the next level's bits instead, then each new run added up in its place.
+* Runs are deleted once added up, so the disk used shrinks as it goes.*/
+void ExternalAggregator::AggregateRun(
+	const std::string& file_name, uint32_t level, std::ofstream& output,
+	const std::vector<std::string_view>& item_names,
+	std::vector<int64_t>& item_qtys, std::vector<int64_t>& item_revenue) {
+	ResetTable();
+	bool fits = ReadRun(file_name, piece_bytes_,
+		                [this](std::string_view name, int64_t count,
+			                   int64_t cents) {
+		engine_.Add(name, count, cents);
+		return TableBytes() <= table_limit_;
+	});
+	if (fits) {
+		EmitTable(output, item_names, item_qtys, item_revenue);
+		std::filesystem::remove(file_name);
+		return;
+	}
+
+	ResetTable();
+	if (level + 1 >= kMaximumSplitLevel) {
+		throw std::runtime_error("Memory budget too small for the items in "
+			                     "File: " + file_name);
+	}
+	CORNER_GROCER_TIME_STAGE(kSpill);
+	std::vector<std::ofstream> runs; //this run's share of each new one
+	OpenRuns(file_name, options_.partition_count, runs);
+	ReadRun(file_name, piece_bytes_,
+		    [&](std::string_view name, int64_t count, int64_t cents) {
+		uint32_t run = RunOf(ItemDictionary::Hash(name), level + 1,
+			                 options_.partition_count);
+		spilled_bytes_ += WriteRecord(runs[run], name, count, cents);
+		return true;
+	});
+	CloseRuns(file_name, runs);
+	++split_count_;
+	std::filesystem::remove(file_name);
+	for (uint32_t run = 0; run < options_.partition_count; ++run) {
+		AggregateRun(file_name + "_" + std::to_string(run), level + 1, output,
+			         item_names, item_qtys, item_revenue);
+	}
+}
+
+/*the lines are the same as FrequencyEngine::WriteFrequencyFile's, built
+* in one string per table and written with one call*/
+void ExternalAggregator::EmitTable(
+	std::ofstream& output, const std::vector<std::string_view>& item_names,
+	std::vector<int64_t>& item_qtys, std::vector<int64_t>& item_revenue) {
+	const FrequencyTable& items = engine_.Items();
+	if (output.is_open()) {
+		CORNER_GROCER_TIME_STAGE(kFileWrite);
+		std::string contents; //this table's lines
+		char qty_text[24]; //big enough for any 64 bit integer
+		for (uint32_t id = 0; id < items.size(); ++id) {
+			std::string_view name = items.Name(id);
+			contents.append(name.data(), name.size());
+			contents.push_back(' ');
+			char* qty_end = std::to_chars(qty_text,
+				                          qty_text + sizeof(qty_text),
+				                          items.Count(id)).ptr;
+			contents.append(qty_text, qty_end - qty_text);
+			contents.push_back('\n');
+		}
+		output.write(contents.data(), contents.size());
+		CORNER_GROCER_COUNT(kBytesWritten, contents.size());
+	}
+
+	//each item is in one table only, so a name is found at most once
+	for (std::size_t i = 0; i < item_names.size(); ++i) {
+		uint32_t id = items.Find(item_names[i]);
+		if (id != ItemDictionary::kNotFound) {
+			item_qtys[i] = items.Count(id);
+			item_revenue[i] = items.Revenue(id);
+		}
+	}
+	items_ += items.size();
+	units_ += items.TotalUnits();
+	revenue_ += items.TotalRevenue();
+}
+
+/*Clear would keep the arrays at the size that crossed the limit, and the
+* limit would be crossed again by the first piece after*/
+void ExternalAggregator::ResetTable() { engine_ = FrequencyEngine(); }
+
+std::size_t ExternalAggregator::TableBytes() {
+	std::size_t bytes = engine_.Items().memory_bytes();
+	peak_bytes_ = std::max(peak_bytes_, bytes);
+	return bytes;
+}
+
+/*named after the clock, with a number added until the name is free, so
+* runs from two programs spilling at once never meet*/
+const std::string& ExternalAggregator::SpillFolder() {
+	if (!spill_folder_.empty()) { return spill_folder_; }
+	std::filesystem::path parent = options_.spill_directory;
+	std::error_code error;
+	if (parent.empty()) {
+		parent = std::filesystem::temp_directory_path(error);
+		if (error) { parent = "."; }
+	}
+	std::string stem = "corner_grocer_spill_" + std::to_string(
+		std::chrono::steady_clock::now().time_since_epoch().count());
+	for (unsigned attempt = 0; attempt < 100; ++attempt) {
+		std::filesystem::path folder = parent /
+			(stem + "_" + std::to_string(attempt));
+		if (std::filesystem::create_directory(folder, error)) {
+			spill_folder_ = folder.string();
+			return spill_folder_;
+		}
+	}
+	throw std::runtime_error("Error creating spill folder in: " +
+		                     parent.string());
+}
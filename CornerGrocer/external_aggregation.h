@@ -0,0 +1,157 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * External Aggregation header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef EXTERNAL_AGGREGATION_H
+#define EXTERNAL_AGGREGATION_H
+#include "frequency_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* This file counts exactly, like FrequencyEngine, logs with more distinct
+* items than fit in memory, such as keys made of SKU, store and lot. Lines
+* are counted into an ordinary FrequencyTable until it has more than a
+* quarter of the memory budget allocated. Then every item in it is spilled:
+* written, with its count and revenue, to one of a number of run files
+* picked by a hash of its name, and the table is thrown away, memory and
+* all, for the lines that follow.
+*
+* An item can be spilled many times, but always to the same run, so once
+* the input is done each run can be added up on its own, and the runs
+* together hold every item exactly once. Runs are added up one at a time
+* into the same table, and each one's items written to the frequency file
+* before the next is read. A run that still doesn't fit is split again,
+* with fresh bits of the hash, into runs of its own.
+*
+* The table is checked after every piece of input, a 64th of the budget.
+* Its arrays grow by doubling, so the piece that crosses the line leaves
+* it with at most half the budget, and the arrays it was copied out of
+* still fit in the rest while it grows. Input and runs are read through
+* buffers of a piece at a time rather than mapped, so they don't pile up in
+* memory either. Compressed input is decompressed into buffers that size,
+* though the compressed file itself is mapped by the reader.
+*
+* If nothing had to be spilled, the frequency file is the same as
+* FrequencyEngine's. Otherwise items are written run by run, each in the
+* order it was first seen in its run, rather than in the order first seen
+* in the input. */
+
+//how much memory ExternalAggregator may use, and where it spills to
+struct ExternalAggregationOptions {
+	uint64_t memory_budget = uint64_t(256) << 20; //bytes, at least 1 MiB
+	std::string spill_directory; //empty for the system's temporary folder
+	uint32_t partition_count = 64; //runs written by a spill, or a split
+};
+
+class ExternalAggregator {
+public:
+	/*the run files are made in a folder of their own, created inside
+	* options.spill_directory by the first spill*/
+	explicit ExternalAggregator(
+		const ExternalAggregationOptions& options =
+			ExternalAggregationOptions());
+
+	//deletes the spill folder and every run in it
+	~ExternalAggregator();
+
+	//an aggregator owns open run files, and a folder it deletes
+	ExternalAggregator(const ExternalAggregator&) = delete;
+	ExternalAggregator& operator=(const ExternalAggregator&) = delete;
+
+	/*counts every line of file_name a piece at a time, decompressing a
+	* gzip or zstd file as it goes. Throws std::runtime_error if the file
+	* can't be read, or a run can't be written.*/
+	void CountFile(const std::string& file_name);
+
+	/*counts every line of an in-memory buffer, the same lines as
+	* FrequencyEngine would, a piece at a time*/
+	void CountBuffer(const char* data, std::size_t size);
+
+	/*adds up every run and writes each item to output_file as a text
+	* frequency file, unless it is empty, and looks item_names up as they
+	* go by: item_qtys and item_revenue get each one's units and cents, -1
+	* if it wasn't sold. Throws std::runtime_error if a file can't be read
+	* or written, or a run won't fit in the budget however often it is
+	* split. Afterwards the aggregator is empty again.*/
+	void Finish(const std::string& output_file,
+		        const std::vector<std::string_view>& item_names,
+		        std::vector<int64_t>& item_qtys,
+		        std::vector<int64_t>& item_revenue);
+
+	//distinct items, units and revenue in cents, once Finish has run
+	uint64_t items() const { return items_; }
+	int64_t units() const { return units_; }
+	int64_t revenue() const { return revenue_; }
+
+	//times the table was written out to the runs, the last one included
+	uint32_t spill_count() const { return spill_count_; }
+
+	//bytes written to runs, by spills and splits
+	uint64_t spilled_bytes() const { return spilled_bytes_; }
+
+	//runs that didn't fit and were split into runs of their own
+	uint32_t split_count() const { return split_count_; }
+
+	//most bytes the table ever had allocated
+	std::size_t peak_bytes() const { return peak_bytes_; }
+
+	uint64_t memory_budget() const { return options_.memory_budget; }
+
+private:
+	/*writes every item in the table to the run its hash picks, opening
+	* the runs first if this is the first spill, and empties the table*/
+	void Spill();
+
+	/*adds up the run in file_name, which was written at level, and writes
+	* and looks up its items, see Finish. Splits it if it doesn't fit.*/
+	void AggregateRun(const std::string& file_name, uint32_t level,
+		              std::ofstream& output,
+		              const std::vector<std::string_view>& item_names,
+		              std::vector<int64_t>& item_qtys,
+		              std::vector<int64_t>& item_revenue);
+
+	/*writes the table's items to output and looks item_names up in it,
+	* then adds it to the totals*/
+	void EmitTable(std::ofstream& output,
+		           const std::vector<std::string_view>& item_names,
+		           std::vector<int64_t>& item_qtys,
+		           std::vector<int64_t>& item_revenue);
+
+	//empties the table and gives back its memory
+	void ResetTable();
+
+	//the table's bytes, remembered if they are the most yet
+	std::size_t TableBytes();
+
+	//the folder runs go in, created the first time it is asked for
+	const std::string& SpillFolder();
+
+	ExternalAggregationOptions options_; //see the constructor
+	std::size_t piece_bytes_; //input counted between checks of the table
+	std::size_t table_limit_; //table bytes that make it spill
+	FrequencyEngine engine_; //the table, and the line parsing into it
+	std::string spill_folder_; //empty until the first spill
+	std::vector<std::ofstream> runs_; //open while spilling, by partition
+	uint64_t items_ = 0; //see items
+	int64_t units_ = 0; //see units
+	int64_t revenue_ = 0; //see revenue
+	uint32_t spill_count_ = 0; //see spill_count
+	uint64_t spilled_bytes_ = 0; //see spilled_bytes
+	uint32_t split_count_ = 0; //see split_count
+	std::size_t peak_bytes_ = 0; //see peak_bytes
+};
+#endif
@@ -0,0 +1,295 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Frequency Engine definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "frequency_engine.h"
+#include "compressed_input.h"
+#include "frequency_file.h"
+#include "line_scanner.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "sales_record.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+/*smallest piece of a file worth giving its own thread. Below this, starting
+* the thread and merging its table costs more than counting the bytes does*/
+const std::size_t kMinimumChunkBytes = 1 << 20;
+}  // namespace
+
+//scans the count array, used to size charts
+int64_t FrequencyTable::LargestCount() const {
+	if (counts_.empty()) { return 0; }
+	return *std::max_element(counts_.begin(), counts_.end());
+}
+
+//adds up the count array
+int64_t FrequencyTable::TotalUnits() const {
+	return std::accumulate(counts_.begin(), counts_.end(), int64_t(0));
+}
+
+int64_t FrequencyTable::TotalRevenue() const {
+	return std::accumulate(revenue_.begin(), revenue_.end(), int64_t(0));
+}
+
+std::size_t FrequencyTable::memory_bytes() const {
+	return dictionary_.memory_bytes() +
+		(counts_.capacity() + revenue_.capacity()) * sizeof(int64_t);
+}
+
+/*adds each of other's items in ID order. The hashes other's dictionary
+* already worked out are reused, so merging never rehashes a name.*/
+void FrequencyTable::Merge(const FrequencyTable& other,
+	                       std::vector<uint32_t>* id_map) {
+	if (id_map != nullptr) { id_map->resize(other.size()); }
+	for (uint32_t id = 0; id < other.size(); ++id) {
+		uint32_t merged_id = dictionary_.Intern(other.Name(id),
+			                                    other.dictionary_.NameHash(id));
+		AddById(merged_id, other.counts_[id]);
+		if (other.Revenue(id) != 0) {
+			AddRevenueById(merged_id, other.Revenue(id));
+		}
+		if (id_map != nullptr) { (*id_map)[id] = merged_id; }
+	}
+}
+
+//empties the table, reusing its memory
+void FrequencyTable::Clear() {
+	dictionary_.Clear();
+	counts_.clear();
+	revenue_.clear();
+}
+
+/*maps the file and hands its bytes to CountBuffer, or for a compressed
+* file, each buffer a DecompressingReader fills while the one before is
+* counted. MappedFile throws if the file is missing, and unmaps on the way
+* out either way.*/
+void FrequencyEngine::CountFile(const std::string& file_name) {
+	MappedFile input(file_name);
+	if (DetectCompression(input.data(), input.size()) !=
+		InputCompression::kNone) {
+		DecompressingReader reader(file_name);
+		for (std::string_view lines; reader.Next(lines);) {
+			CountBuffer(lines.data(), lines.size());
+		}
+		return;
+	}
+	CountBuffer(input.data(), input.size());
+}
+
+//0 asks for one thread per hardware thread, if the library can tell us
+void FrequencyEngine::set_thread_count(unsigned thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::thread::hardware_concurrency();
+	}
+	thread_count_ = thread_count > 0 ? thread_count : 1;
+}
+
+/*decides how many chunks the buffer gets, then either counts it directly or
+* hands one chunk to each thread. Chunk boundaries are pushed forward to just
+* past the next newline, so no line is ever split between two threads. */
+void FrequencyEngine::CountBuffer(const char* data, std::size_t size) {
+	CORNER_GROCER_TIME_STAGE(kIngest);
+	CORNER_GROCER_COUNT(kBytesRead, size);
+	std::size_t chunk_count = thread_count_;
+	if (size / kMinimumChunkBytes < chunk_count) { //too little work to share
+		chunk_count = size / kMinimumChunkBytes;
+	}
+	if (chunk_count <= 1) { //one thread, count straight into the table
+		CountRange(data, data + size, table_, time_windows_.get());
+		return;
+	}
+
+	std::vector<const char*> bounds = SplitAtLines(data, size, chunk_count);
+
+	/*each thread counts its chunk into its own table (and time buckets),
+	* so no locking is needed while counting. Chunk 0 is counted on this
+	* thread.*/
+	std::vector<FrequencyTable> chunk_tables(chunk_count);
+	std::vector<TimeWindowCounter> chunk_windows;
+	if (time_windows_ != nullptr) {
+		chunk_windows.assign(chunk_count,
+			                 TimeWindowCounter(time_windows_->options()));
+	}
+	auto windows_of = [&chunk_windows](std::size_t chunk) {
+		return chunk_windows.empty() ? nullptr : &chunk_windows[chunk];
+	};
+	std::vector<std::thread> workers;
+	for (std::size_t chunk = 1; chunk < chunk_count; ++chunk) {
+		workers.emplace_back(CountRange, bounds[chunk], bounds[chunk + 1],
+			                 std::ref(chunk_tables[chunk]), windows_of(chunk));
+	}
+	CountRange(bounds[0], bounds[1], chunk_tables[0], windows_of(0));
+	for (std::thread& worker : workers) { worker.join(); }
+
+	//merge in chunk order, which keeps first seen order the same as serial
+	for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+		MergeCounts(chunk_tables[chunk], windows_of(chunk));
+	}
+}
+
+/*only builds the ID map when there are time buckets to move across, plain
+* merges stay exactly as they were*/
+void FrequencyEngine::MergeCounts(const FrequencyTable& table,
+	                              const TimeWindowCounter* windows) {
+	if (windows == nullptr || time_windows_ == nullptr) {
+		table_.Merge(table);
+		return;
+	}
+	std::vector<uint32_t> id_map; //table's IDs -> table_'s
+	table_.Merge(table, &id_map);
+	time_windows_->Merge(*windows, id_map);
+}
+
+void FrequencyEngine::EnableTimeWindows(const TimeWindowOptions& options) {
+	time_windows_.reset(new TimeWindowCounter(options));
+}
+
+/*walks the range a line at a time with LineScanner, trims whitespace from
+* both ends without copying, and adds every non-blank line's quantity (one,
+* unless it says otherwise) to its item's count, and its revenue if it has a
+* price. A leading timestamp is split off the name, and the sale put in its
+* time bucket if buckets are being kept. */
+void FrequencyEngine::CountRange(const char* begin, const char* end,
+	                             FrequencyTable& table,
+	                             TimeWindowCounter* time_windows) {
+	LineScanner lines(begin, end - begin);
+	for (std::string_view line; lines.Next(line);) {
+		//trim whitespace from both ends, just like str.strip() in Python
+		std::string_view item_name = TrimWhitespace(line);
+		int64_t seconds = 0; //the line's timestamp, if it has one
+		bool timed = SplitTimestamp(item_name, seconds, item_name);
+		SalesRecord record; //name, quantity and price
+		ParseSalesRecord(item_name, record);
+		if (!record.item_name.empty()) { //blank lines aren't items, skip them
+			uint32_t id = table.Add(record.item_name, record.quantity);
+			if (record.priced) {
+				table.AddRevenueById(id, RecordRevenue(record));
+			}
+			if (timed && time_windows != nullptr) {
+				time_windows->Add(id, seconds, record.quantity);
+			}
+		}
+	}
+}
+
+//looks the name up in the hash table, -1 if missing like the Python version
+int64_t FrequencyEngine::ItemFrequency(std::string_view item_name) const {
+	uint32_t id = table_.Find(item_name);
+	return id != ItemDictionary::kNotFound ? table_.Count(id) : -1;
+}
+
+int64_t FrequencyEngine::ItemRevenue(std::string_view item_name) const {
+	uint32_t id = table_.Find(item_name);
+	return id != ItemDictionary::kNotFound ? table_.Revenue(id) : -1;
+}
+
+/*one hash probe per name, all served from the table built during ingest,
+* so a batch costs the same as that many single lookups minus the calls*/
+void FrequencyEngine::ItemFrequencies(
+	const std::vector<std::string_view>& item_names,
+	std::vector<int64_t>& item_qtys) const {
+	item_qtys.resize(item_names.size());
+	for (std::size_t i = 0; i < item_names.size(); ++i) {
+		uint32_t id = table_.Find(item_names[i]);
+		item_qtys[i] = id != ItemDictionary::kNotFound ? table_.Count(id) : -1;
+	}
+}
+
+/*maps the frequency file. Binary files are read row by row out of the
+* mapping. Text files have each line split at its last space: the name is
+* everything before it, the quantity everything after. Splitting at the last
+* space rather than the first keeps names with spaces in them whole.*/
+void FrequencyEngine::CountFrequencyFile(const std::string& file_name) {
+	MappedFile input(file_name);
+	CORNER_GROCER_COUNT(kBytesRead, input.size());
+	if (IsBinaryFrequencyFile(input.data(), input.size())) {
+		//binary file, nothing to parse, copy each row straight in
+		FrequencyFileView rows(file_name);
+		for (uint32_t row = 0; row < rows.size(); ++row) {
+			table_.Add(rows.Name(row), rows.Count(row));
+		}
+		return;
+	}
+	LineScanner lines(input.data(), input.size());
+	for (std::string_view line; lines.Next(line);) {
+		std::string_view item_name; //everything before the last space
+		std::string_view qty_text; //everything after it
+		if (!SplitLastField(TrimWhitespace(line), item_name, qty_text)) {
+			continue; //no space, so no quantity on this line
+		}
+		int64_t item_qty = 0;
+		if (!ParseInteger(qty_text, item_qty)) {
+			continue; //quantity isn't a whole number, not a frequency line
+		}
+		table_.Add(item_name, item_qty);
+	}
+}
+
+/*builds the whole file in one string and writes it with a single call,
+* rather than one write per item. Quantities are formatted into a stack
+* buffer with to_chars, so nothing is allocated per item.*/
+void FrequencyEngine::WriteFrequencyFile(const std::string& file_name,
+	                                     FrequencyFileFormat format) const {
+	CORNER_GROCER_TIME_STAGE(kFileWrite); //formatting as well as writing
+	if (format == FrequencyFileFormat::kBinary) {
+		WriteBinaryFrequencyFile(table_, file_name);
+		return;
+	}
+	std::string contents; //everything that will go in the file
+	for (uint32_t id = 0; id < table_.size(); ++id) {
+		AppendFrequencyLine(id, contents);
+	}
+	WriteWholeFile(file_name, contents);
+}
+
+//same as above, but only the rows asked for, in the order asked for
+void FrequencyEngine::WriteFrequencyFile(
+	const std::string& file_name, const std::vector<uint32_t>& ids) const {
+	CORNER_GROCER_TIME_STAGE(kFileWrite);
+	std::string contents; //everything that will go in the file
+	for (uint32_t id : ids) { AppendFrequencyLine(id, contents); }
+	WriteWholeFile(file_name, contents);
+}
+
+void FrequencyEngine::AppendFrequencyLine(uint32_t id,
+	                                      std::string& contents) const {
+	char qty_text[24]; //big enough for any 64 bit integer
+	std::string_view name = table_.Name(id);
+	contents.append(name.data(), name.size());
+	contents.push_back(' ');
+	char* qty_end = std::to_chars(qty_text, qty_text + sizeof(qty_text),
+		                          table_.Count(id)).ptr;
+	contents.append(qty_text, qty_end - qty_text);
+	contents.push_back('\n');
+}
+
+void FrequencyEngine::WriteWholeFile(const std::string& file_name,
+	                                 const std::string& contents) {
+	//binary mode, so Windows doesn't turn "\n" into "\r\n" behind our back
+	std::ofstream output(file_name, std::ios::out | std::ios::binary);
+	if (!output.is_open()) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	output.write(contents.data(), contents.size());
+	output.close();
+	if (!output) { //a full disk, say, would otherwise leave it cut short
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+	CORNER_GROCER_COUNT(kBytesWritten, contents.size());
+}
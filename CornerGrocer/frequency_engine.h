@@ -0,0 +1,263 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Frequency Engine header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef FREQUENCY_ENGINE_H
+#define FREQUENCY_ENGINE_H
+#include "item_dictionary.h"
+#include "time_window.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*Selects which implementation counts the input file. kPython keeps the
+* original ProduceManager.py path as a reference implementation, kNative
+* counts in C++ with FrequencyEngine, and kApproximate estimates counts in
+* fixed memory with SketchEngine (see sketch_engine.h). */
+enum class CountingBackend { kPython, kNative, kApproximate };
+
+/*how a frequency file is written: kText is the "<itemName> <itemQty>" lines
+* of frequency.dat, kBinary the memory mappable format in frequency_file.h*/
+enum class FrequencyFileFormat { kText, kBinary };
+
+/*Item quantities keyed on item name. Names are interned by an
+* ItemDictionary, and each item's quantity is stored in a flat array indexed
+* by its ID, so adding to an item that was seen before never allocates.
+* IDs are handed out in the order names are first seen, the same order a
+* Python dict iterates in. Revenue, for sales logged with a price (see
+* sales_record.h), is kept in cents in a second array the same way, which
+* stays empty until the first priced sale. */
+class FrequencyTable {
+public:
+	/*adds amount to the count of item_name, interning the name with a count
+	* of zero first if it hasn't been seen before. Returns the item's ID.*/
+	uint32_t Add(std::string_view item_name, int64_t amount) {
+		uint32_t id = dictionary_.Intern(item_name);
+		AddById(id, amount);
+		return id;
+	}
+
+	/*adds amount to the count of the item with the given ID. The ID must
+	* come from this table's dictionary.*/
+	void AddById(uint32_t id, int64_t amount) {
+		if (id == counts_.size()) { counts_.push_back(amount); } //new item
+		else { counts_[id] += amount; }
+	}
+
+	/*adds cents to the revenue of the item with the given ID, which must
+	* come from this table's dictionary*/
+	void AddRevenueById(uint32_t id, int64_t cents) {
+		if (id >= revenue_.size()) { revenue_.resize(counts_.size(), 0); }
+		revenue_[id] += cents;
+	}
+
+	//returns the ID of item_name, or ItemDictionary::kNotFound
+	uint32_t Find(std::string_view item_name) const {
+		return dictionary_.Find(item_name);
+	}
+
+	//name and count of the item with the given ID
+	std::string_view Name(uint32_t id) const { return dictionary_.Name(id); }
+	int64_t Count(uint32_t id) const { return counts_[id]; }
+
+	//revenue of the item with the given ID in cents, 0 if it had no price
+	int64_t Revenue(uint32_t id) const {
+		return id < revenue_.size() ? revenue_[id] : 0;
+	}
+
+	//true once any item has had a priced sale
+	bool has_revenue() const { return !revenue_.empty(); }
+
+	//number of distinct items, IDs run from 0 to size() - 1
+	uint32_t size() const { return dictionary_.size(); }
+
+	//the interned names, and every count indexed by ID
+	const ItemDictionary& dictionary() const { return dictionary_; }
+	const std::vector<int64_t>& counts() const { return counts_; }
+
+	//largest count in the table, 0 if the table is empty
+	int64_t LargestCount() const;
+
+	//sum of every count, the number of units sold across all items
+	int64_t TotalUnits() const;
+
+	//sum of every item's revenue, in cents
+	int64_t TotalRevenue() const;
+
+	//length of the longest item name, used to lay out charts
+	std::size_t longest_name() const { return dictionary_.longest_name(); }
+
+	/*adds every item of other to this table. Items new to this table are
+	* given IDs in other's order, so merging tables built from consecutive
+	* pieces of a file gives the same IDs as counting the file in one go.
+	* If id_map isn't null, it is filled with the ID each of other's items
+	* has in this table. */
+	void Merge(const FrequencyTable& other,
+		       std::vector<uint32_t>* id_map = nullptr);
+
+	/*removes the item with the largest ID, which has to be the last one
+	* added (see ItemDictionary::RemoveLast), count, revenue and all*/
+	void RemoveLast() {
+		if (size() == 0) { return; }
+		dictionary_.RemoveLast();
+		counts_.pop_back();
+		if (revenue_.size() > counts_.size()) { revenue_.pop_back(); }
+	}
+
+	//removes every item, keeping allocated memory for reuse
+	void Clear();
+
+	//bytes allocated for the names and both arrays, counting what Clear kept
+	std::size_t memory_bytes() const;
+
+private:
+	ItemDictionary dictionary_; //item name <-> dense ID
+	std::vector<int64_t> counts_; //quantity sold, indexed by ID
+	std::vector<int64_t> revenue_; //cents taken, by ID, empty if none yet
+};
+
+/*Native replacement for ProduceManager.totalProduceFrequencies. The input
+* file is memory mapped and scanned in place, one sale per line (see
+* sales_record.h), with leading and trailing whitespace ignored and blank
+* lines skipped, exactly like the Python reference after it strips each line.
+* With more than one thread, the file is split into chunks that end on
+* newlines, each chunk is counted into its own table on its own thread, and
+* the tables are merged in chunk order once every thread is done. */
+class FrequencyEngine {
+public:
+	/*counts every line of file_name, adding to any counts already held. A
+	* gzip or zstd file is decompressed as it is counted, see
+	* compressed_input.h. Throws std::runtime_error if the file can't be
+	* opened or mapped, or is compressed and can't be decompressed.*/
+	void CountFile(const std::string& file_name);
+
+	/*counts every line of an in-memory buffer, used by CountFile once the
+	* file is mapped. Splits the work across thread_count() threads when the
+	* buffer is big enough to make that worthwhile.*/
+	void CountBuffer(const char* data, std::size_t size);
+
+	/*adds amount (which may be negative) to the count of item_name, and
+	* revenue_cents to its revenue, for changes that don't come from a whole
+	* file, such as LogFollower's*/
+	void Add(std::string_view item_name, int64_t amount,
+		     int64_t revenue_cents = 0) {
+		uint32_t id = table_.Add(item_name, amount);
+		if (revenue_cents != 0) { table_.AddRevenueById(id, revenue_cents); }
+	}
+
+	/*removes the item Add added last, if nothing was added since, for
+	* taking back an item that was only guessed at. Time buckets are left
+	* alone, so it can't have been put in one.*/
+	void RemoveLastItem() { table_.RemoveLast(); }
+
+	/*sets how many threads CountBuffer may use. 0 means one per hardware
+	* thread, 1 (the default) counts on the calling thread only.*/
+	void set_thread_count(unsigned thread_count);
+	unsigned thread_count() const { return thread_count_; }
+
+	/*returns the number of times item_name was sold, or -1 if it wasn't
+	* found, matching ProduceManager.returnProduceFrequency */
+	int64_t ItemFrequency(std::string_view item_name) const;
+
+	/*looks up every name in item_names in one call, resizing item_qtys to
+	* match and filling it with each name's count, or -1 for names that
+	* weren't found. Reusing item_qtys between calls avoids reallocating.*/
+	void ItemFrequencies(const std::vector<std::string_view>& item_names,
+		                 std::vector<int64_t>& item_qtys) const;
+
+	/*returns the revenue of item_name in cents, 0 if none of its sales had
+	* a price, or -1 if it wasn't found, like ItemFrequency*/
+	int64_t ItemRevenue(std::string_view item_name) const;
+
+	/*all item names and quantities. IDs are in the order items were first
+	* seen, like the Python dictionary*/
+	const FrequencyTable& Items() const { return table_; }
+
+	//number of units sold across all items
+	int64_t TotalUnits() const { return table_.TotalUnits(); }
+
+	/*adds the quantities in a frequency file to the counts already held.
+	* Either format is accepted: binary files are recognized by their magic
+	* bytes and read in place, text files ("<itemName> <itemQty>" per line)
+	* are parsed, skipping lines without a quantity. Throws
+	* std::runtime_error if the file can't be opened or mapped, or is a
+	* damaged binary file.*/
+	void CountFrequencyFile(const std::string& file_name);
+
+	/*writes every item to file_name. kText writes "<itemName> <itemQty>\n"
+	* lines, the same format ProduceManager.writeFrequencyFile uses, kBinary
+	* the indexed binary format. Throws std::runtime_error if the file can't
+	* be created. */
+	void WriteFrequencyFile(const std::string& file_name,
+		                    FrequencyFileFormat format =
+		                    FrequencyFileFormat::kText) const;
+
+	/*writes only the items in ids, in that order, as "<itemName> <itemQty>"
+	* text lines, for ranked exports (see ranking.h). The binary format
+	* always keeps its rows in name order, so there is no binary variant.
+	* Throws std::runtime_error if the file can't be created. */
+	void WriteFrequencyFile(const std::string& file_name,
+		                    const std::vector<uint32_t>& ids) const;
+
+	/*adds every count of other to this engine's, and other's time buckets
+	* too if both keep them. New items get IDs in other's order, so merging
+	* engines in a fixed order always gives the same table, whichever
+	* finished counting first*/
+	void Merge(const FrequencyEngine& other) {
+		MergeCounts(other.table_, other.time_windows_.get());
+	}
+
+	/*starts keeping time buckets for timestamped lines (see time_window.h)
+	* counted from now on, replacing any kept before. Lines are told apart
+	* whether or not this is called: a timestamp is never part of a name.*/
+	void EnableTimeWindows(const TimeWindowOptions& options);
+
+	//the time buckets, or nullptr if EnableTimeWindows wasn't called
+	const TimeWindowCounter* time_windows() const {
+		return time_windows_.get();
+	}
+	TimeWindowCounter* time_windows() { return time_windows_.get(); }
+
+	//forgets every count so a file can be recounted from scratch
+	void Clear() {
+		table_.Clear();
+		if (time_windows_ != nullptr) { time_windows_->Clear(); }
+	}
+
+private:
+	//appends item id's "<itemName> <itemQty>\n" line to contents
+	void AppendFrequencyLine(uint32_t id, std::string& contents) const;
+
+	//writes contents to file_name in one call, throwing if it can't
+	static void WriteWholeFile(const std::string& file_name,
+		                       const std::string& contents);
+
+	/*counts every line between begin and end into table, and timestamped
+	* lines into time_windows too unless it is null*/
+	static void CountRange(const char* begin, const char* end,
+		                   FrequencyTable& table,
+		                   TimeWindowCounter* time_windows);
+
+	/*merges table into table_, and windows (whose IDs are table's) into
+	* time_windows_ if both are kept*/
+	void MergeCounts(const FrequencyTable& table,
+		             const TimeWindowCounter* windows);
+
+	FrequencyTable table_; //item name -> quantity sold
+	unsigned thread_count_ = 1; //threads CountBuffer is allowed to use
+	std::unique_ptr<TimeWindowCounter> time_windows_; //null unless enabled
+};
+#endif
@@ -0,0 +1,232 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Frequency File definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "frequency_file.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+//first eight bytes of every binary frequency file
+const char kMagic[8] = {'C', 'G', 'F', 'R', 'E', 'Q', '\0', '\0'};
+
+//rounds size up to the next multiple of 8, so every section is aligned
+uint64_t AlignTo8(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+//pads buffer with zero bytes until its length is a multiple of 8
+void PadTo8(std::string& buffer) {
+	buffer.resize(AlignTo8(buffer.size()), '\0');
+}
+
+//appends the raw bytes of an array to buffer
+template <typename T>
+void AppendArray(std::string& buffer, const T* values, std::size_t count) {
+	buffer.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+/*true if count values of width bytes starting at offset fit in a file of
+* size bytes, and the section starts on an 8 byte boundary. Divides rather
+* than multiplies, so a damaged count can't wrap around and pass.*/
+bool SectionFits(uint64_t offset, uint64_t count, uint64_t width,
+	             uint64_t size) {
+	return offset % 8 == 0 && offset <= size &&
+		count <= (size - offset) / width;
+}
+}  // namespace
+
+/*lays the file out in a string: header first (filled in last, once every
+* offset is known), then each section in order.*/
+void WriteBinaryFrequencyFile(const FrequencyTable& table,
+	                          const std::string& file_name,
+	                          bool with_index) {
+	//sort item IDs by name, the file stores rows in name order
+	std::vector<uint32_t> rows(table.size());
+	std::iota(rows.begin(), rows.end(), 0);
+	std::sort(rows.begin(), rows.end(), [&table](uint32_t a, uint32_t b) {
+		return table.Name(a) < table.Name(b);
+	});
+
+	FrequencyFileHeader header = {};
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kFrequencyFileVersion;
+	header.item_count = rows.size();
+	header.longest_name = table.dictionary().longest_name();
+	header.largest_count = table.LargestCount();
+
+	std::string buffer(sizeof(header), '\0'); //room for the header
+
+	//name offsets, then the names themselves in the same order
+	std::vector<uint32_t> offsets;
+	offsets.reserve(rows.size() + 1);
+	uint32_t offset = 0;
+	for (uint32_t id : rows) {
+		offsets.push_back(offset);
+		offset += static_cast<uint32_t>(table.Name(id).size());
+	}
+	offsets.push_back(offset);
+	header.offsets_offset = buffer.size();
+	AppendArray(buffer, offsets.data(), offsets.size());
+	PadTo8(buffer);
+
+	header.names_offset = buffer.size();
+	for (uint32_t id : rows) {
+		std::string_view name = table.Name(id);
+		buffer.append(name.data(), name.size());
+	}
+	PadTo8(buffer);
+
+	//counts, in row order
+	header.counts_offset = buffer.size();
+	for (uint32_t id : rows) {
+		int64_t count = table.Count(id);
+		AppendArray(buffer, &count, 1);
+	}
+
+	/*hash index: at least twice as many slots as rows, so probe runs stay
+	* short, rounded up to a power of two so a mask can replace modulo*/
+	if (with_index) {
+		uint64_t slots = 8;
+		while (slots < rows.size() * 2) { slots *= 2; }
+		std::vector<uint32_t> index(slots, 0);
+		for (uint32_t row = 0; row < rows.size(); ++row) {
+			uint64_t slot = table.dictionary().NameHash(rows[row]) &
+				(slots - 1);
+			while (index[slot] != 0) { slot = (slot + 1) & (slots - 1); }
+			index[slot] = row + 1;
+		}
+		header.flags |= kFrequencyFileHasIndex;
+		header.index_offset = buffer.size();
+		header.index_slots = slots;
+		AppendArray(buffer, index.data(), index.size());
+		PadTo8(buffer);
+	}
+
+	//every offset is known now, so the header can go in at the front
+	std::memcpy(&buffer[0], &header, sizeof(header));
+
+	std::ofstream output(file_name, std::ios::out | std::ios::binary);
+	if (!output.is_open()) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	output.write(buffer.data(), buffer.size());
+	output.close();
+	if (!output) { //cut short, which the reader would reject anyway
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+	CORNER_GROCER_COUNT(kBytesWritten, buffer.size());
+}
+
+//a binary file is anything that starts with the magic bytes
+bool IsBinaryFrequencyFile(const char* data, std::size_t size) {
+	return size >= sizeof(kMagic) &&
+		std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+/*maps the file and checks that every section the header describes really
+* fits in the file, and that every name offset and index slot points inside
+* it, before any pointer into it is handed out. That is one pass over the
+* offsets and one over the index, so Name and Find never need to check. */
+FrequencyFileView::FrequencyFileView(const std::string& file_name)
+	: file_(file_name) {
+	const char* data = file_.data();
+	uint64_t size = file_.size();
+	if (size < sizeof(FrequencyFileHeader) ||
+		!IsBinaryFrequencyFile(data, size)) {
+		throw std::runtime_error("Not a binary frequency File: " + file_name);
+	}
+	FrequencyFileHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (header.version != kFrequencyFileVersion) {
+		throw std::runtime_error("Unsupported frequency File version: " +
+			                     file_name);
+	}
+
+	//each section has to start inside the file and end before it does
+	uint64_t count = header.item_count;
+	bool has_index = (header.flags & kFrequencyFileHasIndex) != 0;
+	bool fits = count < UINT32_MAX &&
+		SectionFits(header.offsets_offset, count + 1, sizeof(uint32_t),
+			        size) &&
+		SectionFits(header.counts_offset, count, sizeof(int64_t), size) &&
+		SectionFits(header.names_offset, 0, 1, size);
+	if (fits && has_index) {
+		fits = header.index_slots != 0 &&
+			(header.index_slots & (header.index_slots - 1)) == 0 &&
+			SectionFits(header.index_offset, header.index_slots,
+				        sizeof(uint32_t), size);
+	}
+	if (!fits) {
+		throw std::runtime_error("Truncated frequency File: " + file_name);
+	}
+
+	item_count_ = count;
+	longest_name_ = static_cast<std::size_t>(header.longest_name);
+	largest_count_ = header.largest_count;
+	offsets_ = reinterpret_cast<const uint32_t*>(data + header.offsets_offset);
+	names_ = data + header.names_offset;
+	counts_ = reinterpret_cast<const int64_t*>(data + header.counts_offset);
+
+	/*names are back to back, so offsets never go down, and the last one,
+	* the length of the names section, has to fit in the file too*/
+	for (uint64_t row = 0; row < count; ++row) {
+		if (offsets_[row] > offsets_[row + 1]) {
+			throw std::runtime_error("Damaged frequency File: " + file_name);
+		}
+	}
+	if (offsets_[count] > size - header.names_offset) {
+		throw std::runtime_error("Truncated frequency File: " + file_name);
+	}
+
+	//every slot is empty or one past a row
+	if (has_index) {
+		index_ = reinterpret_cast<const uint32_t*>(data + header.index_offset);
+		index_slots_ = header.index_slots;
+		for (uint64_t slot = 0; slot < index_slots_; ++slot) {
+			if (index_[slot] > count) {
+				throw std::runtime_error("Damaged frequency File: " +
+					                     file_name);
+			}
+		}
+	}
+}
+
+/*with an index, probe from the name's home slot until the name or an empty
+* slot turns up, giving up after every slot so a full (damaged) index can't
+* loop forever. Without one, binary search the sorted names.*/
+uint32_t FrequencyFileView::Find(std::string_view item_name) const {
+	if (index_ != nullptr) {
+		uint64_t mask = index_slots_ - 1;
+		uint64_t slot = ItemDictionary::Hash(item_name) & mask;
+		for (uint64_t probe = 0; probe < index_slots_;
+			 ++probe, slot = (slot + 1) & mask) {
+			uint32_t stored = index_[slot];
+			if (stored == 0) { return ItemDictionary::kNotFound; }
+			if (Name(stored - 1) == item_name) { return stored - 1; }
+		}
+		return ItemDictionary::kNotFound;
+	}
+	uint32_t low = 0; //first row that might still match
+	uint32_t high = size(); //one past the last row that might match
+	while (low < high) {
+		uint32_t middle = low + (high - low) / 2;
+		if (Name(middle) < item_name) { low = middle + 1; }
+		else { high = middle; }
+	}
+	if (low < size() && Name(low) == item_name) { return low; }
+	return ItemDictionary::kNotFound;
+}
@@ -0,0 +1,118 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Frequency File header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef FREQUENCY_FILE_H
+#define FREQUENCY_FILE_H
+#include "frequency_engine.h"
+#include "item_dictionary.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/* This file describes the binary frequency file, a versioned alternative to
+* the "<itemName> <itemQty>" text written to frequency.dat. It is laid out so
+* that a reader can map it and use it in place, with no parsing at all:
+*
+*   header             FrequencyFileHeader, 80 bytes
+*   name offsets       uint32_t[item_count + 1], name i is
+*                      names[offsets[i], offsets[i + 1])
+*   names              every name's characters, back to back, sorted
+*   counts             int64_t[item_count], count i belongs to name i
+*   hash index         optional, uint32_t[index_slots], 0 for an empty slot,
+*                      row + 1 otherwise, linear probing on the FNV-1a hash
+*
+* Every section starts on an 8 byte boundary. Numbers are stored in the
+* byte order of the machine that wrote the file, which for every processor
+* this program runs on (x86 and ARM) is little endian. */
+
+//the fixed size block at the start of every binary frequency file
+struct FrequencyFileHeader {
+	char magic[8]; //"CGFREQ" followed by two zero bytes
+	uint32_t version; //kFrequencyFileVersion when written
+	uint32_t flags; //kFrequencyFileHasIndex if the hash index is present
+	uint64_t item_count; //number of rows
+	uint64_t longest_name; //length of the longest name, for laying out charts
+	int64_t largest_count; //biggest count in the file, same reason
+	uint64_t offsets_offset; //file offset of the name offsets
+	uint64_t names_offset; //file offset of the name characters
+	uint64_t counts_offset; //file offset of the counts
+	uint64_t index_offset; //file offset of the hash index, 0 if none
+	uint64_t index_slots; //number of hash index slots, a power of two
+};
+
+//current version of the format, bumped whenever the layout changes
+const uint32_t kFrequencyFileVersion = 1;
+
+//flag bit set in FrequencyFileHeader::flags when a hash index is present
+const uint32_t kFrequencyFileHasIndex = 1;
+
+/*Writes every item of table to file_name in the binary format, names sorted
+* byte by byte, with a hash index unless with_index is false. The file is
+* built in memory and written with one call. Throws std::runtime_error if
+* the file can't be created.*/
+void WriteBinaryFrequencyFile(const FrequencyTable& table,
+	                          const std::string& file_name,
+	                          bool with_index = true);
+
+/*Returns true if data starts with the binary frequency file magic bytes, so
+* readers can accept either format from the same file name.*/
+bool IsBinaryFrequencyFile(const char* data, std::size_t size);
+
+/*A read only view of a binary frequency file. The file is memory mapped and
+* the header checked when the view is created, after which every call reads
+* straight out of the mapping. Rows are numbered 0 to size() - 1 in name
+* order. Throws std::runtime_error if the file can't be mapped, isn't a
+* frequency file, is a version this program doesn't know, is too short for
+* the sections its header describes, or has name offsets or index slots
+* pointing outside them. */
+class FrequencyFileView {
+public:
+	explicit FrequencyFileView(const std::string& file_name);
+
+	//number of rows in the file
+	uint32_t size() const { return static_cast<uint32_t>(item_count_); }
+
+	//name and count of the given row
+	std::string_view Name(uint32_t row) const {
+		return std::string_view(names_ + offsets_[row],
+			                    offsets_[row + 1] - offsets_[row]);
+	}
+	int64_t Count(uint32_t row) const { return counts_[row]; }
+
+	/*returns the row of item_name, or ItemDictionary::kNotFound. Uses the
+	* hash index when the file has one, binary search on the sorted names
+	* otherwise. */
+	uint32_t Find(std::string_view item_name) const;
+
+	//values stored in the header, so charts don't need to scan the rows
+	int64_t LargestCount() const { return largest_count_; }
+	std::size_t longest_name() const { return longest_name_; }
+
+	//true if the file carries a hash index
+	bool has_index() const { return index_ != nullptr; }
+
+private:
+	MappedFile file_; //the mapping every pointer below points into
+	uint64_t item_count_ = 0; //rows in the file
+	std::size_t longest_name_ = 0; //copied from the header
+	int64_t largest_count_ = 0; //copied from the header
+	const uint32_t* offsets_ = nullptr; //name offsets section
+	const char* names_ = nullptr; //name characters section
+	const int64_t* counts_ = nullptr; //counts section
+	const uint32_t* index_ = nullptr; //hash index, nullptr if none
+	uint64_t index_slots_ = 0; //slots in the hash index
+};
+#endif
@@ -0,0 +1,148 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Histogram definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "histogram.h"
+#include "line_scanner.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+//width used when the terminal can't be asked and COLUMNS isn't set
+const std::size_t kDefaultWidth = 80;
+
+//narrowest a scaled bar is allowed to get, however long the names are
+const std::size_t kMinimumBarWidth = 10;
+
+//characters around the name and bar: "| ", " | " and " |"
+const std::size_t kRowEdges = 7;
+
+//digits needed to print value
+std::size_t DigitCount(int64_t value) {
+	char text[24];
+	return std::to_chars(text, text + sizeof(text), value).ptr - text;
+}
+}  // namespace
+
+//the console (or terminal) knows its own size, COLUMNS is the fallback
+std::size_t TerminalWidth() {
+#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO info;
+	if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+		return info.srWindow.Right - info.srWindow.Left + 1;
+	}
+#else
+	winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+		return size.ws_col;
+	}
+#endif
+	const char* columns = std::getenv("COLUMNS");
+	int64_t width = 0;
+	if (columns != nullptr && ParseInteger(columns, width) && width > 0) {
+		return static_cast<std::size_t>(width);
+	}
+	return kDefaultWidth;
+}
+
+/*the bar gets whatever the name and count columns leave. If the biggest
+* count fits in that, nothing is scaled and no count column is needed, so
+* small charts look exactly as they always have.*/
+HistogramRenderer::Layout HistogramRenderer::PlanLayout(
+	std::size_t longest_name, int64_t largest_count) const {
+	Layout layout;
+	layout.name_width = longest_name;
+	layout.largest_count = std::max<int64_t>(largest_count, 0);
+	std::size_t width = options_.width != 0 ? options_.width : TerminalWidth();
+
+	//room for the bar with no count column
+	std::size_t room = width > longest_name + kRowEdges ?
+		width - longest_name - kRowEdges : 0;
+	layout.scaled = options_.scale &&
+		static_cast<uint64_t>(layout.largest_count) > room;
+	if (layout.scaled) {
+		//the count column takes its digits plus " |" of room from the bar
+		layout.count_width = DigitCount(layout.largest_count);
+		std::size_t count_room = layout.count_width + 3;
+		layout.bar_width = std::max(kMinimumBarWidth,
+			room > count_room ? room - count_room : 0);
+		layout.line_width = longest_name + layout.bar_width + kRowEdges +
+			count_room;
+	}
+	else { //one '*' per unit, the bar is exactly as long as the biggest
+		layout.count_width = 0;
+		layout.bar_width = static_cast<std::size_t>(layout.largest_count);
+		layout.line_width = longest_name + layout.bar_width + kRowEdges;
+	}
+	return layout;
+}
+
+//" ===...=== ", the top and bottom of the chart
+void HistogramRenderer::AppendRule(const Layout& layout) {
+	buffer_.push_back(' ');
+	buffer_.append(layout.line_width - 2, '=');
+	buffer_.append(" \n");
+}
+
+/*"| <name> | <bar> |", name right justified and bar left justified, with
+* " <count> |" added when scaled. A scaled bar is rounded to the nearest
+* '*', but never rounded away entirely for an item that sold anything.*/
+void HistogramRenderer::AppendRow(const Layout& layout,
+	                              std::string_view item_name,
+	                              int64_t item_qty) {
+	std::size_t bar = item_qty > 0 ? static_cast<std::size_t>(item_qty) : 0;
+	if (layout.scaled && bar != 0) {
+		bar = static_cast<std::size_t>(std::llround(
+			static_cast<double>(item_qty) / layout.largest_count *
+			layout.bar_width));
+		bar = std::min(std::max<std::size_t>(bar, 1), layout.bar_width);
+	}
+
+	buffer_.append("| ");
+	buffer_.append(layout.name_width - item_name.size(), ' ');
+	buffer_.append(item_name.data(), item_name.size());
+	buffer_.append(" | ");
+	buffer_.append(bar, '*');
+	buffer_.append(layout.bar_width - bar, ' ');
+	if (layout.scaled) {
+		char text[24];
+		char* end = std::to_chars(text, text + sizeof(text), item_qty).ptr;
+		std::size_t digits = end - text;
+		buffer_.append(" | ");
+		if (digits < layout.count_width) { //right justify the count
+			buffer_.append(layout.count_width - digits, ' ');
+		}
+		buffer_.append(text, digits);
+	}
+	buffer_.append(" |\n");
+}
+
+//tells the reader what a '*' means, since it is no longer one unit
+void HistogramRenderer::AppendScaleNote(const Layout& layout) {
+	char note[64];
+	int length = std::snprintf(note, sizeof(note),
+		                       " each * is about %.1f units\n",
+		                       static_cast<double>(layout.largest_count) /
+		                       layout.bar_width);
+	buffer_.append(note, length);
+}
@@ -0,0 +1,174 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Histogram header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* This file draws the text histogram of items sold into a string, without
+* printing it, so the chart can be written to the screen in one call and
+* timed on its own by the benchmark. Originally every row had one '*' per
+* unit sold, which is megabytes of stars once counts reach the tens of
+* thousands. Now, when the biggest count doesn't fit the chart's width, bars
+* are scaled so the biggest fills it, each row gains its exact count, and a
+* line under the chart says how many units one '*' stands for. Counts that
+* fit are drawn one '*' per unit, exactly as before. */
+
+//the order rows are drawn in
+enum class HistogramOrder {
+	kInput, //the order the source gives them (first seen, or name order)
+	kCountDescending, //best sellers first, ties by name
+	kCountAscending, //worst sellers first, ties by name
+	kName //alphabetical, byte by byte
+};
+
+//how a chart is laid out
+struct HistogramOptions {
+	std::size_t width = 0; //columns per line, 0 for the terminal's width
+	HistogramOrder order = HistogramOrder::kInput; //row order
+	uint32_t top = 0; //only chart the top best sellers, 0 for every item
+	bool scale = true; //false for one '*' per unit, however wide that is
+};
+
+/*Returns the width of the terminal standard output is written to. If it
+* isn't a terminal (it's redirected to a file, say), the COLUMNS environment
+* variable is used, and failing that, 80. */
+std::size_t TerminalWidth();
+
+/*Draws charts into a buffer it keeps between charts, so after the first
+* chart of a given size, drawing another allocates nothing. Works for any
+* source of rows with size(), Name(row) and Count(row), which FrequencyTable
+* and FrequencyFileView both have. */
+class HistogramRenderer {
+public:
+	explicit HistogramRenderer(const HistogramOptions& options =
+		                       HistogramOptions()) : options_(options) {}
+
+	void set_options(const HistogramOptions& options) { options_ = options; }
+	const HistogramOptions& options() const { return options_; }
+
+	/*Draws the chart for item_counts and returns it. The string belongs to
+	* the renderer and is overwritten by the next call. */
+	template<typename RowSource>
+	const std::string& Render(const RowSource& item_counts);
+
+	//rows drawn by the last Render, after top was applied
+	std::size_t row_count() const { return rows_.size(); }
+
+private:
+	//column widths worked out once per chart by PlanLayout
+	struct Layout {
+		std::size_t name_width; //longest name drawn
+		std::size_t bar_width; //columns for the bar
+		std::size_t count_width; //digits of the biggest count, 0 if hidden
+		std::size_t line_width; //every line's length, newline excluded
+		int64_t largest_count; //count drawn as a full bar
+		bool scaled; //true if a '*' stands for more than one unit
+	};
+
+	//fills rows_ with the IDs to draw, in the order to draw them
+	template<typename RowSource> void SelectRows(const RowSource& item_counts);
+
+	/*works out the layout for rows whose longest name and biggest count
+	* are given, within options_.width*/
+	Layout PlanLayout(std::size_t longest_name, int64_t largest_count) const;
+
+	//append one line of the chart to buffer_
+	void AppendRule(const Layout& layout);
+	void AppendRow(const Layout& layout, std::string_view item_name,
+		           int64_t item_qty);
+	void AppendScaleNote(const Layout& layout);
+
+	HistogramOptions options_; //width, order and top
+	std::string buffer_; //the chart, reused by every Render
+	std::vector<uint32_t> rows_; //IDs to draw, reused by every Render
+};
+
+/*top first: nth_element moves the top best sellers to the front in linear
+* time, so only they are sorted, however many items there are. Then the
+* rows kept are put in the order asked for. */
+template<typename RowSource>
+void HistogramRenderer::SelectRows(const RowSource& item_counts) {
+	rows_.resize(item_counts.size());
+	std::iota(rows_.begin(), rows_.end(), 0);
+
+	//count, biggest first, then name, so ties always land the same way
+	auto by_count_descending = [&item_counts](uint32_t a, uint32_t b) {
+		int64_t count_a = item_counts.Count(a);
+		int64_t count_b = item_counts.Count(b);
+		if (count_a != count_b) { return count_a > count_b; }
+		return item_counts.Name(a) < item_counts.Name(b);
+	};
+	if (options_.top != 0 && options_.top < rows_.size()) {
+		std::nth_element(rows_.begin(), rows_.begin() + options_.top,
+			             rows_.end(), by_count_descending);
+		rows_.resize(options_.top);
+	}
+
+	switch (options_.order) {
+	case HistogramOrder::kInput:
+		std::sort(rows_.begin(), rows_.end()); //only unsorted if top was used
+		break;
+	case HistogramOrder::kCountDescending:
+		std::sort(rows_.begin(), rows_.end(), by_count_descending);
+		break;
+	case HistogramOrder::kCountAscending:
+		std::sort(rows_.begin(), rows_.end(),
+			      [&item_counts](uint32_t a, uint32_t b) {
+			int64_t count_a = item_counts.Count(a);
+			int64_t count_b = item_counts.Count(b);
+			if (count_a != count_b) { return count_a < count_b; }
+			return item_counts.Name(a) < item_counts.Name(b);
+		});
+		break;
+	case HistogramOrder::kName:
+		std::sort(rows_.begin(), rows_.end(),
+			      [&item_counts](uint32_t a, uint32_t b) {
+			return item_counts.Name(a) < item_counts.Name(b);
+		});
+		break;
+	}
+}
+
+/*one pass to size the columns from the rows actually drawn, then one to
+* draw them into buffer_, reserved up front since every line is the same
+* length*/
+template<typename RowSource>
+const std::string& HistogramRenderer::Render(const RowSource& item_counts) {
+	SelectRows(item_counts);
+	std::size_t longest_name = 0;
+	int64_t largest_count = 0;
+	for (uint32_t id : rows_) {
+		longest_name = std::max(longest_name, item_counts.Name(id).size());
+		largest_count = std::max(largest_count, item_counts.Count(id));
+	}
+	Layout layout = PlanLayout(longest_name, largest_count);
+
+	buffer_.clear();
+	buffer_.reserve((layout.line_width + 1) * (rows_.size() + 3));
+	AppendRule(layout);
+	for (uint32_t id : rows_) {
+		AppendRow(layout, item_counts.Name(id), item_counts.Count(id));
+	}
+	AppendRule(layout);
+	if (layout.scaled) { AppendScaleNote(layout); }
+	return buffer_;
+}
+#endif
@@ -0,0 +1,291 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * History Store definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "history_store.h"
+#include "checkpoint.h"
+#include "ranking.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+//first eight bytes of every history file
+const char kMagic[8] = {'C', 'G', 'H', 'I', 'S', 'T', '\0', '\0'};
+
+//days in each of the two weeks TopMovers compares
+const int64_t kWeekDays = 7;
+
+//rounds size up to the next multiple of 8, so every section is aligned
+uint64_t AlignTo8(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+//appends the raw bytes of an array to buffer
+template <typename T>
+void AppendArray(std::string& buffer, const T* values, std::size_t count) {
+	buffer.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+/*the row source RankItems needs, ranking items by how much their sales
+* changed, whichever way*/
+class MoverRows {
+public:
+	MoverRows(const HistoryStore& history,
+		      const std::vector<int64_t>& this_week,
+		      const std::vector<int64_t>& last_week)
+		: history_(history), this_week_(this_week), last_week_(last_week) {}
+
+	uint32_t size() const { return history_.size(); }
+	std::string_view Name(uint32_t id) const { return history_.Name(id); }
+	int64_t Count(uint32_t id) const {
+		int64_t change = this_week_[id] - last_week_[id];
+		return change < 0 ? -change : change;
+	}
+
+private:
+	const HistoryStore& history_; //for the names
+	const std::vector<int64_t>& this_week_; //units per ID, the later week
+	const std::vector<int64_t>& last_week_; //units per ID, the one before
+};
+}  // namespace
+
+/*blocks are read until one doesn't fit in the file or, for the last one,
+* doesn't match its CRC. Blocks before the last were complete before it was
+* written, so checking theirs would only slow every open down by reading
+* every column.*/
+HistoryStore::HistoryStore(const std::string& file_name) : file_(file_name) {
+	HistoryFileHeader header;
+	if (file_.size() < sizeof(header)) {
+		throw std::runtime_error("Not a history File: " + file_name);
+	}
+	std::memcpy(&header, file_.data(), sizeof(header));
+	if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+		throw std::runtime_error("Not a history File: " + file_name);
+	}
+	if (header.version != kHistoryFileVersion) {
+		throw std::runtime_error("Unsupported history File version: " +
+			                     file_name);
+	}
+
+	const char* at = file_.data() + sizeof(header);
+	const char* end = file_.data() + file_.size();
+	valid_bytes_ = sizeof(header);
+	while (static_cast<std::size_t>(end - at) >= sizeof(HistoryBlockHeader)) {
+		HistoryBlockHeader block;
+		std::memcpy(&block, at, sizeof(block));
+		const char* body = at + sizeof(block);
+		if (block.names_bytes > uint64_t(end - body)) { break; }
+		uint64_t names_bytes = AlignTo8(uint64_t(block.new_names) *
+			                            sizeof(uint32_t) + block.names_bytes);
+		uint64_t body_bytes = names_bytes +
+			uint64_t(block.item_count) * sizeof(int64_t);
+		if (uint64_t(block.item_count) != uint64_t(names_.size()) +
+			block.new_names || body_bytes > uint64_t(end - body)) {
+			break; //cut short, and there can be nothing after it
+		}
+		if (body + body_bytes == end &&
+			Crc32(body, static_cast<std::size_t>(body_bytes)) != block.crc) {
+			break; //the last block, which a crash may have left half written
+		}
+
+		//the names first seen this day, which get the next IDs
+		const char* names = body + uint64_t(block.new_names) *
+			sizeof(uint32_t);
+		uint32_t first_new_id = names_.size();
+		uint64_t name_offset = 0;
+		for (uint32_t i = 0; i < block.new_names; ++i) {
+			uint32_t name_size;
+			std::memcpy(&name_size, body + i * sizeof(uint32_t),
+				        sizeof(name_size));
+			uint32_t next_id = names_.size(); //what a new name must get
+			if (name_size > block.names_bytes - name_offset ||
+				names_.Intern(std::string_view(names + name_offset,
+					                           name_size)) != next_id) {
+				//past the names, or a name the history already had
+				throw std::runtime_error("Damaged history File: " +
+					                     file_name);
+			}
+			name_offset += name_size;
+		}
+		const char* counts = body + names_bytes;
+		columns_.push_back({block.day,
+			                reinterpret_cast<const int64_t*>(counts),
+			                block.item_count});
+		last_block_ = {block.day, uint64_t(at - file_.data()), first_new_id};
+		at = body + body_bytes;
+		valid_bytes_ = at - file_.data();
+	}
+
+	/*oldest first, and of columns for the same day only the last written,
+	* which stable_sort keeps last of its run*/
+	std::stable_sort(columns_.begin(), columns_.end(),
+		             [](const Column& a, const Column& b) {
+		return a.day < b.day;
+	});
+	std::vector<Column> latest;
+	for (std::size_t i = 0; i < columns_.size(); ++i) {
+		if (i + 1 == columns_.size() ||
+			columns_[i + 1].day != columns_[i].day) {
+			latest.push_back(columns_[i]);
+		}
+	}
+	columns_.swap(latest);
+}
+
+std::size_t HistoryStore::FirstColumn(int64_t day) const {
+	return std::lower_bound(columns_.begin(), columns_.end(), day,
+		                    [](const Column& column, int64_t value) {
+		return column.day < value;
+	}) - columns_.begin();
+}
+
+void HistoryStore::ItemHistory(uint32_t id, int64_t first_day,
+	                           int64_t last_day,
+	                           std::vector<HistoryPoint>& points) const {
+	points.clear();
+	for (std::size_t i = FirstColumn(first_day);
+		 i < columns_.size() && columns_[i].day <= last_day; ++i) {
+		points.push_back({columns_[i].day, CountIn(columns_[i], id)});
+	}
+}
+
+void HistoryStore::DayTotals(int64_t first_day, int64_t last_day,
+	                         std::vector<HistoryPoint>& points) const {
+	points.clear();
+	for (std::size_t i = FirstColumn(first_day);
+		 i < columns_.size() && columns_[i].day <= last_day; ++i) {
+		const Column& column = columns_[i];
+		int64_t total = 0;
+		for (uint32_t id = 0; id < column.item_count; ++id) {
+			total += column.counts[id];
+		}
+		points.push_back({column.day, total});
+	}
+}
+
+/*both weeks are added up per item in one pass over their columns, then
+* ranked by the size of the change with RankItems' heap. Items that didn't
+* change at all aren't movers, so they are left off the end.*/
+void HistoryStore::TopMovers(int64_t day, uint32_t k,
+	                         std::vector<HistoryMover>& movers) const {
+	std::vector<int64_t> this_week(size(), 0);
+	std::vector<int64_t> last_week(size(), 0);
+	for (std::size_t i = FirstColumn(day - 2 * kWeekDays + 1);
+		 i < columns_.size() && columns_[i].day <= day; ++i) {
+		const Column& column = columns_[i];
+		std::vector<int64_t>& week = column.day > day - kWeekDays ?
+			this_week : last_week;
+		for (uint32_t id = 0; id < column.item_count; ++id) {
+			week[id] += column.counts[id];
+		}
+	}
+	std::vector<uint32_t> ids;
+	RankItems(MoverRows(*this, this_week, last_week), k, true, ids);
+	movers.clear();
+	for (uint32_t id : ids) {
+		if (this_week[id] == last_week[id]) { break; } //the rest are too
+		movers.push_back({id, this_week[id], last_week[id]});
+	}
+}
+
+/*the history is read first, for the names it already has and where its
+* good blocks end, then unmapped before the file is cut back to there and
+* the new block written on the end in one call. When the last good block is
+* for the same day, the file is cut back to where that block starts
+* instead, and the names it was first to have are written again in the new
+* one (if items still has them), so recording a day after every run keeps
+* one block for it rather than adding one per run.*/
+void AppendHistoryDay(const std::string& file_name, int64_t day,
+	                  const FrequencyTable& items) {
+	ItemDictionary names; //every name, with the same IDs as the history
+	uint64_t valid_bytes = 0; //0 for a history that doesn't exist yet
+	std::error_code error;
+	if (std::filesystem::exists(file_name, error)) {
+		HistoryStore history(file_name);
+		uint32_t kept_names = history.size();
+		valid_bytes = history.valid_bytes();
+		const HistoryStore::LastBlock& last = history.last_block();
+		if (last.offset != 0 && last.day == day) { //replaced, not kept
+			kept_names = last.first_new_id;
+			valid_bytes = last.offset;
+		}
+		for (uint32_t id = 0; id < kept_names; ++id) {
+			names.Intern(history.Name(id));
+		}
+	}
+
+	//items' IDs in the history, giving the new names the next ones
+	uint32_t known_names = names.size();
+	std::vector<uint32_t> history_ids(items.size());
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		history_ids[id] = names.Intern(items.Name(id));
+	}
+
+	std::string body; //everything after the block header
+	uint64_t names_bytes = 0;
+	for (uint32_t id = known_names; id < names.size(); ++id) {
+		uint32_t name_size = static_cast<uint32_t>(names.Name(id).size());
+		AppendArray(body, &name_size, 1);
+		names_bytes += name_size;
+	}
+	for (uint32_t id = known_names; id < names.size(); ++id) {
+		body.append(names.Name(id));
+	}
+	body.resize(static_cast<std::size_t>(AlignTo8(body.size())), '\0');
+	std::vector<int64_t> column(names.size(), 0);
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		column[history_ids[id]] += items.Count(id);
+	}
+	AppendArray(body, column.data(), column.size());
+
+	HistoryBlockHeader block = {};
+	block.day = day;
+	block.new_names = names.size() - known_names;
+	block.item_count = names.size();
+	block.names_bytes = names_bytes;
+	block.crc = Crc32(body.data(), body.size());
+	std::string buffer; //the file header if it's new, then the block
+	if (valid_bytes == 0) {
+		HistoryFileHeader header = {};
+		std::memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kHistoryFileVersion;
+		AppendArray(buffer, &header, 1);
+	}
+	else {
+		std::filesystem::resize_file(file_name, valid_bytes, error);
+		if (error) {
+			throw std::runtime_error("Error writing File: " + file_name);
+		}
+	}
+	AppendArray(buffer, &block, 1);
+	buffer.append(body);
+
+	std::ofstream output(file_name, std::ios::out | std::ios::binary |
+		                 (valid_bytes == 0 ? std::ios::trunc : std::ios::app));
+	if (!output.is_open()) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	output.write(buffer.data(), buffer.size());
+	output.close();
+	if (!output) {
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+}
+
+//floor division, so a clock before 1970 still gives the day it is in
+int64_t CurrentDay() {
+	int64_t seconds = static_cast<int64_t>(std::time(nullptr));
+	return (seconds >= 0 ? seconds : seconds - 86399) / 86400;
+}
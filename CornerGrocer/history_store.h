@@ -0,0 +1,179 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * History Store header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+#include "frequency_engine.h"
+#include "item_dictionary.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* This file keeps every day's counts, which frequency.dat can't, since each
+* run writes over it. The history file grows by one block per day recorded:
+*
+*   header       HistoryFileHeader, 16 bytes
+*   blocks       one per day recorded, each:
+*     block header   HistoryBlockHeader, 32 bytes
+*     name sizes     uint32_t[new_names], of the items first sold that day
+*     names          their characters, back to back, padded to 8 bytes
+*     counts         int64_t[item_count], the day's column, in ID order
+*
+* Item IDs are given in the order items first appear in the history, like
+* ItemDictionary's, so every column is a flat array indexed by the same IDs,
+* and an item that hadn't appeared yet when a column was written sold 0
+* that day. The file grows by 8 bytes per item per day, and a column is
+* never parsed: it is used in place from a memory mapping, so a query over
+* some days reads only those days' columns, and only the entries it needs.
+*
+* Recording the day of the last block again writes over that block, so a
+* day can be recorded after every run without the file growing each time.
+* Recording an earlier day that is already in the file appends a new column
+* for it, which replaces the old one. A block is written with one call,
+* after the blocks before it are complete, so only the last one can be cut
+* short by a crash. It carries a CRC32 and is dropped when reading if it
+* doesn't check out, and written over by the next day recorded (a crash
+* while writing over a day's block loses that day until it is recorded
+* again). Numbers are stored in the byte order of the machine
+* that wrote them, like the binary frequency file. */
+
+//the fixed size block at the start of every history file
+struct HistoryFileHeader {
+	char magic[8]; //"CGHIST" followed by two zero bytes
+	uint32_t version; //kHistoryFileVersion when written
+	uint32_t reserved; //0, keeps the blocks 8 byte aligned
+};
+
+//the fixed size start of every day's block
+struct HistoryBlockHeader {
+	int64_t day; //days since 1970-01-01, UTC
+	uint32_t new_names; //names first seen in this block
+	uint32_t item_count; //entries in the column, every ID so far
+	uint64_t names_bytes; //bytes of name characters, before padding
+	uint32_t crc; //CRC32 of the rest of the block, after this header
+	uint32_t reserved; //0
+};
+
+//current version of the format, bumped whenever the layout changes
+const uint32_t kHistoryFileVersion = 1;
+
+//one item's, or every item's, units sold on one day
+struct HistoryPoint {
+	int64_t day; //days since 1970-01-01
+	int64_t count; //units sold that day
+};
+
+//an item whose sales changed the most from one week to the next
+struct HistoryMover {
+	uint32_t id; //the item's ID in the history
+	int64_t this_week; //units sold in the 7 days up to the day asked about
+	int64_t last_week; //units sold in the 7 days before those
+};
+
+/*A read only view of a history file, mapped and checked when it is
+* created. Only the names are read then, to be interned for Find; columns
+* stay in the mapping until a query reads them. Throws std::runtime_error
+* if the file can't be mapped or isn't a history file of a version this
+* program knows. */
+class HistoryStore {
+public:
+	explicit HistoryStore(const std::string& file_name);
+
+	//number of items that have ever appeared
+	uint32_t size() const { return names_.size(); }
+
+	//name of the item with the given ID
+	std::string_view Name(uint32_t id) const { return names_.Name(id); }
+
+	//ID of item_name, or ItemDictionary::kNotFound
+	uint32_t Find(std::string_view item_name) const {
+		return names_.Find(item_name);
+	}
+
+	//number of days recorded, each counted once however often it was
+	std::size_t day_count() const { return columns_.size(); }
+
+	//the latest day recorded, or 0 if there are none
+	int64_t newest_day() const {
+		return columns_.empty() ? 0 : columns_.back().day;
+	}
+
+	/*fills points with item id's units on each day recorded from first_day
+	* to last_day, oldest first. Reads one entry of each of those columns.*/
+	void ItemHistory(uint32_t id, int64_t first_day, int64_t last_day,
+		             std::vector<HistoryPoint>& points) const;
+
+	/*fills points with every item's units added up on each day recorded
+	* from first_day to last_day, oldest first. Reads those columns whole.*/
+	void DayTotals(int64_t first_day, int64_t last_day,
+		           std::vector<HistoryPoint>& points) const;
+
+	/*fills movers with the k items whose sales changed the most, up or
+	* down, between the 7 days before day and the 7 days up to and including
+	* it, biggest change first, ties broken by name. Reads only those 14
+	* days' columns.*/
+	void TopMovers(int64_t day, uint32_t k,
+		           std::vector<HistoryMover>& movers) const;
+
+	//bytes of the file up to the end of its last good block
+	uint64_t valid_bytes() const { return valid_bytes_; }
+
+	//where the last good block in the file is, to write over it
+	struct LastBlock {
+		int64_t day = 0; //the day its column is for
+		uint64_t offset = 0; //where it starts, 0 if there are no blocks
+		uint32_t first_new_id = 0; //ID of its first new name, if any
+	};
+
+	//the last good block, in file order rather than by day
+	const LastBlock& last_block() const { return last_block_; }
+
+private:
+	//one day's counts, in the mapping
+	struct Column {
+		int64_t day; //days since 1970-01-01
+		const int64_t* counts; //item_count counts, indexed by ID
+		uint32_t item_count; //items that had appeared by then
+	};
+
+	//index into columns_ of the first day on or after day
+	std::size_t FirstColumn(int64_t day) const;
+
+	//item id's units in column, 0 if it hadn't appeared yet
+	static int64_t CountIn(const Column& column, uint32_t id) {
+		return id < column.item_count ? column.counts[id] : 0;
+	}
+
+	MappedFile file_; //the mapping every column points into
+	ItemDictionary names_; //every name in the file, interned in ID order
+	std::vector<Column> columns_; //one per day, oldest first
+	uint64_t valid_bytes_ = 0; //see valid_bytes
+	LastBlock last_block_; //see last_block
+};
+
+/*Appends items' counts to file_name as day's column, creating the file if
+* it doesn't exist, after dropping a last block that was cut short, or the
+* last block if it is for the same day. Items
+* that are new to the history get the next IDs, in items' ID order. Throws
+* std::runtime_error if the file can't be read or written, or isn't a
+* history file.*/
+void AppendHistoryDay(const std::string& file_name, int64_t day,
+	                  const FrequencyTable& items);
+
+//today's date, in days since 1970-01-01, UTC
+int64_t CurrentDay();
+#endif
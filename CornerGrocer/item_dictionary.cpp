@@ -0,0 +1,129 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Item Dictionary definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "item_dictionary.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+//starting size of the probe array, must be a power of two
+const std::size_t kInitialSlots = 64;
+}  // namespace
+
+/*starts with a small, empty probe array. offsets_ always holds one more
+* entry than there are names, so Name(id) can read offsets_[id + 1]*/
+ItemDictionary::ItemDictionary()
+	: offsets_(1, 0), slots_(kInitialSlots, kEmptySlot) {}
+
+/*FNV-1a: xor each byte into the hash, then multiply by the FNV prime. Fast
+* and well spread for the short ASCII names found in the sales logs*/
+uint64_t ItemDictionary::Hash(std::string_view item_name) {
+	uint64_t hash = 14695981039346656037ULL; //FNV offset basis
+	for (char character : item_name) {
+		hash ^= static_cast<unsigned char>(character);
+		hash *= 1099511628211ULL; //FNV prime
+	}
+	return hash;
+}
+
+/*probes linearly from the hash's home slot until either the name or an empty
+* slot is found. The stored hash is compared before the name, so most misses
+* never touch the arena at all.*/
+uint32_t ItemDictionary::Intern(std::string_view item_name, uint64_t hash) {
+	std::size_t mask = slots_.size() - 1; //size is a power of two
+	for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+		uint32_t stored = slots_[slot];
+		if (stored == kEmptySlot) { //name not interned yet, add it here
+			if (item_name.size() > UINT32_MAX - arena_.size()) {
+				throw std::runtime_error("Item names don't fit in 4 GB");
+			}
+			uint32_t id = size();
+			arena_.insert(arena_.end(), item_name.begin(), item_name.end());
+			offsets_.push_back(static_cast<uint32_t>(arena_.size()));
+			hashes_.push_back(hash);
+			slots_[slot] = id + 1;
+			longest_name_ = std::max(longest_name_, item_name.size());
+
+			//keep the load factor under 70% so probe runs stay short
+			if (hashes_.size() * 10 > slots_.size() * 7) { Grow(); }
+			return id;
+		}
+		uint32_t id = stored - 1;
+		if (hashes_[id] == hash && Name(id) == item_name) { return id; }
+	}
+}
+
+//same probe sequence as Intern, but never inserts
+uint32_t ItemDictionary::Find(std::string_view item_name) const {
+	uint64_t hash = Hash(item_name);
+	std::size_t mask = slots_.size() - 1;
+	for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+		uint32_t stored = slots_[slot];
+		if (stored == kEmptySlot) { return kNotFound; } //no more candidates
+		uint32_t id = stored - 1;
+		if (hashes_[id] == hash && Name(id) == item_name) { return id; }
+	}
+}
+
+/*doubles the probe array. Names never move, only their IDs are placed again
+* using the stored hashes, so nothing is rehashed.*/
+void ItemDictionary::Grow() {
+	std::vector<uint32_t> grown(slots_.size() * 2, kEmptySlot);
+	std::size_t mask = grown.size() - 1;
+	for (uint32_t id = 0; id < size(); ++id) {
+		std::size_t slot = hashes_[id] & mask;
+		while (grown[slot] != kEmptySlot) { slot = (slot + 1) & mask; }
+		grown[slot] = id + 1;
+	}
+	slots_.swap(grown);
+}
+
+/*the last name's slot can simply be emptied: every other name was placed
+* (or placed again by Grow) before it, when that slot was still empty, so
+* no probe for another name passes through it*/
+void ItemDictionary::RemoveLast() {
+	if (hashes_.empty()) { return; }
+	uint32_t id = size() - 1;
+	std::size_t mask = slots_.size() - 1;
+	std::size_t slot = hashes_[id] & mask;
+	while (slots_[slot] != id + 1) { slot = (slot + 1) & mask; }
+	slots_[slot] = kEmptySlot;
+	std::size_t name_size = Name(id).size();
+	arena_.resize(offsets_[id]);
+	offsets_.pop_back();
+	hashes_.pop_back();
+	if (name_size == longest_name_) { //it may have been the widest
+		longest_name_ = 0;
+		for (uint32_t other = 0; other < id; ++other) {
+			longest_name_ = std::max<std::size_t>(longest_name_,
+				offsets_[other + 1] - offsets_[other]);
+		}
+	}
+}
+
+//capacity, not size, since that is what has actually been allocated
+std::size_t ItemDictionary::memory_bytes() const {
+	return arena_.capacity() + offsets_.capacity() * sizeof(uint32_t) +
+		hashes_.capacity() * sizeof(uint64_t) +
+		slots_.capacity() * sizeof(uint32_t);
+}
+
+//empties the dictionary, reusing the arena and probe array's memory
+void ItemDictionary::Clear() {
+	arena_.clear();
+	offsets_.assign(1, 0);
+	hashes_.clear();
+	std::fill(slots_.begin(), slots_.end(), kEmptySlot);
+	longest_name_ = 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Item Dictionary header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef ITEM_DICTIONARY_H
+#define ITEM_DICTIONARY_H
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*This class interns item names. Every distinct name is given a dense ID
+* (0, 1, 2, ... in the order names are first seen) and its characters are
+* stored exactly once, back to back, in one contiguous arena. Anything that
+* needs to know about an item can then hold a uint32_t instead of a string,
+* and per item data (counts, revenue, ...) can live in flat arrays indexed by
+* ID. Lookups go through an open addressing hash table of IDs, with linear
+* probing and doubling once the table is 70% full. */
+class ItemDictionary {
+public:
+	//returned by Find when a name has never been interned
+	static const uint32_t kNotFound = UINT32_MAX;
+
+	ItemDictionary();
+
+	/*returns the ID of item_name, copying the name into the arena and giving
+	* it the next free ID if it hasn't been seen before. Offsets into the
+	* arena are 32 bit, so throws std::runtime_error rather than let every
+	* name together grow past 4 GB.*/
+	uint32_t Intern(std::string_view item_name) {
+		return Intern(item_name, Hash(item_name));
+	}
+
+	//Intern, for callers that already know the name's hash
+	uint32_t Intern(std::string_view item_name, uint64_t hash);
+
+	//returns the ID of item_name, or kNotFound. Never inserts.
+	uint32_t Find(std::string_view item_name) const;
+
+	/*returns the name with the given ID. The view points into the arena, so
+	* it stays valid until the next Intern or Clear call.*/
+	std::string_view Name(uint32_t id) const {
+		return std::string_view(arena_.data() + offsets_[id],
+			                    offsets_[id + 1] - offsets_[id]);
+	}
+
+	//returns the hash stored for the name with the given ID
+	uint64_t NameHash(uint32_t id) const { return hashes_[id]; }
+
+	//number of distinct names interned so far, one more than the largest ID
+	uint32_t size() const {
+		return static_cast<uint32_t>(hashes_.size());
+	}
+
+	//length of the longest name interned so far
+	std::size_t longest_name() const { return longest_name_; }
+
+	/*forgets the name with the largest ID, which has to be the last one
+	* interned, for taking back a name that turned out not to be one. Does
+	* nothing if the dictionary is empty.*/
+	void RemoveLast();
+
+	//forgets every name, keeping allocated memory for reuse
+	void Clear();
+
+	//bytes allocated for the arena, the per ID arrays and the probe array
+	std::size_t memory_bytes() const;
+
+	//64 bit FNV-1a hash, short item names make anything fancier a waste
+	static uint64_t Hash(std::string_view item_name);
+
+private:
+	//marks an unused probe slot. Slots hold ID + 1 otherwise
+	static const uint32_t kEmptySlot = 0;
+
+	//doubles the probe array and places every ID again
+	void Grow();
+
+	std::vector<char> arena_; //every name's characters, back to back
+	std::vector<uint32_t> offsets_; //name i is arena_[offsets_[i], [i + 1])
+	std::vector<uint64_t> hashes_; //hash of each name, indexed by ID
+	std::vector<uint32_t> slots_; //probe array, size is a power of two
+	std::size_t longest_name_ = 0; //widest name, used to lay out charts
+};
+#endif
@@ -0,0 +1,179 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Item Search definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "item_search.h"
+#include "line_scanner.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+/*appends name to out normalized. std::tolower depends on the locale, and
+* only ASCII letters are folded anyway, so this does it by hand.*/
+void AppendNormalized(std::string_view name, std::string& out) {
+	bool space = false; //whitespace seen since the last character kept
+	std::size_t start = out.size();
+	for (char character : name) {
+		if (IsLineWhitespace(character)) {
+			space = true;
+			continue;
+		}
+		if (space && out.size() > start) { out += ' '; }
+		space = false;
+		if (character >= 'A' && character <= 'Z') {
+			character = static_cast<char>(character - 'A' + 'a');
+		}
+		out += character;
+	}
+}
+
+//true if some word of key starts with prefix
+bool HasWordStarting(std::string_view key, std::string_view prefix) {
+	for (std::size_t start = 0; start < key.size();) {
+		std::size_t end = key.find(' ', start);
+		if (end == std::string_view::npos) { end = key.size(); }
+		if (key.substr(start, end - start).substr(0, prefix.size()) ==
+			prefix) {
+			return true;
+		}
+		start = end + 1;
+	}
+	return false;
+}
+
+//the words of a normalized name or query, which are split by single spaces
+std::vector<std::string_view> SplitWords(std::string_view key) {
+	std::vector<std::string_view> words;
+	for (std::size_t start = 0; start < key.size();) {
+		std::size_t end = key.find(' ', start);
+		if (end == std::string_view::npos) { end = key.size(); }
+		words.push_back(key.substr(start, end - start));
+		start = end + 1;
+	}
+	return words;
+}
+}  // namespace
+
+std::string NormalizeItemName(std::string_view name) {
+	std::string normalized;
+	normalized.reserve(name.size());
+	AppendNormalized(name, normalized);
+	return normalized;
+}
+
+/*names are normalized into one buffer first, so sorting compares views into
+* it and never copies a name*/
+void ItemSearchIndex::Build(const FrequencyTable& items) {
+	keys_.clear();
+	key_offsets_.clear();
+	words_.clear();
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		key_offsets_.push_back(static_cast<uint32_t>(keys_.size()));
+		AppendNormalized(items.Name(id), keys_);
+	}
+	key_offsets_.push_back(static_cast<uint32_t>(keys_.size()));
+
+	names_.resize(items.size());
+	std::iota(names_.begin(), names_.end(), 0);
+	std::sort(names_.begin(), names_.end(), [this](uint32_t a, uint32_t b) {
+		return NameBefore(a, b);
+	});
+
+	for (uint32_t id = 0; id < items.size(); ++id) {
+		for (std::string_view word : SplitWords(Key(id))) {
+			uint32_t offset = static_cast<uint32_t>(word.data() - keys_.data());
+			words_.push_back({offset, static_cast<uint32_t>(word.size()), id});
+		}
+	}
+	std::sort(words_.begin(), words_.end(),
+		      [this](const WordEntry& a, const WordEntry& b) {
+		std::string_view word_a = Word(a);
+		std::string_view word_b = Word(b);
+		return word_a != word_b ? word_a < word_b : NameBefore(a.id, b.id);
+	});
+}
+
+void ItemSearchIndex::FindExact(std::string_view query,
+	                            std::vector<uint32_t>& ids) const {
+	ids.clear();
+	std::string key = NormalizeItemName(query);
+	auto first = std::lower_bound(names_.begin(), names_.end(), key,
+		[this](uint32_t id, std::string_view wanted) {
+		return Key(id) < wanted;
+	});
+	for (auto name = first; name != names_.end() && Key(*name) == key;
+		 ++name) {
+		ids.push_back(*name);
+	}
+}
+
+/*words are sorted, so the words starting with prefix sit together: the
+* first is the first word not less than prefix, the last the last word
+* whose first prefix.size() characters are prefix*/
+std::pair<std::size_t, std::size_t> ItemSearchIndex::WordRange(
+	std::string_view prefix) const {
+	auto first = std::lower_bound(words_.begin(), words_.end(), prefix,
+		[this](const WordEntry& entry, std::string_view wanted) {
+		return Word(entry) < wanted;
+	});
+	auto last = std::upper_bound(first, words_.end(), prefix,
+		[this](std::string_view wanted, const WordEntry& entry) {
+		return wanted < Word(entry).substr(0, wanted.size());
+	});
+	return {static_cast<std::size_t>(first - words_.begin()),
+		    static_cast<std::size_t>(last - words_.begin())};
+}
+
+/*the narrowest word's range gives the candidates, already in result order,
+* and each is checked for the other words by walking its (short) name. The
+* walk stops once limit items match, so a short prefix costs no more than
+* a long one unless most candidates are missing another word.*/
+void ItemSearchIndex::Search(std::string_view query, std::size_t limit,
+	                         std::vector<uint32_t>& ids) const {
+	ids.clear();
+	std::string key = NormalizeItemName(query);
+	std::vector<std::string_view> query_words = SplitWords(key);
+	if (query_words.empty()) { return; }
+
+	std::size_t narrowest = 0; //query word with the fewest candidates
+	std::pair<std::size_t, std::size_t> range = WordRange(query_words[0]);
+	for (std::size_t word = 1; word < query_words.size(); ++word) {
+		std::pair<std::size_t, std::size_t> other =
+			WordRange(query_words[word]);
+		if (other.second - other.first < range.second - range.first) {
+			range = other;
+			narrowest = word;
+		}
+	}
+
+	for (std::size_t entry = range.first;
+		 entry < range.second && ids.size() < limit; ++entry) {
+		uint32_t id = words_[entry].id;
+		bool matches = true;
+		for (std::size_t word = 0; word < query_words.size() && matches;
+			 ++word) {
+			matches = word == narrowest ||
+				HasWordStarting(Key(id), query_words[word]);
+		}
+		//a name with two words starting the same way is found twice
+		if (matches && std::find(ids.begin(), ids.end(), id) == ids.end()) {
+			ids.push_back(id);
+		}
+	}
+}
+
+std::size_t ItemSearchIndex::memory_bytes() const {
+	return keys_.capacity() + key_offsets_.capacity() * sizeof(uint32_t) +
+		names_.capacity() * sizeof(uint32_t) +
+		words_.capacity() * sizeof(WordEntry);
+}
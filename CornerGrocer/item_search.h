@@ -0,0 +1,107 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Item Search header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef ITEM_SEARCH_H
+#define ITEM_SEARCH_H
+#include "frequency_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/* This file finds items the way a person would type them, rather than only
+* by their exact name. Names and queries are both normalized: letters are
+* lower cased (ASCII only, other bytes are compared as they are) and runs of
+* whitespace become one space, so "green  APPLES" is "green apples".
+*
+* Two sorted arrays are kept, both pointing into one buffer holding every
+* normalized name, so the index is a few words per item on top of the names:
+*
+*   names  item IDs sorted by normalized name, for exact matches
+*   words  one entry per word of every name, sorted by the word then the
+*          name, so the items with a word starting with some prefix are one
+*          contiguous range found by binary search, already in the order
+*          they are listed in
+*
+* A search matches items where every word of the query starts some word of
+* the name, in any order: "ca" finds Cabbage, Cantaloupe and Red Cabbage,
+* "app gr" finds Green Apples. Each lookup is a binary search, so it takes
+* microseconds however many items there are, and a search then only walks
+* its range until it has found as many items as it was asked for. */
+
+//name lower cased with whitespace runs made one space and trimmed
+std::string NormalizeItemName(std::string_view name);
+
+class ItemSearchIndex {
+public:
+	/*indexes every item of items, replacing whatever was indexed before. IDs
+	* are items' IDs, so they can be used with items afterwards. Items added
+	* to the table later aren't found until it is built again.*/
+	void Build(const FrequencyTable& items);
+
+	/*fills ids with every item whose normalized name is the normalized
+	* query, usually one, in ID order. ids is cleared first.*/
+	void FindExact(std::string_view query, std::vector<uint32_t>& ids) const;
+
+	/*fills ids with up to limit items matching every word of query (see
+	* above), ordered by the name word that matched the query's most
+	* selective word, then by name. ids is cleared first. A query with no
+	* words matches nothing.*/
+	void Search(std::string_view query, std::size_t limit,
+		        std::vector<uint32_t>& ids) const;
+
+	//number of items indexed
+	uint32_t size() const { return static_cast<uint32_t>(names_.size()); }
+
+	//bytes used by the index, names included
+	std::size_t memory_bytes() const;
+
+private:
+	//one word of one name: where it is in keys_, and whose name it is in
+	struct WordEntry {
+		uint32_t offset;
+		uint32_t length;
+		uint32_t id;
+	};
+
+	//normalized name of the item with the given ID
+	std::string_view Key(uint32_t id) const {
+		return std::string_view(keys_).substr(key_offsets_[id],
+			key_offsets_[id + 1] - key_offsets_[id]);
+	}
+
+	//true if a's normalized name sorts before b's, ties going to the lower ID
+	bool NameBefore(uint32_t a, uint32_t b) const {
+		std::string_view key_a = Key(a);
+		std::string_view key_b = Key(b);
+		return key_a != key_b ? key_a < key_b : a < b;
+	}
+
+	//the text of a word entry
+	std::string_view Word(const WordEntry& entry) const {
+		return std::string_view(keys_).substr(entry.offset, entry.length);
+	}
+
+	//range of words_ whose words start with prefix
+	std::pair<std::size_t, std::size_t> WordRange(
+		std::string_view prefix) const;
+
+	std::string keys_; //every normalized name, back to back in ID order
+	std::vector<uint32_t> key_offsets_; //where each ID's name starts, + end
+	std::vector<uint32_t> names_; //IDs sorted by normalized name
+	std::vector<WordEntry> words_; //every word, sorted by word then name
+};
+#endif
@@ -0,0 +1,228 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Line Scanner definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "line_scanner.h"
+#include <charconv>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+	defined(_M_IX86)
+#define LINE_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(LINE_SCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+/*GCC and Clang only let a function use AVX2 instructions when told to, so
+* the vector versions are compiled for their instruction set one function at
+* a time. The rest of the program stays runnable on any x86 processor.*/
+#define LINE_SCANNER_TARGET(isa) __attribute__((target(isa)))
+#else
+//MSVC allows any intrinsic anywhere, nothing to mark
+#define LINE_SCANNER_TARGET(isa)
+#endif
+
+namespace {
+//signature shared by the three ByteMask64 implementations
+typedef uint64_t (*ByteMaskFunction)(const char* block, char byte);
+
+//byte at a time version, for processors without SSE2 or AVX2
+uint64_t ByteMaskScalar(const char* block, char byte) {
+	uint64_t mask = 0; //bit i set when block[i] == byte
+	for (unsigned i = 0; i < 64; ++i) {
+		mask |= static_cast<uint64_t>(block[i] == byte) << i;
+	}
+	return mask;
+}
+
+#ifdef LINE_SCANNER_X86
+/*SSE2 version: four 16 byte compares, each turned into a 16 bit mask with
+* movemask, then stitched together into one 64 bit mask*/
+LINE_SCANNER_TARGET("sse2")
+uint64_t ByteMaskSse2(const char* block, char byte) {
+	const __m128i needle = _mm_set1_epi8(byte); //byte copied into all lanes
+	uint64_t mask = 0;
+	for (unsigned i = 0; i < 4; ++i) {
+		__m128i chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(block + i * 16));
+		uint32_t bits = static_cast<uint32_t>(
+			_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+		mask |= static_cast<uint64_t>(bits & 0xFFFF) << (i * 16);
+	}
+	return mask;
+}
+
+//AVX2 version: two 32 byte compares, each giving a 32 bit mask
+LINE_SCANNER_TARGET("avx2")
+uint64_t ByteMaskAvx2(const char* block, char byte) {
+	const __m256i needle = _mm256_set1_epi8(byte); //byte in all 32 lanes
+	__m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+	__m256i high = _mm256_loadu_si256(
+		reinterpret_cast<const __m256i*>(block + 32));
+	uint32_t low_bits = static_cast<uint32_t>(
+		_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)));
+	uint32_t high_bits = static_cast<uint32_t>(
+		_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)));
+	return static_cast<uint64_t>(high_bits) << 32 | low_bits;
+}
+
+/*asks the processor (and, for AVX2, the operating system, which has to save
+* the wider registers on a context switch) what is supported*/
+#if defined(_MSC_VER)
+bool HasAvx2() {
+	int info[4]; //eax, ebx, ecx, edx
+	__cpuid(info, 0);
+	if (info[0] < 7) { return false; } //leaf 7 (AVX2 flag) not available
+	__cpuid(info, 1);
+	bool os_saves_avx = (info[2] & (1 << 27)) != 0; //OSXSAVE
+	bool has_avx = (info[2] & (1 << 28)) != 0;
+	if (!os_saves_avx || !has_avx) { return false; }
+	if ((_xgetbv(0) & 6) != 6) { return false; } //XMM and YMM state saved
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0; //AVX2 is bit 5 of ebx
+}
+
+bool HasSse2() {
+#if defined(_M_X64)
+	return true; //every 64 bit x86 processor has SSE2
+#else
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0; //SSE2 is bit 26 of edx
+#endif
+}
+#else
+bool HasAvx2() { return __builtin_cpu_supports("avx2") != 0; }
+bool HasSse2() { return __builtin_cpu_supports("sse2") != 0; }
+#endif
+#endif
+
+//the implementation picked for this processor, and its name
+struct ScannerChoice {
+	ByteMaskFunction byte_mask;
+	const char* name;
+};
+
+//picks the widest implementation this processor can run
+ScannerChoice ChooseScanner() {
+#ifdef LINE_SCANNER_X86
+	if (HasAvx2()) { return ScannerChoice{ByteMaskAvx2, "avx2"}; }
+	if (HasSse2()) { return ScannerChoice{ByteMaskSse2, "sse2"}; }
+#endif
+	return ScannerChoice{ByteMaskScalar, "scalar"};
+}
+
+/*made on first use rather than at startup, so the choice is always ready
+* even when another file's static objects scan something first*/
+const ScannerChoice& Scanner() {
+	static const ScannerChoice choice = ChooseScanner();
+	return choice;
+}
+}  // namespace
+
+//runs whichever implementation was picked for this processor
+uint64_t ByteMask64(const char* block, char byte) {
+	return Scanner().byte_mask(block, byte);
+}
+
+const char* ScannerInstructionSet() { return Scanner().name; }
+
+/*checks whole 64 byte blocks with the vector mask, then finishes the last
+* few bytes one at a time*/
+const char* FindByte(const char* begin, const char* end, char byte) {
+	ByteMaskFunction byte_mask = Scanner().byte_mask;
+	const char* block = begin;
+	for (; end - block >= 64; block += 64) {
+		uint64_t mask = byte_mask(block, byte);
+		if (mask != 0) { //lowest set bit is the first match in this block
+			return block + LowestSetBit(mask);
+		}
+	}
+	const void* found = std::memchr(block, byte, end - block);
+	return found != nullptr ? static_cast<const char*>(found) : end;
+}
+
+//adds up the set bits of every block's newline mask
+std::size_t CountNewlines(const char* data, std::size_t size) {
+	ByteMaskFunction byte_mask = Scanner().byte_mask;
+	std::size_t count = 0;
+	std::size_t offset = 0;
+	for (; size - offset >= 64; offset += 64) {
+		uint64_t mask = byte_mask(data + offset, '\n');
+		while (mask != 0) { //clear one set bit per pass (Kernighan's method)
+			mask &= mask - 1;
+			++count;
+		}
+	}
+	for (; offset < size; ++offset) { //last partial block
+		count += data[offset] == '\n';
+	}
+	return count;
+}
+
+/*a whole block is scanned straight out of the buffer. A short last block is
+* copied into a zeroed 64 byte buffer first, so the vector code never reads
+* past the end of the caller's memory.*/
+uint64_t LineScanner::LoadBlock() {
+	std::size_t remaining = size_ - block_start_;
+	uint64_t mask;
+	if (remaining >= 64) {
+		mask = ByteMask64(data_ + block_start_, '\n');
+	}
+	else {
+		char padded[64] = {}; //zero bytes never match '\n'
+		std::memcpy(padded, data_ + block_start_, remaining);
+		mask = ByteMask64(padded, '\n');
+	}
+	block_start_ += 64;
+	return mask;
+}
+
+/*looks backwards for the last space or tab, then skips backwards over the
+* rest of that run so "Apples   12" splits into "Apples" and "12"*/
+bool SplitLastField(std::string_view line, std::string_view& head,
+	                std::string_view& last_field) {
+	std::size_t separator = line.find_last_of(" \t");
+	if (separator == std::string_view::npos) { return false; }
+	std::size_t head_end = separator;
+	while (head_end > 0 && (line[head_end - 1] == ' ' ||
+		                    line[head_end - 1] == '\t')) {
+		--head_end;
+	}
+	head = line.substr(0, head_end);
+	last_field = line.substr(separator + 1);
+	return true;
+}
+
+//start from an even split, then move to the start of the next line
+std::vector<const char*> SplitAtLines(const char* data, std::size_t size,
+	                                  std::size_t chunk_count) {
+	const char* end = data + size;
+	std::vector<const char*> bounds; //chunk i is bounds[i] to bounds[i + 1]
+	bounds.push_back(data);
+	for (std::size_t chunk = 1; chunk < chunk_count; ++chunk) {
+		const char* bound = data + size / chunk_count * chunk;
+		if (bound < bounds.back()) { bound = bounds.back(); }
+		const char* newline = FindByte(bound, end, '\n');
+		bounds.push_back(newline != end ? newline + 1 : end);
+	}
+	bounds.push_back(end);
+	return bounds;
+}
+
+//from_chars does no locale lookups and no allocation, unlike stoi
+bool ParseInteger(std::string_view text, int64_t& value) {
+	const char* end = text.data() + text.size();
+	std::from_chars_result result = std::from_chars(text.data(), end, value);
+	return result.ec == std::errc() && result.ptr == end && !text.empty();
+}
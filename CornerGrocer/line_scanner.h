@@ -0,0 +1,153 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Line Scanner header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef LINE_SCANNER_H
+#define LINE_SCANNER_H
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* This file holds the text scanning shared by every reader in the project
+* (the sales log, the frequency file, and anything built on them). Finding
+* newlines is the hot part, so it is done 64 bytes at a time with AVX2 when
+* the processor has it, with SSE2 otherwise, and a byte at a time on
+* processors with neither. The choice is made once, the first time anything
+* is scanned. Everything else works on string_views into the caller's
+* buffer, so nothing is copied or allocated. */
+
+/*Returns a bit mask with bit i set when block[i] == byte, for the 64 bytes
+* starting at block. Used by LineScanner and FindByte, exposed so callers can
+* scan for other separators the same way. */
+uint64_t ByteMask64(const char* block, char byte);
+
+/*Returns a pointer to the first occurrence of byte between begin and end,
+* or end if there isn't one. Scans 64 bytes at a time.*/
+const char* FindByte(const char* begin, const char* end, char byte);
+
+//Name of the instruction set the scanner picked: "avx2", "sse2" or "scalar"
+const char* ScannerInstructionSet();
+
+/*Returns the number of newline characters in the buffer. This is the bare
+* cost of scanning, with no per line work, and is what the benchmark uses to
+* measure scan throughput.*/
+std::size_t CountNewlines(const char* data, std::size_t size);
+
+//index of the lowest set bit of a non-zero mask
+#if defined(_MSC_VER)
+inline unsigned LowestSetBit(uint64_t mask) {
+	unsigned long index; //filled in by the intrinsic
+#if defined(_M_X64) || defined(_M_ARM64)
+	_BitScanForward64(&index, mask);
+	return static_cast<unsigned>(index);
+#else
+	//32 bit builds only have the 32 bit intrinsic, check each half
+	if (static_cast<uint32_t>(mask) != 0) {
+		_BitScanForward(&index, static_cast<uint32_t>(mask));
+		return static_cast<unsigned>(index);
+	}
+	_BitScanForward(&index, static_cast<uint32_t>(mask >> 32));
+	return static_cast<unsigned>(index) + 32;
+#endif
+}
+#else
+inline unsigned LowestSetBit(uint64_t mask) {
+	return static_cast<unsigned>(__builtin_ctzll(mask));
+}
+#endif
+
+//true for the characters Python's str.strip() removes from item lines
+inline bool IsLineWhitespace(char character) {
+	return character == ' ' || character == '\t' || character == '\r' ||
+		character == '\v' || character == '\f';
+}
+
+//returns text without leading or trailing whitespace, without copying
+inline std::string_view TrimWhitespace(std::string_view text) {
+	std::size_t first = 0;
+	std::size_t last = text.size();
+	while (first < last && IsLineWhitespace(text[first])) { ++first; }
+	while (last > first && IsLineWhitespace(text[last - 1])) { --last; }
+	return text.substr(first, last - first);
+}
+
+/*Splits line at its last run of spaces or tabs. head gets everything before
+* it, last_field everything after. Returns false, leaving both untouched, if
+* the line has no separator. Splitting at the last separator keeps item names
+* that contain spaces whole. line should already be trimmed.*/
+bool SplitLastField(std::string_view line, std::string_view& head,
+	                std::string_view& last_field);
+
+/*Parses text as a whole decimal number with std::from_chars. Returns false
+* unless every character of text is part of the number.*/
+bool ParseInteger(std::string_view text, int64_t& value);
+
+/*Splits a buffer into chunk_count pieces of about the same size for
+* counting on separate threads. Each boundary is moved forward to just past
+* the next newline, so no line is ever split between two pieces. Returns
+* chunk_count + 1 bounds, piece i being bounds[i] to bounds[i + 1]; pieces
+* can be empty when lines are long.*/
+std::vector<const char*> SplitAtLines(const char* data, std::size_t size,
+	                                  std::size_t chunk_count);
+
+/*Hands out the lines of a buffer one at a time, without the trailing
+* newline. A 64 bit mask of newline positions is built for each 64 byte block
+* and then walked a bit at a time, so lines shorter than a block (nearly all
+* of them) cost one bit scan each rather than one search each. The last line
+* is returned even if the buffer doesn't end with a newline. */
+class LineScanner {
+public:
+	LineScanner(const char* data, std::size_t size)
+		: data_(data), size_(size) {}
+
+	/*sets line to the next line and returns true, or returns false once
+	* every line has been handed out*/
+	bool Next(std::string_view& line) {
+		while (newline_mask_ == 0) { //no newlines left in the current block
+			if (block_start_ >= size_) { //out of blocks, maybe a last line
+				if (line_start_ >= size_) { return false; }
+				line = std::string_view(data_ + line_start_,
+					                    size_ - line_start_);
+				line_start_ = size_;
+				return true;
+			}
+			newline_mask_ = LoadBlock();
+		}
+		//lowest set bit is the next newline in this block
+		std::size_t newline = block_start_ - 64 + LowestSetBit(newline_mask_);
+		newline_mask_ &= newline_mask_ - 1; //clear that bit
+		line = std::string_view(data_ + line_start_, newline - line_start_);
+		line_start_ = newline + 1;
+		return true;
+	}
+
+	//offset of the first byte not yet handed out in a line
+	std::size_t position() const { return line_start_; }
+
+private:
+	/*builds the newline mask of the block at block_start_ and moves
+	* block_start_ on by 64. A short last block is padded with zero bits.*/
+	uint64_t LoadBlock();
+
+	const char* data_; //buffer being scanned
+	std::size_t size_; //length of buffer
+	std::size_t block_start_ = 0; //offset of the next block to load
+	std::size_t line_start_ = 0; //offset where the next line starts
+	uint64_t newline_mask_ = 0; //newlines in the current block not yet used
+};
+
+#endif
@@ -0,0 +1,403 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Log Follower definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "log_follower.h"
+#include "background_task.h"
+#include "compressed_input.h"
+#include "line_scanner.h"
+#include "sales_record.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace {
+//how much of the file is read into memory at a time
+const std::size_t kReadBlockBytes = 1 << 20;
+}  // namespace
+
+LogFollower::LogFollower(const std::string& file_name,
+	                     FrequencyEngine& engine)
+	: file_name_(file_name), engine_(engine) {}
+
+LogFollower::~LogFollower() {
+	CloseFile();
+#ifdef __linux__
+	if (inotify_descriptor_ != -1) { close(inotify_descriptor_); }
+#endif
+}
+
+/*the provisional count is taken back first and worked out again last, so
+* in between, everything read is counted as if no guess had been made.*/
+FollowUpdate LogFollower::Poll() {
+	FollowUpdate update;
+	int64_t units_before = engine_.TotalUnits();
+	UndoProvisional();
+	if (!open_ && !OpenFile()) { return update; } //no file to follow yet
+
+	//shorter than what was already read: truncated, start from the top
+	uint64_t size = OpenSize();
+	if (size < offset_) {
+		update.event = FollowEvent::kTruncated;
+		offset_ = 0;
+		pending_.clear(); //an unfinished line that was cut off
+	}
+	update.bytes += ReadTo(size, false);
+
+	/*the name belongs to another file now: finish the old one (it can't
+	* grow any more once the writers have moved on), then start the new one.
+	* A cancelled read leaves that to the next Poll.*/
+	FileIdentity named;
+	bool cancelled = progress_ != nullptr && progress_->cancelled();
+	if (!cancelled && NameIdentity(named) && named != identity_) {
+		update.bytes += ReadTo(OpenSize(), true);
+		CloseFile();
+		update.event = FollowEvent::kRotated;
+		if (OpenFile()) { update.bytes += ReadTo(OpenSize(), false); }
+	}
+
+	CountProvisional();
+	if (update.event == FollowEvent::kNone && update.bytes != 0) {
+		update.event = FollowEvent::kAppended;
+	}
+	update.units = engine_.TotalUnits() - units_before;
+	return update;
+}
+
+/*reads a block at a time onto the end of pending_, then counts everything
+* up to the block's last newline. Whatever follows it stays in pending_ to
+* be finished by the next block (or the next Poll). New bytes that start
+* with a compressed member's magic bytes are decompressed instead.*/
+uint64_t LogFollower::ReadTo(uint64_t end, bool final) {
+	uint64_t start = offset_;
+	if (offset_ < end && pending_.empty()) {
+		char magic[4]; //enough to tell gzip and zstd apart from text
+		std::size_t got = ReadAt(offset_, magic, sizeof(magic));
+		if (DetectCompression(magic, got) != InputCompression::kNone) {
+			return ReadCompressed();
+		}
+	}
+	if (progress_ != nullptr) { progress_->set_total(end); }
+	while (offset_ < end) {
+		if (progress_ != nullptr) {
+			//a rotated file's last bytes are read anyway, or they'd be lost
+			if (!final && progress_->cancelled()) { break; }
+			progress_->set_done(offset_);
+		}
+		std::size_t wanted = static_cast<std::size_t>(
+			std::min<uint64_t>(kReadBlockBytes, end - offset_));
+		std::size_t kept = pending_.size(); //carried over from before
+		pending_.resize(kept + wanted);
+		std::size_t got = 0;
+		try {
+			got = ReadAt(offset_, &pending_[kept], wanted);
+		}
+		catch (std::runtime_error&) {
+			pending_.resize(kept);
+			throw;
+		}
+		pending_.resize(kept + got);
+		offset_ += got;
+		if (got == 0) { break; } //shrank while being read, Poll will see
+
+		std::size_t last_newline = pending_.rfind('\n');
+		if (last_newline != std::string::npos) {
+			engine_.CountBuffer(pending_.data(), last_newline + 1);
+			pending_.erase(0, last_newline + 1);
+		}
+	}
+	if (progress_ != nullptr) { progress_->set_done(offset_); }
+	if (final && !pending_.empty()) { //nothing more is coming, count it
+		engine_.CountBuffer(pending_.data(), pending_.size());
+		pending_.clear();
+	}
+	return offset_ - start;
+}
+
+/*a member can't be picked up part way through, so everything from offset_
+* to the end is decompressed in one go, and cancelling only stops the next
+* Poll. It is counted into an engine of its own and merged once it is all
+* there, so a member still being written is simply tried again by the next
+* Poll. The reader maps the file by name, so a compressed file that was
+* renamed away isn't read any further.*/
+uint64_t LogFollower::ReadCompressed() {
+	FileIdentity named;
+	if (!NameIdentity(named) || named != identity_) { return 0; }
+	uint64_t start = offset_;
+	DecompressingReader reader(file_name_, offset_);
+	FrequencyEngine added; //what was appended, until it is known complete
+	added.set_thread_count(engine_.thread_count());
+	if (engine_.time_windows() != nullptr) {
+		added.EnableTimeWindows(engine_.time_windows()->options());
+	}
+	if (progress_ != nullptr) { progress_->set_total(start + reader.size()); }
+	try {
+		for (std::string_view lines; reader.Next(lines);) {
+			added.CountBuffer(lines.data(), lines.size());
+			if (progress_ != nullptr) {
+				progress_->set_done(start + reader.consumed());
+			}
+		}
+	}
+	catch (std::runtime_error&) {
+		if (reader.cut_short()) { return 0; } //the rest isn't written yet
+		throw;
+	}
+	engine_.Merge(added);
+	offset_ = start + reader.size();
+	return offset_ - start;
+}
+
+/*the unfinished line is counted as the item it names so far. Only its total
+* is guessed at; it goes into a time bucket once it is finished. Whether it
+* added the item is kept, so the undo can take the item away again.*/
+void LogFollower::CountProvisional() {
+	std::string_view item_name = TrimWhitespace(pending_);
+	int64_t seconds = 0; //a timestamp isn't part of the name
+	SplitTimestamp(item_name, seconds, item_name);
+	SalesRecord record; //its quantity and price, so far
+	ParseSalesRecord(item_name, record);
+	if (record.item_name.empty()) { return; }
+	provisional_.assign(record.item_name.data(), record.item_name.size());
+	provisional_quantity_ = record.quantity;
+	provisional_revenue_ = RecordRevenue(record);
+	uint32_t items_before = engine_.Items().size();
+	engine_.Add(provisional_, provisional_quantity_, provisional_revenue_);
+	provisional_added_ = engine_.Items().size() != items_before;
+}
+
+/*nothing is counted between a provisional count and its undo, so an item
+* the provisional count added is still the last one, and is removed if
+* taking the count back left it with nothing*/
+void LogFollower::UndoProvisional() {
+	if (provisional_.empty()) { return; }
+	engine_.Add(provisional_, -provisional_quantity_, -provisional_revenue_);
+	const FrequencyTable& items = engine_.Items();
+	uint32_t last = items.size() - 1;
+	if (provisional_added_ && items.Name(last) == provisional_ &&
+		items.Count(last) == 0 && items.Revenue(last) == 0) {
+		engine_.RemoveLastItem();
+	}
+	provisional_.clear();
+	provisional_added_ = false;
+}
+
+#ifdef _WIN32
+/*the file is opened letting others write, rename and delete it while it is
+* open, or the registers (and log rotation) would be locked out*/
+bool LogFollower::OpenFile() {
+	HANDLE file = CreateFileA(file_name_.c_str(), GENERIC_READ,
+		                      FILE_SHARE_READ | FILE_SHARE_WRITE |
+		                      FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+		                      FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		DWORD error = GetLastError();
+		if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) {
+			return false;
+		}
+		throw std::runtime_error("Error opening File: " + file_name_);
+	}
+	file_handle_ = file;
+	open_ = true;
+	offset_ = resume_offset_; //0 unless resuming from a snapshot
+	resume_offset_ = 0;
+	identity_ = OpenIdentity();
+	return true;
+}
+
+void LogFollower::CloseFile() {
+	if (open_) { CloseHandle(file_handle_); }
+	file_handle_ = nullptr;
+	open_ = false;
+}
+
+LogFollower::FileIdentity LogFollower::OpenIdentity() const {
+	BY_HANDLE_FILE_INFORMATION information;
+	FileIdentity identity;
+	if (GetFileInformationByHandle(file_handle_, &information)) {
+		identity.device = information.dwVolumeSerialNumber;
+		identity.file = static_cast<uint64_t>(information.nFileIndexHigh) <<
+			32 | information.nFileIndexLow;
+	}
+	return identity;
+}
+
+uint64_t LogFollower::OpenSize() const {
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_handle_, &size)) { return offset_; }
+	return static_cast<uint64_t>(size.QuadPart);
+}
+
+std::size_t LogFollower::ReadAt(uint64_t offset, char* buffer,
+	                            std::size_t size) const {
+	OVERLAPPED position = {};
+	position.Offset = static_cast<DWORD>(offset);
+	position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+	DWORD read = 0;
+	if (!ReadFile(file_handle_, buffer, static_cast<DWORD>(size), &read,
+		          &position)) {
+		throw std::runtime_error("Error reading File: " + file_name_);
+	}
+	return read;
+}
+
+//opening with no access at all is enough to ask for the identity
+bool LogFollower::NameIdentity(FileIdentity& identity) const {
+	HANDLE file = CreateFileA(file_name_.c_str(), 0,
+		                      FILE_SHARE_READ | FILE_SHARE_WRITE |
+		                      FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+		                      FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+	BY_HANDLE_FILE_INFORMATION information;
+	bool found = GetFileInformationByHandle(file, &information) != 0;
+	CloseHandle(file);
+	if (!found) { return false; }
+	identity.device = information.dwVolumeSerialNumber;
+	identity.file = static_cast<uint64_t>(information.nFileIndexHigh) << 32 |
+		information.nFileIndexLow;
+	return true;
+}
+#else
+bool LogFollower::OpenFile() {
+	int descriptor = open(file_name_.c_str(), O_RDONLY);
+	if (descriptor == -1) {
+		if (errno == ENOENT) { return false; } //not there (yet)
+		throw std::runtime_error("Error opening File: " + file_name_);
+	}
+	file_descriptor_ = descriptor;
+	open_ = true;
+	offset_ = resume_offset_; //0 unless resuming from a snapshot
+	resume_offset_ = 0;
+	identity_ = OpenIdentity();
+	return true;
+}
+
+void LogFollower::CloseFile() {
+	if (open_) { close(file_descriptor_); }
+	file_descriptor_ = -1;
+	open_ = false;
+}
+
+LogFollower::FileIdentity LogFollower::OpenIdentity() const {
+	struct stat status;
+	FileIdentity identity;
+	if (fstat(file_descriptor_, &status) == 0) {
+		identity.device = status.st_dev;
+		identity.file = status.st_ino;
+	}
+	return identity;
+}
+
+uint64_t LogFollower::OpenSize() const {
+	struct stat status;
+	if (fstat(file_descriptor_, &status) != 0) { return offset_; }
+	return static_cast<uint64_t>(status.st_size);
+}
+
+std::size_t LogFollower::ReadAt(uint64_t offset, char* buffer,
+	                            std::size_t size) const {
+	ssize_t read = pread(file_descriptor_, buffer, size,
+		                 static_cast<off_t>(offset));
+	if (read < 0) {
+		throw std::runtime_error("Error reading File: " + file_name_);
+	}
+	return static_cast<std::size_t>(read);
+}
+
+bool LogFollower::NameIdentity(FileIdentity& identity) const {
+	struct stat status;
+	if (stat(file_name_.c_str(), &status) != 0) { return false; }
+	identity.device = status.st_dev;
+	identity.file = status.st_ino;
+	return true;
+}
+#endif
+
+#ifdef __linux__
+/*watches the directory rather than the file, since a rotation replaces the
+* file: the directory sees the new file arrive, a watch on the old file
+* would not. Events for other files in the directory are read and ignored.*/
+bool LogFollower::WaitForChange(unsigned timeout_milliseconds) {
+	std::size_t slash = file_name_.rfind('/');
+	std::string base_name = slash == std::string::npos ?
+		file_name_ : file_name_.substr(slash + 1);
+	if (inotify_descriptor_ == -1) {
+		std::string directory = slash == std::string::npos ? "." :
+			slash == 0 ? "/" : file_name_.substr(0, slash);
+		inotify_descriptor_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotify_descriptor_ != -1 &&
+			inotify_add_watch(inotify_descriptor_, directory.c_str(),
+				              IN_MODIFY | IN_CREATE | IN_DELETE |
+				              IN_MOVED_FROM | IN_MOVED_TO |
+				              IN_CLOSE_WRITE) == -1) {
+			close(inotify_descriptor_); //can't watch, fall back to sleeping
+			inotify_descriptor_ = -1;
+		}
+	}
+	if (inotify_descriptor_ == -1) {
+		std::this_thread::sleep_for(
+			std::chrono::milliseconds(timeout_milliseconds));
+		return true;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() +
+		std::chrono::milliseconds(timeout_milliseconds);
+	alignas(inotify_event) char events[4096];
+	while (true) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+			deadline - std::chrono::steady_clock::now()).count();
+		if (left <= 0) { return false; }
+		pollfd waiting = {inotify_descriptor_, POLLIN, 0};
+		if (poll(&waiting, 1, static_cast<int>(left)) <= 0) { return false; }
+
+		//read every queued event, noting whether any was for our file
+		bool changed = false;
+		ssize_t length;
+		while ((length = read(inotify_descriptor_, events,
+			                  sizeof(events))) > 0) {
+			for (ssize_t at = 0; at < length;) {
+				const inotify_event* event =
+					reinterpret_cast<const inotify_event*>(events + at);
+				if (event->len == 0 || base_name == event->name) {
+					changed = true;
+				}
+				at += sizeof(inotify_event) + event->len;
+			}
+		}
+		if (changed) { return true; }
+	}
+}
+#else
+//no change notifications here, so just wait and let Poll look
+bool LogFollower::WaitForChange(unsigned timeout_milliseconds) {
+	std::this_thread::sleep_for(
+		std::chrono::milliseconds(timeout_milliseconds));
+	return true;
+}
+#endif
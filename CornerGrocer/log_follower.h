@@ -0,0 +1,188 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Log Follower header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef LOG_FOLLOWER_H
+#define LOG_FOLLOWER_H
+#include "frequency_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TaskProgress; //see background_task.h
+
+/* This file follows a sales log that the registers keep appending to, the
+* way "tail -F" does, applying only the new lines to a FrequencyEngine's
+* counts instead of recounting the whole file.
+*
+* The follower remembers how far into the file it has read. A file that is
+* now shorter than that was truncated (rotated in place, as logrotate's
+* copytruncate does), so reading starts again from the top. A file name
+* that now belongs to a different file was rotated by renaming: the old
+* file is still open, so whatever was appended to it before the rename is
+* read to its end first, then the new file is read from the top. Counts
+* from before a rotation or truncation are kept, since those sales still
+* happened.
+*
+* A last line without its newline yet is counted provisionally, so a log
+* that simply doesn't end in a newline counts the same as with
+* FrequencyEngine::CountFile. If the line turns out to be unfinished, the
+* provisional count is taken back and the finished line counted instead.
+* A guessed name that wasn't an item before is removed again along with
+* its count, rather than being left listed as sold 0 times.
+*
+* A gzip or zstd log (see compressed_input.h) is followed too, as long as
+* whole members are added to it: whatever is new is decompressed and
+* counted in one go, so there is never a provisional line, and a member
+* that is still being written is left for a later Poll to count whole. */
+
+//the most notable thing Poll found, in increasing order of notability
+enum class FollowEvent {
+	kNone, //nothing new
+	kAppended, //new lines at the end of the same file
+	kTruncated, //the file got shorter, reading restarted from the top
+	kRotated //the name now points at a new file, which was read from the top
+};
+
+//what one call to Poll did
+struct FollowUpdate {
+	FollowEvent event = FollowEvent::kNone;
+	uint64_t bytes = 0; //bytes read from the file(s)
+	int64_t units = 0; //change in the total units counted
+};
+
+class LogFollower {
+public:
+	/*follows file_name, counting into engine, which has to outlive the
+	* follower. Nothing is read until the first Poll, which reads the whole
+	* file. The file doesn't have to exist yet. */
+	LogFollower(const std::string& file_name, FrequencyEngine& engine);
+	~LogFollower();
+
+	//a follower owns an open file, so copying one would close it twice
+	LogFollower(const LogFollower&) = delete;
+	LogFollower& operator=(const LogFollower&) = delete;
+
+	/*reads whatever was added since the last call and counts it, handling
+	* truncation and rotation as described above. Returns kNone if the file
+	* doesn't exist (yet, or mid rotation). Throws std::runtime_error if the
+	* file exists but can't be read. */
+	FollowUpdate Poll();
+
+	/*waits until the file may have changed, or timeout_milliseconds pass.
+	* On Linux this sleeps on inotify events for the file's directory; on
+	* other systems it simply sleeps for the timeout, so Poll polls. Returns
+	* true if the file may have changed. */
+	bool WaitForChange(unsigned timeout_milliseconds);
+
+	/*bytes of the current file counted so far, not including a last line
+	* counted provisionally*/
+	uint64_t offset() const { return offset_ - pending_.size(); }
+
+	/*item counted provisionally for the unfinished last line, or empty if
+	* there isn't one*/
+	const std::string& provisional() const { return provisional_; }
+
+	/*units and revenue in cents counted for the provisional item, 0 if
+	* there isn't one*/
+	int64_t provisional_quantity() const {
+		return provisional_.empty() ? 0 : provisional_quantity_;
+	}
+	int64_t provisional_revenue() const {
+		return provisional_.empty() ? 0 : provisional_revenue_;
+	}
+
+	/*true if the provisional item wasn't counted before, which makes it
+	* the engine's last item until the count is taken back*/
+	bool provisional_added() const {
+		return !provisional_.empty() && provisional_added_;
+	}
+
+	/*makes the first Poll start reading at offset instead of the top, for
+	* counts restored from a snapshot that already cover the file up to
+	* there. A file shorter than offset is read from the top as usual.*/
+	void ResumeAt(uint64_t offset) { resume_offset_ = offset; }
+
+	/*makes Poll report how far into the file it has read to progress, and
+	* stop after the block it is on once progress is cancelled. What was
+	* read before stopping stays counted and the next Poll carries on from
+	* there, as if the rest hadn't been written yet. nullptr (the default)
+	* turns this off; progress has to outlive the polls that use it.*/
+	void set_progress(TaskProgress* progress) { progress_ = progress; }
+
+	const std::string& file_name() const { return file_name_; }
+
+	//true once the file has been found and opened
+	bool file_open() const { return open_; }
+
+private:
+	//what makes a file the same file even if it is renamed
+	struct FileIdentity {
+		uint64_t device = 0; //device, or volume serial number on Windows
+		uint64_t file = 0; //inode, or file index on Windows
+		bool operator!=(const FileIdentity& other) const {
+			return device != other.device || file != other.file;
+		}
+	};
+
+	/*opens file_name_ and records its identity. Returns false if it doesn't
+	* exist, throws if it exists and can't be opened.*/
+	bool OpenFile();
+	void CloseFile();
+
+	//identity and size of the open file
+	FileIdentity OpenIdentity() const;
+	uint64_t OpenSize() const;
+
+	/*reads up to size bytes of the open file at offset into buffer and
+	* returns how many it got, 0 at the end. Throws if reading fails.*/
+	std::size_t ReadAt(uint64_t offset, char* buffer, std::size_t size) const;
+
+	/*identity of whatever file_name_ names right now. Returns false if
+	* nothing does.*/
+	bool NameIdentity(FileIdentity& identity) const;
+
+	/*reads the open file from offset_ up to end, counting every complete
+	* line, and returns the bytes read. With final, the last line is counted
+	* even without a newline, since nothing more will be added to it. */
+	uint64_t ReadTo(uint64_t end, bool final);
+
+	/*decompresses and counts the open file from offset_, which starts a
+	* compressed member, to its end, and returns the bytes read, 0 if the
+	* last member isn't finished yet*/
+	uint64_t ReadCompressed();
+
+	//counts pending_ provisionally, or takes that count back
+	void CountProvisional();
+	void UndoProvisional();
+
+	std::string file_name_; //the log being followed
+	FrequencyEngine& engine_; //counts are added here
+	uint64_t offset_ = 0; //bytes of the open file read so far
+	uint64_t resume_offset_ = 0; //where the next file opened starts
+	std::string pending_; //read bytes after the last newline
+	std::string provisional_; //item counted provisionally, empty for none
+	int64_t provisional_quantity_ = 0; //units it was counted with
+	int64_t provisional_revenue_ = 0; //cents it was counted with
+	bool provisional_added_ = false; //true if counting it added the item
+	FileIdentity identity_; //identity of the open file
+	bool open_ = false; //true while a file is open
+	TaskProgress* progress_ = nullptr; //see set_progress
+#ifdef _WIN32
+	void* file_handle_ = nullptr; //HANDLE from CreateFile
+#else
+	int file_descriptor_ = -1; //descriptor from open()
+	int inotify_descriptor_ = -1; //Linux only, -1 elsewhere or on failure
+#endif
+};
+#endif
@@ -14,15 +14,47 @@
 */
 #include "python_functions.h" //include PythonFunctions file
 #include "corner_grocer.h" //include CornerGrocer class definition
+#include "batch_mode.h" //include command line (batch) mode
+#include <iostream> //included to print usage and argument errors
 #include <memory> //included to support unique_ptr
 
 
-int main() {
+int main(int argc, char* argv[]) {
+	/*Any arguments at all mean batch mode: no menu, no prompts, no Python,
+	* results written to stdout. See batch_mode.h for details.*/
+	if (argc > 1) {
+		BatchOptions options;
+		std::string error; //set by ParseBatchOptions if arguments are bad
+		if (!ParseBatchOptions(argc, argv, options, error)) {
+			if (error.empty()) { //--help was asked for
+				PrintBatchUsage(std::cout);
+				return 0;
+			}
+			std::cerr << error << std::endl;
+			PrintBatchUsage(std::cerr);
+			return 2;
+		}
+		return RunBatch(options);
+	}
+
 	/*Create a unique_ptr to make memory management easier. Call CornerGrocer's
-	* parameterized constructor with hardcoded filenames. See corner_grocer.cpp 
-	* for details of constructor.*/
+	* parameterized constructor with hardcoded filenames, counting natively.
+	* See corner_grocer.cpp for details of constructor.*/
 	auto corner_grocer_instance = std::unique_ptr<CornerGrocer>(
-	  new CornerGrocer("CS210_Project_Three_Input_File.txt", "frequency.dat"));
+	  new CornerGrocer("CS210_Project_Three_Input_File.txt", "frequency.dat",
+		               CountingBackend::kNative));
+
+	//count the input file with one thread per core
+	corner_grocer_instance->SetIngestThreads(0);
+
+	//keep the last hour of timestamped sales in one minute buckets
+	corner_grocer_instance->SetTimeWindows(TimeWindowOptions());
+
+	//restart from the last snapshot instead of recounting the whole log
+	corner_grocer_instance->SetCheckpointFile("frequency.checkpoint");
+
+	//keep every day's counts, as frequency.dat only holds the last run's
+	corner_grocer_instance->SetHistoryFile("frequency.history");
 
 	//call cornerGrocerInstance's primary function, Application().
 	corner_grocer_instance->Application(); 
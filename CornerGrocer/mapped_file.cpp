@@ -0,0 +1,107 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Mapped File definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "mapped_file.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+/*Windows version of the constructor. The file is opened, a mapping object is
+* created for it, and a view of the whole file is mapped into memory.*/
+MappedFile::MappedFile(const std::string& file_name) {
+	//open file for reading, allowing others to keep writing to it
+	file_handle_ = CreateFileA(file_name.c_str(), GENERIC_READ,
+		                       FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+		                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file_handle_ == INVALID_HANDLE_VALUE) { //if file can't be opened...
+		file_handle_ = nullptr;
+		throw std::runtime_error("Error opening File: " + file_name);
+	}
+
+	LARGE_INTEGER file_size; //64 bit file size, filled in below
+	if (!GetFileSizeEx(file_handle_, &file_size)) {
+		CloseHandle(file_handle_);
+		throw std::runtime_error("Error reading size of File: " + file_name);
+	}
+	size_ = static_cast<std::size_t>(file_size.QuadPart);
+	if (size_ == 0) { return; } //nothing to map, data_ stays nullptr
+
+	//create a read only mapping object covering the whole file
+	mapping_handle_ = CreateFileMappingA(file_handle_, NULL, PAGE_READONLY,
+		                                 0, 0, NULL);
+	if (mapping_handle_ == NULL) {
+		CloseHandle(file_handle_);
+		throw std::runtime_error("Error mapping File: " + file_name);
+	}
+
+	//map a view of the entire file, offset 0, length 0 meaning "everything"
+	data_ = static_cast<const char*>(
+		MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr) {
+		CloseHandle(mapping_handle_);
+		CloseHandle(file_handle_);
+		throw std::runtime_error("Error mapping File: " + file_name);
+	}
+}
+
+//unmaps the view and closes both handles, in reverse order of creation
+MappedFile::~MappedFile() {
+	if (data_ != nullptr) { UnmapViewOfFile(data_); }
+	if (mapping_handle_ != nullptr) { CloseHandle(mapping_handle_); }
+	if (file_handle_ != nullptr) { CloseHandle(file_handle_); }
+}
+#else
+/*POSIX version of the constructor. The file is opened, its size found with
+* fstat, and the whole file mapped privately and read only.*/
+MappedFile::MappedFile(const std::string& file_name) {
+	file_descriptor_ = open(file_name.c_str(), O_RDONLY); //open read only
+	if (file_descriptor_ < 0) { //if file can't be opened...
+		throw std::runtime_error("Error opening File: " + file_name);
+	}
+
+	struct stat file_status; //filled in by fstat, holds the file size
+	if (fstat(file_descriptor_, &file_status) != 0) {
+		close(file_descriptor_);
+		throw std::runtime_error("Error reading size of File: " + file_name);
+	}
+	size_ = static_cast<std::size_t>(file_status.st_size);
+	if (size_ == 0) { return; } //mmap refuses zero lengths, leave data_ null
+
+	void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE,
+		                 file_descriptor_, 0);
+	if (mapping == MAP_FAILED) {
+		close(file_descriptor_);
+		throw std::runtime_error("Error mapping File: " + file_name);
+	}
+
+	//the file is read front to back, so let the kernel read ahead eagerly
+	madvise(mapping, size_, MADV_SEQUENTIAL);
+	data_ = static_cast<const char*>(mapping);
+}
+
+//unmaps the file and closes the descriptor
+MappedFile::~MappedFile() {
+	if (data_ != nullptr) { munmap(const_cast<char*>(data_), size_); }
+	if (file_descriptor_ >= 0) { close(file_descriptor_); }
+}
+#endif
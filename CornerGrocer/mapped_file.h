@@ -0,0 +1,52 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Mapped File header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <cstddef>
+#include <string>
+
+/*This class maps a whole file into memory, read only, so it can be scanned
+* as one big character array instead of being copied line by line through a
+* stream. Windows and POSIX systems map files differently, so the details are
+* hidden in mapped_file.cpp. The mapping is released when the object leaves
+* scope. Throws std::runtime_error if the file can't be opened or mapped. */
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& file_name);
+	~MappedFile();
+
+	//a mapping owns an OS handle, so copying one would unmap it twice
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/*returns a pointer to the first byte of the file. An empty file has
+	* nothing to map, so nullptr is returned in that case. */
+	const char* data() const { return data_; }
+
+	//returns the size of the mapped file in bytes
+	std::size_t size() const { return size_; }
+
+private:
+	const char* data_ = nullptr; //first byte of the mapping
+	std::size_t size_ = 0; //length of the mapping in bytes
+
+#ifdef _WIN32
+	void* file_handle_ = nullptr; //HANDLE from CreateFile
+	void* mapping_handle_ = nullptr; //HANDLE from CreateFileMapping
+#else
+	int file_descriptor_ = -1; //descriptor from open()
+#endif
+};
+#endif
@@ -0,0 +1,244 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Metrics definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "metrics.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+//calls under this many nanoseconds all go in bucket 0, 2^10
+const int kFirstBucketBits = 10;
+
+const int kStageCount = static_cast<int>(MetricStage::kCount);
+const int kCounterCount = static_cast<int>(MetricCounter::kCount);
+
+//appends nanoseconds to out as seconds, as short as it can be exactly
+void AppendSeconds(std::string& out, uint64_t nanoseconds) {
+	char text[32];
+	int length = std::snprintf(text, sizeof(text), "%.9g",
+		                       static_cast<double>(nanoseconds) / 1e9);
+	out.append(text, length);
+}
+}  // namespace
+
+/*the bucket is the number of bits above the first bucket's, found by
+* shifting, at most 32 steps and usually a handful*/
+void LatencyHistogram::Record(uint64_t nanoseconds) {
+	int index = 0;
+	for (uint64_t rest = nanoseconds >> kFirstBucketBits;
+		 rest != 0 && index < kBucketCount - 1; rest >>= 1) {
+		++index;
+	}
+	buckets_[index].fetch_add(1, std::memory_order_relaxed);
+	count_.fetch_add(1, std::memory_order_relaxed);
+	total_.fetch_add(nanoseconds, std::memory_order_relaxed);
+	uint64_t slowest = max_.load(std::memory_order_relaxed);
+	while (nanoseconds > slowest &&
+		   !max_.compare_exchange_weak(slowest, nanoseconds,
+			                           std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::BucketLimit(int index) {
+	return index < kBucketCount - 1 ?
+		uint64_t(1) << (kFirstBucketBits + index) : 0;
+}
+
+uint64_t LatencyHistogram::Quantile(double quantile) const {
+	uint64_t calls = count();
+	if (calls == 0) { return 0; }
+	uint64_t wanted = static_cast<uint64_t>(quantile * calls + 0.5);
+	if (wanted == 0) { wanted = 1; }
+	uint64_t seen = 0; //calls in the buckets so far
+	for (int index = 0; index < kBucketCount - 1; ++index) {
+		seen += bucket(index);
+		if (seen >= wanted) { return BucketLimit(index); }
+	}
+	return max_nanoseconds(); //in the last bucket, which has no bound
+}
+
+void LatencyHistogram::Reset() {
+	count_.store(0);
+	total_.store(0);
+	max_.store(0);
+	for (std::atomic<uint64_t>& calls : buckets_) { calls.store(0); }
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+	static MetricsRegistry registry;
+	return registry;
+}
+
+bool MetricsRegistry::enabled() {
+#ifdef CORNER_GROCER_ENABLE_METRICS
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MetricsRegistry::Reset() {
+	for (LatencyHistogram& histogram : stages_) { histogram.Reset(); }
+	for (std::atomic<uint64_t>& total : counters_) { total.store(0); }
+}
+
+const char* MetricStageName(MetricStage stage) {
+	switch (stage) {
+	case MetricStage::kPythonInit: return "python_init";
+	case MetricStage::kPythonCall: return "python_call";
+	case MetricStage::kFileRead: return "file_read";
+	case MetricStage::kFileWrite: return "file_write";
+	case MetricStage::kTerminalOutput: return "terminal_output";
+	case MetricStage::kIngest: return "ingest";
+	case MetricStage::kDecompress: return "decompress";
+	case MetricStage::kSpill: return "spill";
+	case MetricStage::kLookup: return "lookup";
+	default: return "unknown";
+	}
+}
+
+const char* MetricCounterName(MetricCounter counter) {
+	switch (counter) {
+	case MetricCounter::kBytesRead: return "bytes_read";
+	case MetricCounter::kBytesWritten: return "bytes_written";
+	case MetricCounter::kTerminalBytes: return "terminal_bytes";
+	case MetricCounter::kItemsLookedUp: return "items_looked_up";
+	default: return "unknown";
+	}
+}
+
+/*Prometheus histograms are cumulative, bucket "le" (less or equal) limits
+* in seconds, ending with "+Inf", then _sum and _count. Every stage is
+* written, called or not, so a scraper always sees the same series.*/
+std::string MetricsRegistry::Format(MetricsFormat format) const {
+	std::string out;
+	if (format == MetricsFormat::kPrometheus) {
+		out.append("# HELP corner_grocer_metrics_enabled 1 if the program "
+			       "was built to record metrics\n"
+			       "# TYPE corner_grocer_metrics_enabled gauge\n"
+			       "corner_grocer_metrics_enabled ");
+		out.append(enabled() ? "1\n" : "0\n");
+		out.append("# HELP corner_grocer_stage_seconds Time spent in each "
+			       "stage of the program\n"
+			       "# TYPE corner_grocer_stage_seconds histogram\n");
+		for (int index = 0; index < kStageCount; ++index) {
+			const LatencyHistogram& histogram = stages_[index];
+			std::string label = std::string("stage=\"") +
+				MetricStageName(static_cast<MetricStage>(index)) + "\"";
+			uint64_t cumulative = 0;
+			for (int bucket = 0; bucket < LatencyHistogram::kBucketCount;
+				 ++bucket) {
+				cumulative += histogram.bucket(bucket);
+				out.append("corner_grocer_stage_seconds_bucket{" + label +
+					       ",le=\"");
+				uint64_t limit = LatencyHistogram::BucketLimit(bucket);
+				if (limit == 0) { out.append("+Inf"); }
+				else { AppendSeconds(out, limit); }
+				out.append("\"} " + std::to_string(cumulative) + "\n");
+			}
+			out.append("corner_grocer_stage_seconds_sum{" + label + "} ");
+			AppendSeconds(out, histogram.total_nanoseconds());
+			out.append("\ncorner_grocer_stage_seconds_count{" + label + "} " +
+				       std::to_string(histogram.count()) + "\n");
+		}
+		for (int index = 0; index < kCounterCount; ++index) {
+			std::string name = std::string("corner_grocer_") +
+				MetricCounterName(static_cast<MetricCounter>(index)) +
+				"_total";
+			out.append("# TYPE " + name + " counter\n" + name + " " +
+				       std::to_string(counters_[index].load()) + "\n");
+		}
+		return out;
+	}
+
+	out.append("{\"enabled\": ");
+	out.append(enabled() ? "true" : "false");
+	out.append(", \"stages\": {");
+	for (int index = 0; index < kStageCount; ++index) {
+		const LatencyHistogram& histogram = stages_[index];
+		out.append(index == 0 ? "\n  \"" : ",\n  \"");
+		out.append(MetricStageName(static_cast<MetricStage>(index)));
+		out.append("\": {\"calls\": " + std::to_string(histogram.count()));
+		out.append(", \"total_seconds\": ");
+		AppendSeconds(out, histogram.total_nanoseconds());
+		out.append(", \"p50_seconds\": ");
+		AppendSeconds(out, histogram.Quantile(0.5));
+		out.append(", \"p99_seconds\": ");
+		AppendSeconds(out, histogram.Quantile(0.99));
+		out.append(", \"max_seconds\": ");
+		AppendSeconds(out, histogram.max_nanoseconds());
+		out.append(", \"buckets\": [");
+		for (int bucket = 0; bucket < LatencyHistogram::kBucketCount;
+			 ++bucket) {
+			if (bucket != 0) { out.append(", "); }
+			out.append(std::to_string(histogram.bucket(bucket)));
+		}
+		out.append("]}");
+	}
+	out.append("},\n \"counters\": {");
+	for (int index = 0; index < kCounterCount; ++index) {
+		out.append(index == 0 ? "\"" : ", \"");
+		out.append(MetricCounterName(static_cast<MetricCounter>(index)));
+		out.append("\": " + std::to_string(counters_[index].load()));
+	}
+	out.append("}}\n");
+	return out;
+}
+
+void MetricsRegistry::WriteFile(const std::string& file_name,
+	                            MetricsFormat format) const {
+	std::string contents = Format(format);
+	std::ofstream output(file_name, std::ios::out | std::ios::binary);
+	if (!output.is_open()) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	output.write(contents.data(), contents.size());
+}
+
+//times are printed in the unit a person reads fastest, microseconds
+void MetricsRegistry::PrintTable(std::ostream& output) const {
+	if (!enabled()) {
+		output << "Timing wasn't compiled into this build. Rebuild with "
+			<< "CORNER_GROCER_ENABLE_METRICS\ndefined (a Debug build, or make "
+			<< "METRICS=1) to record it." << std::endl;
+		return;
+	}
+	output << std::left << std::setw(16) << "Stage" << std::right
+		<< std::setw(10) << "Calls" << std::setw(12) << "Total ms"
+		<< std::setw(10) << "Mean us" << std::setw(10) << "p50 us"
+		<< std::setw(10) << "p99 us" << std::setw(10) << "Max us" << "\n";
+	output << std::fixed << std::setprecision(1);
+	for (int index = 0; index < kStageCount; ++index) {
+		const LatencyHistogram& histogram = stages_[index];
+		if (histogram.count() == 0) { continue; } //never called, no row
+		output << std::left << std::setw(16)
+			<< MetricStageName(static_cast<MetricStage>(index)) << std::right
+			<< std::setw(10) << histogram.count()
+			<< std::setw(12) << histogram.total_nanoseconds() / 1e6
+			<< std::setw(10)
+			<< histogram.total_nanoseconds() / 1e3 / histogram.count()
+			<< std::setw(10) << histogram.Quantile(0.5) / 1e3
+			<< std::setw(10) << histogram.Quantile(0.99) / 1e3
+			<< std::setw(10) << histogram.max_nanoseconds() / 1e3 << "\n";
+	}
+	output << std::defaultfloat;
+	for (int index = 0; index < kCounterCount; ++index) {
+		output << std::left << std::setw(16)
+			<< MetricCounterName(static_cast<MetricCounter>(index))
+			<< std::right << std::setw(10) << counters_[index].load() << "\n";
+	}
+	output << std::flush;
+}
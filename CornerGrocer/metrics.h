@@ -0,0 +1,194 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Metrics header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef METRICS_H
+#define METRICS_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/* This file times the stages of the program where the time usually goes:
+* starting Python, calls into Python, reading and writing files, writing to
+* the terminal, counting and lookups. Each stage has a latency histogram
+* (calls, total time, slowest call, and how many calls fell into each
+* power of two of nanoseconds), and a few counters add up bytes and items.
+* Everything is a relaxed atomic add, so threads can record at once, and
+* a timed call costs two reads of the monotonic clock on top of that.
+*
+* Call sites only use the two macros below, which are empty unless the
+* program is built with CORNER_GROCER_ENABLE_METRICS defined (the Debug
+* configurations, or make METRICS=1), so a build without it has no trace of
+* the instrumentation at all. The registry and its reports are always
+* there, reading all zeros when nothing is recorded, so "stats" still
+* works and says metrics are off. */
+
+//the stages that are timed, each with its own histogram
+enum class MetricStage {
+	kPythonInit, //Py_Initialize and importing ProduceManager
+	kPythonCall, //one call into ProduceManager
+	kFileRead, //reading a frequency file back in
+	kFileWrite, //writing a frequency file
+	kTerminalOutput, //writing a table or chart to the terminal
+	kIngest, //counting a sales log, or what was added to it
+	kDecompress, //decompressing a compressed sales log, on its own thread
+	kSpill, //writing counts out to run files, under a memory budget
+	kLookup, //looking up an item's count
+	kCount //number of stages, not a stage
+};
+
+//the totals that are counted
+enum class MetricCounter {
+	kBytesRead, //bytes of sales logs and frequency files read
+	kBytesWritten, //bytes of frequency files written
+	kTerminalBytes, //bytes of tables and charts written to the terminal
+	kItemsLookedUp, //item names looked up
+	kCount //number of counters, not a counter
+};
+
+//how a report is written
+enum class MetricsFormat { kPrometheus, kJson };
+
+/*Call latencies bucketed by powers of two: bucket 0 holds calls under
+* 2^10 ns (about a microsecond), bucket i calls from 2^(9 + i) ns up to
+* 2^(10 + i), and the last bucket everything longer. */
+class LatencyHistogram {
+public:
+	static const int kBucketCount = 32;
+
+	//adds one call that took nanoseconds
+	void Record(uint64_t nanoseconds);
+
+	uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+	uint64_t total_nanoseconds() const {
+		return total_.load(std::memory_order_relaxed);
+	}
+	uint64_t max_nanoseconds() const {
+		return max_.load(std::memory_order_relaxed);
+	}
+	uint64_t bucket(int index) const {
+		return buckets_[index].load(std::memory_order_relaxed);
+	}
+
+	//upper bound in nanoseconds of bucket index, 0 for the last (no bound)
+	static uint64_t BucketLimit(int index);
+
+	/*upper bound of the bucket holding the quantile'th call (0.5 for the
+	* median), so the true value is at most this and over half of it. 0 if
+	* nothing was recorded.*/
+	uint64_t Quantile(double quantile) const;
+
+	//forgets every call recorded
+	void Reset();
+
+private:
+	std::atomic<uint64_t> count_{0}; //calls recorded
+	std::atomic<uint64_t> total_{0}; //their nanoseconds added up
+	std::atomic<uint64_t> max_{0}; //the slowest
+	std::atomic<uint64_t> buckets_[kBucketCount] = {}; //calls per bucket
+};
+
+//every stage's histogram and every counter, for the whole process
+class MetricsRegistry {
+public:
+	//the one registry the macros record into
+	static MetricsRegistry& Global();
+
+	LatencyHistogram& stage(MetricStage stage) {
+		return stages_[static_cast<int>(stage)];
+	}
+	const LatencyHistogram& stage(MetricStage stage) const {
+		return stages_[static_cast<int>(stage)];
+	}
+
+	void Add(MetricCounter counter, uint64_t amount) {
+		counters_[static_cast<int>(counter)].fetch_add(
+			amount, std::memory_order_relaxed);
+	}
+	uint64_t counter(MetricCounter counter) const {
+		return counters_[static_cast<int>(counter)].load(
+			std::memory_order_relaxed);
+	}
+
+	/*true if the program was built with CORNER_GROCER_ENABLE_METRICS, so
+	* anything is recorded at all*/
+	static bool enabled();
+
+	//forgets everything recorded
+	void Reset();
+
+	/*formats every stage and counter as Prometheus text exposition (each
+	* stage a histogram in seconds, each counter a counter) or as one JSON
+	* object*/
+	std::string Format(MetricsFormat format) const;
+
+	/*writes Format(format) to file_name. Throws std::runtime_error if the
+	* file can't be created.*/
+	void WriteFile(const std::string& file_name, MetricsFormat format) const;
+
+	/*prints a table of every stage that was called: calls, total, mean,
+	* median, 99th percentile and slowest, then the counters*/
+	void PrintTable(std::ostream& output) const;
+
+private:
+	LatencyHistogram stages_[static_cast<int>(MetricStage::kCount)];
+	std::atomic<uint64_t> counters_[static_cast<int>(MetricCounter::kCount)] =
+		{};
+};
+
+//name of each stage and counter, as used in reports
+const char* MetricStageName(MetricStage stage);
+const char* MetricCounterName(MetricCounter counter);
+
+/*Times from construction to destruction on the monotonic clock and
+* records it into a stage's histogram. Used through
+* CORNER_GROCER_TIME_STAGE rather than directly. */
+class ScopedMetricTimer {
+public:
+	explicit ScopedMetricTimer(MetricStage stage)
+		: histogram_(MetricsRegistry::Global().stage(stage)),
+		  start_(std::chrono::steady_clock::now()) {}
+	~ScopedMetricTimer() {
+		histogram_.Record(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start_).count()));
+	}
+	ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+	ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+private:
+	LatencyHistogram& histogram_; //where the time goes
+	std::chrono::steady_clock::time_point start_; //when timing started
+};
+
+/*CORNER_GROCER_TIME_STAGE(kStage) times the rest of the enclosing block as
+* one call of MetricStage::kStage. CORNER_GROCER_COUNT(kCounter, amount)
+* adds amount to MetricCounter::kCounter. Both are empty statements, with
+* their arguments never evaluated, without CORNER_GROCER_ENABLE_METRICS. */
+#ifdef CORNER_GROCER_ENABLE_METRICS
+#define CORNER_GROCER_METRIC_NAME2(name, line) name##line
+#define CORNER_GROCER_METRIC_NAME(name, line) \
+	CORNER_GROCER_METRIC_NAME2(name, line)
+#define CORNER_GROCER_TIME_STAGE(stage) \
+	ScopedMetricTimer CORNER_GROCER_METRIC_NAME(metric_timer_, __LINE__)( \
+		MetricStage::stage)
+#define CORNER_GROCER_COUNT(counter, amount) \
+	MetricsRegistry::Global().Add(MetricCounter::counter, (amount))
+#else
+#define CORNER_GROCER_TIME_STAGE(stage) ((void)0)
+#define CORNER_GROCER_COUNT(counter, amount) ((void)0)
+#endif
+#endif
@@ -0,0 +1,116 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Multi File Ingest definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "multi_file_ingest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+/*a directory is listed without following it into subdirectories. Errors
+* listing it just mean nothing is added from it; a path that isn't a
+* directory is added as a file and left for Run to report.*/
+void MultiFileIngest::AddInput(const std::string& path) {
+	std::error_code error; //checked instead of letting filesystem throw
+	if (!std::filesystem::is_directory(path, error)) {
+		partitions_.emplace_back();
+		partitions_.back().file_name = path;
+		return;
+	}
+	std::vector<std::string> file_names; //found in the directory
+	for (std::filesystem::directory_iterator entry(path, error), end;
+		 !error && entry != end; entry.increment(error)) {
+		std::string name = entry->path().filename().string();
+		if (name.empty() || name[0] == '.') { continue; } //hidden
+		if (entry->is_regular_file(error)) {
+			file_names.push_back(entry->path().string());
+		}
+	}
+	std::sort(file_names.begin(), file_names.end());
+	for (std::string& file_name : file_names) {
+		partitions_.emplace_back();
+		partitions_.back().file_name = std::move(file_name);
+	}
+}
+
+//0 asks for one thread per hardware thread, like FrequencyEngine
+void MultiFileIngest::set_thread_count(unsigned thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::thread::hardware_concurrency();
+	}
+	thread_count_ = thread_count > 0 ? thread_count : 1;
+}
+
+/*workers take the next partition from a shared atomic index until none are
+* left. Each partition is only ever touched by the worker that took it, so
+* nothing else needs locking. Errors are caught per partition rather than
+* letting one worker's exception end the program, then the first one in
+* input order is rethrown once everything has been joined.*/
+void MultiFileIngest::Run(FrequencyEngine& total) {
+	std::size_t worker_count = std::min<std::size_t>(thread_count_,
+		                                             partitions_.size());
+	unsigned threads_per_file = worker_count == 0 ? 1 :
+		static_cast<unsigned>(thread_count_ / worker_count);
+	std::atomic<std::size_t> next_partition(0);
+	std::vector<std::string> errors(partitions_.size()); //empty for success
+
+	auto count_partitions = [&]() {
+		for (std::size_t index = next_partition++;
+			 index < partitions_.size(); index = next_partition++) {
+			IngestPartition& partition = partitions_[index];
+			auto start = std::chrono::steady_clock::now();
+			try {
+				if (total.time_windows() != nullptr) { //same buckets as total
+					partition.counts.EnableTimeWindows(
+						total.time_windows()->options());
+				}
+				partition.counts.Clear();
+				partition.counts.set_thread_count(threads_per_file);
+				partition.counts.CountFile(partition.file_name);
+			}
+			catch (std::runtime_error& error) { //missing or unreadable
+				errors[index] = error.what();
+			}
+			std::chrono::duration<double> elapsed =
+				std::chrono::steady_clock::now() - start;
+			partition.seconds = elapsed.count();
+		}
+	};
+
+	//this thread is one of the workers, so one thread means no threads
+	std::vector<std::thread> workers;
+	for (std::size_t worker = 1; worker < worker_count; ++worker) {
+		workers.emplace_back(count_partitions);
+	}
+	count_partitions();
+	for (std::thread& worker : workers) { worker.join(); }
+
+	for (const std::string& error : errors) {
+		if (!error.empty()) { throw std::runtime_error(error); }
+	}
+	for (const IngestPartition& partition : partitions_) {
+		total.Merge(partition.counts);
+	}
+}
+
+const IngestPartition* MultiFileIngest::FindPartition(
+	std::string_view file_name) const {
+	for (const IngestPartition& partition : partitions_) {
+		if (partition.file_name == file_name) { return &partition; }
+	}
+	return nullptr;
+}
@@ -0,0 +1,77 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Multi File Ingest header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef MULTI_FILE_INGEST_H
+#define MULTI_FILE_INGEST_H
+#include "frequency_engine.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* This file counts many sales logs in one run, such as every store's log
+* for a night, or a directory of daily logs. Each file is a partition: it is
+* counted into its own FrequencyEngine, so its counts can be looked up (or
+* exported) on their own, and the partitions are then merged into one total.
+*
+* Files are counted concurrently, up to one per thread, with each thread
+* taking the next file not yet started, so a few big files don't hold up
+* many small ones. Partitions are always merged in input order once every
+* file is done, never in the order they happened to finish, so the total
+* (and its first seen order) is the same as counting the files one after
+* another, however many threads there are. */
+
+//one input file, counted on its own
+struct IngestPartition {
+	std::string file_name; //the file, as given or as found in a directory
+	FrequencyEngine counts; //this file's counts alone
+	double seconds = 0; //time spent counting it
+};
+
+class MultiFileIngest {
+public:
+	/*adds path as a partition, or if path is a directory, every file
+	* directly inside it (not in subdirectories, and not hidden), sorted by
+	* name so a directory always gives the same order. Files that don't
+	* exist are added anyway, and reported by Run. */
+	void AddInput(const std::string& path);
+
+	/*sets how many threads Run may use. 0 means one per hardware thread, 1
+	* (the default) counts one file at a time. Files are shared out first;
+	* with fewer files than threads, the spare threads split each file into
+	* chunks the way FrequencyEngine does.*/
+	void set_thread_count(unsigned thread_count);
+	unsigned thread_count() const { return thread_count_; }
+
+	/*counts every partition, then merges them into total in input order.
+	* If total keeps time buckets, so does every partition, with the same
+	* options. If any file couldn't be read, every thread still finishes,
+	* total is left alone, and std::runtime_error is thrown for the first
+	* such file in input order. Counts from an earlier Run are replaced. */
+	void Run(FrequencyEngine& total);
+
+	//partitions in input order, available once Run has counted them
+	std::size_t size() const { return partitions_.size(); }
+	const IngestPartition& partition(std::size_t index) const {
+		return partitions_[index];
+	}
+
+	//the partition counted from file_name, or nullptr if there isn't one
+	const IngestPartition* FindPartition(std::string_view file_name) const;
+
+private:
+	std::vector<IngestPartition> partitions_; //one per file, input order
+	unsigned thread_count_ = 1; //threads Run is allowed to use
+};
+#endif
@@ -13,6 +13,8 @@
  * all naming conventions have been followed to the best of my ability
 */
 #include "python_functions.h"
+#include "line_scanner.h"
+#include "metrics.h"
 
 /* This file represents the functions that are used to interface with the 
 * ProduceManager.py file. As such, certain values are hard coded and the call 
@@ -28,6 +30,7 @@
 * Python environment. No provision is made for manual setup or modification 
 * short of changing hardcoded values.*/
 void InitPython() {
+	CORNER_GROCER_TIME_STAGE(kPythonInit); //the whole start up, import too
 	
 	/*initialize Python interpreter. This is done once to ensure persistence of
 	* ProduceManager instance. Calling Py_Initialize multiple times has also 
@@ -62,6 +65,7 @@ void InitPython() {
 * instance for every method.*/
 PyObject* CallClassConstructor(const char &input_file_name, 
 	                           const char &output_file_name) {
+	CORNER_GROCER_TIME_STAGE(kPythonCall); //every call below, as one
 	
 	/*AddModule only returns a reference to the module, and counterintuitively,
 	* does not reload it. It is also a borrowed reference, and so does not need
@@ -110,6 +114,7 @@ PyObject* CallClassConstructor(const char &input_file_name,
 * similar to "this" in C++, but Python handles that.) It returns one integer.*/
 template<> 
 	int CallObjectMethod<int>(PyObject* object, const char &method_name){
+	CORNER_GROCER_TIME_STAGE(kPythonCall); //the call and the conversion
 	
 	/* Calls the method method_name of our ProduceManager instance. NULL 
 	* terminates the variadic template used to call methods (can take an 
@@ -133,6 +138,7 @@ template<>
 * similar to "this" in C++, but Python handles that.) It returns nothing. */
 template<> 
 	void CallObjectMethod<void>(PyObject* object, const char &method_name) {
+	CORNER_GROCER_TIME_STAGE(kPythonCall); //including what Python prints
 
 	/* Calls the method method_name of our ProduceManager instance. NULL 
 	* terminates the variadic template used to call methods (can take an 
@@ -150,6 +156,7 @@ template<>
 template <> void CallObjectMethod<void>(PyObject* object, 
 	                                    const char &method_name, 
 	                                    const char &argument) {
+	CORNER_GROCER_TIME_STAGE(kPythonCall);
 
 	/* Call the method method_name of our ProduceManager instance. NULL terminates
 	* the variadic template, in this case, after one argument is supplied. Method 
@@ -166,6 +173,7 @@ template <> void CallObjectMethod<void>(PyObject* object,
 template <> 
 int CallObjectMethod<int>(PyObject* object, const char &method_name, 
                           const char &argument) {	
+	CORNER_GROCER_TIME_STAGE(kPythonCall);
 
 	/* Call the method method_name of our ProduceManager instance. NULL 
 	* terminates the variadic template, in this case, after one argument is 
@@ -187,6 +195,63 @@ int CallObjectMethod<int>(PyObject* object, const char &method_name,
 	return return_val; //return return_val
 }
 
+/*This function calls method_name, which returns (names, counts), and reads
+* both straight out of their buffers. "y*" asks PyArg_ParseTuple for a
+* Py_buffer over any bytes-like object, which covers bytes and array alike,
+* and keeps each object locked (unresizable) until PyBuffer_Release.*/
+bool FetchFrequencyTable(PyObject* object, const char &method_name, 
+	                     FrequencyTable& table) {
+	CORNER_GROCER_TIME_STAGE(kPythonCall); //the call and the copy
+	PyObject* result = PyObject_CallMethod(object, &method_name, NULL);
+	PyErr_Print(); //print errors, if any
+	if (result == NULL) { return false; } //method failed, nothing to read
+
+	Py_buffer names; //"\n" separated item names
+	Py_buffer counts; //int64 counts, one per name
+	if (!PyArg_ParseTuple(result, "y*y*", &names, &counts)) {
+		PyErr_Print(); //print errors, if any
+		Py_XDECREF(result);
+		return false;
+	}
+
+	//one int64 per name, so the count buffer has to be a whole number of them
+	bool valid = counts.len % sizeof(int64_t) == 0;
+	if (valid) {
+		//the GIL isn't needed to read buffers Python can't change under us
+		ScopedGilRelease gil_released;
+		table.Clear();
+		const int64_t* qtys = static_cast<const int64_t*>(counts.buf);
+		std::size_t qty_count = counts.len / sizeof(int64_t);
+		std::size_t row = 0; //index of the next count to use
+		LineScanner lines(static_cast<const char*>(names.buf), names.len);
+		for (std::string_view name; valid && lines.Next(name); ++row) {
+			valid = row < qty_count; //more names than counts is an error
+			if (valid) { table.Add(name, qtys[row]); }
+		}
+		valid = valid && row == qty_count; //and so is more counts than names
+	}
+
+	/*Cleanup. The buffers have to be released with the GIL held, which it
+	* is again now that gil_released has left scope*/
+	PyBuffer_Release(&names);
+	PyBuffer_Release(&counts);
+	Py_XDECREF(result);
+	if (!valid) {
+		PySys_WriteStderr("Frequency table from Python was malformed\n");
+		table.Clear();
+	}
+	return valid;
+}
+
+/*Py_True and Py_False are shared objects, so setting one only adds a
+* reference to it, which the attribute keeps*/
+void SetObjectFlag(PyObject* object, const char &attribute_name, bool value) {
+	if (PyObject_SetAttrString(object, &attribute_name,
+		                       value ? Py_True : Py_False) != 0) {
+		PyErr_Print(); //print errors, if any
+	}
+}
+
 /* This function explicitly flags Python's garbage collector to delete the 
 * instance of ProduceManager, thus (ideally freeing all memory) */
 void FinalizePython(PyObject* object) {
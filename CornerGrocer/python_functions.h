@@ -15,6 +15,7 @@
 #ifndef PYTHON_FUNCTIONS_H
 #define PYTHON_FUNCTIONS_H
 #include <Python.h>
+#include "frequency_engine.h"
 
 /* This file represents the functions that are used to interface with the 
 * PythonCode.py file. As such, certain values are hard coded and the call 
@@ -51,6 +52,51 @@ template<typename returnType>
 	returnType CallObjectMethod(PyObject* object, const char &method_name, 
 		                        const char &argument);
 
+/*This function calls a ProduceManager method that returns its whole 
+* frequency table at once, as a tuple of two bytes-like objects: every item
+* name joined by "\n" into one bytes object, and an array('q') of counts in
+* the same order. Both are read in place through the buffer protocol, so no
+* PyObject is created or converted per item on this side. table is emptied 
+* and refilled, with the GIL released while the names are interned. Returns 
+* false (after printing the error) if the method fails or returns something
+* else.*/
+bool FetchFrequencyTable(PyObject* object, const char &method_name, 
+	                     FrequencyTable& table);
+
+/*While one of these exists, this thread doesn't hold the GIL, so other 
+* Python threads can run during long native work. Nothing Python may be 
+* touched until it leaves scope and the GIL is taken back. */
+class ScopedGilRelease {
+public:
+	ScopedGilRelease() : thread_state_(PyEval_SaveThread()) {}
+	~ScopedGilRelease() { PyEval_RestoreThread(thread_state_); }
+	ScopedGilRelease(const ScopedGilRelease&) = delete;
+	ScopedGilRelease& operator=(const ScopedGilRelease&) = delete;
+
+private:
+	PyThreadState* thread_state_; //saved by SaveThread, handed back at end
+};
+
+/*The other way round: while one of these exists, this thread holds the GIL,
+* waiting for it first if another thread has it. A thread Python didn't
+* start, such as a BackgroundTask's, needs one around every Python call. */
+class ScopedGil {
+public:
+	ScopedGil() : state_(PyGILState_Ensure()) {}
+	~ScopedGil() { PyGILState_Release(state_); }
+	ScopedGil(const ScopedGil&) = delete;
+	ScopedGil& operator=(const ScopedGil&) = delete;
+
+private:
+	PyGILState_STATE state_; //whether the GIL was already held, for Release
+};
+
+/*This function sets the attribute attribute_name of object to Python's True
+* or False. The GIL has to be held, which is what makes it safe to use for a 
+* flag a method running on another thread checks as it goes: that thread
+* sees it at its next check. Errors, if any, are printed.*/
+void SetObjectFlag(PyObject* object, const char &attribute_name, bool value);
+
 /* This function explicitly flags Python's garbage collector to delete the 
 * instance of ProduceManager, thus (ideally freeing all memory) */
 void FinalizePython(PyObject* object);
@@ -0,0 +1,455 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Query Server definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "query_server.h"
+#include "batch_mode.h"
+#include "histogram.h"
+#include "line_scanner.h"
+#include "ranking.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+namespace {
+//chart width when a histogram query doesn't give one
+const std::size_t kServedChartWidth = 80;
+
+//widest chart served, wider ones are drawn this wide
+const std::size_t kMaxServedChartWidth = 1000;
+
+/*largest answer one query may build. Anything estimated to be bigger is
+* refused with an error before it is built, so no client can make the
+* server allocate more than this for one line.*/
+const std::size_t kMaxAnswerBytes = 1024 * 1024;
+
+/*bytes one item's record or chart row takes on top of its name, at most,
+* for estimating answers before building them*/
+const std::size_t kRecordBytes = 96;
+
+/*true, after writing an error, if rows records or chart rows of
+* row_bytes each (plus the name) would make an answer over kMaxAnswerBytes.
+* Names are counted twice over, for any JSON escaping.*/
+bool AnswerTooLarge(const FrequencyTable& items, uint64_t rows,
+	                uint64_t row_bytes, RecordWriter& records) {
+	uint64_t per_row = row_bytes + 2 * items.longest_name();
+	if (rows <= kMaxAnswerBytes / per_row) { return false; }
+	records.WriteError("Answer would be over 1 MB, ask for fewer items");
+	return true;
+}
+
+/*answers a top, bottom or above query. Returns false if argument isn't a
+* number that makes sense for the ranking.*/
+bool AnswerRanking(const FrequencyTable& items, RankKind kind,
+	               std::string_view argument, RecordWriter& records) {
+	RankQuery query;
+	query.kind = kind;
+	if (!ParseInteger(argument, query.value) ||
+		(kind != RankKind::kAbove &&
+		 (query.value < 1 || query.value > UINT32_MAX))) {
+		return false;
+	}
+	std::vector<uint32_t> ids;
+	RunRankQuery(items, query, ids);
+	if (AnswerTooLarge(items, ids.size(), kRecordBytes, records)) {
+		return true; //made sense, but was refused
+	}
+	for (std::size_t rank = 0; rank < ids.size(); ++rank) {
+		records.WriteRank(query, rank + 1, items.Name(ids[rank]),
+			              items.Count(ids[rank]));
+	}
+	return true;
+}
+
+/*answers a histogram query, whose argument is an optional width then an
+* optional number of best sellers. Returns false if either isn't a number.
+* The chart's size is known from the width and rows before it is drawn, so
+* one too big to send is refused without drawing it.*/
+bool AnswerHistogram(const FrequencyTable& items, std::string_view argument,
+	                 RecordWriter& records) {
+	HistogramOptions options;
+	options.width = kServedChartWidth;
+	std::string_view width = argument.substr(0, argument.find(' '));
+	std::string_view top = width.size() < argument.size() ?
+		TrimWhitespace(argument.substr(width.size())) : std::string_view();
+	int64_t number = 0;
+	if (!width.empty()) {
+		if (!ParseInteger(width, number) || number < 1 ||
+			number > UINT32_MAX) {
+			return false;
+		}
+		options.width = static_cast<std::size_t>(
+			std::min<int64_t>(number, kMaxServedChartWidth));
+	}
+	if (!top.empty()) {
+		if (!ParseInteger(top, number) || number < 1 || number > UINT32_MAX) {
+			return false;
+		}
+		options.top = static_cast<uint32_t>(number);
+	}
+	uint64_t rows = items.size();
+	if (options.top != 0 && options.top < rows) { rows = options.top; }
+	if (AnswerTooLarge(items, rows + 3, options.width + kRecordBytes,
+		               records)) {
+		return true; //made sense, but was refused
+	}
+	HistogramRenderer renderer(options);
+	const std::string& chart = renderer.Render(items);
+	records.WriteHistogram(renderer.row_count(), chart);
+	return true;
+}
+
+#ifdef __linux__
+//most events taken from one epoll_wait
+const int kEventBatch = 64;
+
+//most bytes taken from one connection per event, so no client hogs the loop
+const std::size_t kReadBytes = 64 * 1024;
+
+//longest query line accepted, a connection sending longer is closed
+const std::size_t kMaxQueryBytes = 64 * 1024;
+
+/*answers waiting to be sent past which no more queries are answered (or
+* read) until the client reads some, so one that never reads can't use up
+* memory. One answer is never more than kMaxAnswerBytes on top of it.*/
+const std::size_t kMaxPendingBytes = 1024 * 1024;
+
+//one client's unanswered queries and unsent answers
+struct Connection {
+	std::string input; //bytes received, starting at an unanswered line
+	std::string output; //answers not yet sent
+	bool closing = false; //the client is done sending
+	bool writing = false; //waiting for EPOLLOUT rather than EPOLLIN
+};
+
+/*true if path is a socket some server is still accepting connections on.
+* A socket file nobody is listening on is left over from one that is
+* gone, so it is safe to replace.*/
+bool SocketInUse(const std::string& path) {
+	struct stat status;
+	if (stat(path.c_str(), &status) != 0 || !S_ISSOCK(status.st_mode)) {
+		return false;
+	}
+	int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (probe == -1) { return false; }
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	bool in_use = connect(probe, reinterpret_cast<sockaddr*>(&address),
+		                  sizeof(address)) == 0;
+	close(probe);
+	return in_use;
+}
+#endif
+}  // namespace
+
+/*the copy is made before the swap, so a reader loading the pointer either
+* gets the old snapshot or the finished new one*/
+void SnapshotPublisher::Publish(const FrequencyTable& items) {
+	std::shared_ptr<CountSnapshot> snapshot(new CountSnapshot());
+	snapshot->version = ++version_;
+	snapshot->items = items;
+	snapshot->total_units = items.TotalUnits();
+	std::atomic_store(&current_,
+		              std::shared_ptr<const CountSnapshot>(snapshot));
+}
+
+/*the first word of the line says what is asked, the rest (trimmed) is its
+* argument*/
+void AnswerQuery(const CountSnapshot* snapshot, std::string_view query,
+	             std::string& output) {
+	std::string_view line = TrimWhitespace(query);
+	if (line.empty()) { return; }
+	std::string_view command = line.substr(0, line.find(' '));
+	std::string_view argument = TrimWhitespace(line.substr(command.size()));
+
+	RecordWriter records(OutputStyle::kJsonLines);
+	bool answered = true; //false if the query didn't make sense
+	if (snapshot == nullptr) {
+		records.WriteError("No counts have been published yet");
+	}
+	else if (command == "item" && !argument.empty()) {
+		uint32_t id = snapshot->items.Find(argument);
+		records.WriteItem(argument, id != ItemDictionary::kNotFound ?
+			              snapshot->items.Count(id) : -1);
+	}
+	else if (command == "items") {
+		for (std::size_t start = 0; start <= argument.size();) {
+			std::size_t end = argument.find('|', start);
+			if (end == std::string_view::npos) { end = argument.size(); }
+			std::string_view name =
+				TrimWhitespace(argument.substr(start, end - start));
+			if (!name.empty()) {
+				uint32_t id = snapshot->items.Find(name);
+				records.WriteItem(name, id != ItemDictionary::kNotFound ?
+					              snapshot->items.Count(id) : -1);
+			}
+			start = end + 1;
+		}
+	}
+	else if (command == "top" || command == "bottom" || command == "above") {
+		answered = AnswerRanking(snapshot->items,
+			command == "top" ? RankKind::kTop :
+			command == "bottom" ? RankKind::kBottom : RankKind::kAbove,
+			argument, records);
+	}
+	else if (command == "histogram") {
+		answered = AnswerHistogram(snapshot->items, argument, records);
+	}
+	else if (command != "stats" || !argument.empty()) { answered = false; }
+
+	if (!answered) {
+		records.WriteError("Unknown query: " + std::string(line));
+	}
+	if (snapshot == nullptr) { records.WriteServed(0, 0, 0); }
+	else {
+		records.WriteServed(snapshot->version, snapshot->items.size(),
+			                snapshot->total_units);
+	}
+	records.MoveTo(output);
+}
+
+QueryServer::QueryServer(const SnapshotPublisher& snapshots)
+	: snapshots_(snapshots) {}
+
+#ifdef __linux__
+/*everything is set up before the thread starts, so a bad address throws
+* here instead of going unnoticed on the server's thread*/
+void QueryServer::Start(const std::string& address) {
+	if (thread_.joinable()) {
+		throw std::runtime_error("Query server is already running");
+	}
+	std::size_t colon = address.rfind(':');
+	std::string host = address.substr(0, colon);
+	bool tcp = colon != std::string::npos &&
+		(host == "localhost" || host == "127.0.0.1");
+	bool bound = false;
+	if (tcp) {
+		int64_t port = 0;
+		if (!ParseInteger(std::string_view(address).substr(colon + 1),
+			              port) || port < 1 || port > 65535) {
+			throw std::runtime_error("Bad port to serve on: " + address);
+		}
+		listen_descriptor_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK |
+			                        SOCK_CLOEXEC, 0);
+		int reuse = 1; //restart at once, without waiting out TIME_WAIT
+		setsockopt(listen_descriptor_, SOL_SOCKET, SO_REUSEADDR, &reuse,
+			       sizeof(reuse));
+		sockaddr_in loopback = {};
+		loopback.sin_family = AF_INET;
+		loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		loopback.sin_port = htons(static_cast<uint16_t>(port));
+		bound = listen_descriptor_ != -1 &&
+			bind(listen_descriptor_, reinterpret_cast<sockaddr*>(&loopback),
+				 sizeof(loopback)) == 0;
+	}
+	else {
+		sockaddr_un path = {};
+		if (address.empty() || address.size() >= sizeof(path.sun_path)) {
+			throw std::runtime_error("Bad socket path to serve on: " +
+				                     address);
+		}
+		if (SocketInUse(address)) {
+			throw std::runtime_error("Another server is using: " + address);
+		}
+		unlink(address.c_str()); //only a left over socket gets this far
+		path.sun_family = AF_UNIX;
+		std::memcpy(path.sun_path, address.c_str(), address.size() + 1);
+		listen_descriptor_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK |
+			                        SOCK_CLOEXEC, 0);
+		bound = listen_descriptor_ != -1 &&
+			bind(listen_descriptor_, reinterpret_cast<sockaddr*>(&path),
+				 sizeof(path)) == 0;
+		if (bound) { socket_path_ = address; }
+	}
+
+	epoll_descriptor_ = epoll_create1(EPOLL_CLOEXEC);
+	stop_descriptor_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_event listening = {};
+	listening.events = EPOLLIN;
+	listening.data.fd = listen_descriptor_;
+	epoll_event stopping = {};
+	stopping.events = EPOLLIN;
+	stopping.data.fd = stop_descriptor_;
+	if (!bound || listen(listen_descriptor_, SOMAXCONN) != 0 ||
+		epoll_descriptor_ == -1 || stop_descriptor_ == -1 ||
+		epoll_ctl(epoll_descriptor_, EPOLL_CTL_ADD, listen_descriptor_,
+			      &listening) != 0 ||
+		epoll_ctl(epoll_descriptor_, EPOLL_CTL_ADD, stop_descriptor_,
+			      &stopping) != 0) {
+		CloseDescriptors();
+		throw std::runtime_error("Error serving on: " + address);
+	}
+	thread_ = std::thread(&QueryServer::Run, this);
+}
+
+void QueryServer::Stop() {
+	if (thread_.joinable()) {
+		uint64_t wake = 1;
+		ssize_t written = write(stop_descriptor_, &wake, sizeof(wake));
+		(void)written; //can't fail short of a bad descriptor
+		thread_.join();
+	}
+	CloseDescriptors();
+}
+
+void QueryServer::CloseDescriptors() {
+	for (int* descriptor : {&listen_descriptor_, &epoll_descriptor_,
+		                    &stop_descriptor_}) {
+		if (*descriptor != -1) { close(*descriptor); }
+		*descriptor = -1;
+	}
+	if (!socket_path_.empty()) {
+		unlink(socket_path_.c_str());
+		socket_path_.clear();
+	}
+}
+
+/*level triggered, so a connection with more to read or send just comes up
+* again on the next epoll_wait. Each turn for a connection reads once,
+* answers every whole line it can, sends what it can, then watches for
+* whichever of reading or sending it is waiting on.*/
+void QueryServer::Run() {
+	std::unordered_map<int, Connection> connections; //by descriptor
+	std::vector<char> block(kReadBytes); //one read's bytes
+	epoll_event events[kEventBatch];
+	while (true) {
+		int ready = epoll_wait(epoll_descriptor_, events, kEventBatch, -1);
+		if (ready < 0 && errno != EINTR) { break; }
+		for (int i = 0; i < ready; ++i) {
+			int descriptor = events[i].data.fd;
+			if (descriptor == stop_descriptor_) {
+				for (auto& connection : connections) {
+					close(connection.first);
+				}
+				return;
+			}
+			if (descriptor == listen_descriptor_) {
+				int client;
+				while ((client = accept4(listen_descriptor_, nullptr,
+					                     nullptr, SOCK_NONBLOCK |
+					                     SOCK_CLOEXEC)) != -1) {
+					epoll_event reading = {};
+					reading.events = EPOLLIN;
+					reading.data.fd = client;
+					if (epoll_ctl(epoll_descriptor_, EPOLL_CTL_ADD, client,
+						          &reading) != 0) {
+						close(client);
+						continue;
+					}
+					connections[client] = Connection();
+				}
+				continue;
+			}
+			auto found = connections.find(descriptor);
+			if (found == connections.end()) { continue; }
+			Connection& connection = found->second;
+			bool open = true; //false once the connection is to be closed
+
+			//read once, unless the client's answers have backed up
+			if (!connection.writing && !connection.closing) {
+				ssize_t got = read(descriptor, block.data(), block.size());
+				if (got > 0) { connection.input.append(block.data(), got); }
+				else if (got == 0) { //no more queries, finish the last one
+					connection.closing = true;
+					if (!connection.input.empty() &&
+						connection.input.back() != '\n') {
+						connection.input.push_back('\n');
+					}
+				}
+				else if (errno != EAGAIN && errno != EINTR) { open = false; }
+			}
+
+			//answer whole lines, each from the snapshot current right then
+			std::size_t start = 0; //first unanswered byte of input
+			for (std::size_t newline;
+				 open && connection.output.size() < kMaxPendingBytes &&
+				 (newline = connection.input.find('\n', start)) !=
+				 std::string::npos; start = newline + 1) {
+				std::shared_ptr<const CountSnapshot> snapshot =
+					snapshots_.Current();
+				try {
+					AnswerQuery(snapshot.get(), std::string_view(
+						connection.input).substr(start, newline - start),
+						connection.output);
+				}
+				catch (std::exception& error) { //out of memory, most likely
+					RecordWriter records(OutputStyle::kJsonLines);
+					records.WriteError(std::string("Query failed: ") +
+						               error.what());
+					records.WriteServed(0, 0, 0);
+					records.MoveTo(connection.output);
+				}
+				++queries_answered_;
+			}
+			connection.input.erase(0, start);
+			bool waiting = connection.input.find('\n') != std::string::npos;
+			if (!waiting && connection.input.size() >= kMaxQueryBytes) {
+				RecordWriter records(OutputStyle::kJsonLines);
+				records.WriteError("Query is too long");
+				records.MoveTo(connection.output);
+				connection.input.clear();
+				connection.closing = true;
+			}
+
+			//send what the socket will take, the rest when it has room
+			while (open && !connection.output.empty()) {
+				ssize_t sent = send(descriptor, connection.output.data(),
+					                connection.output.size(), MSG_NOSIGNAL);
+				if (sent > 0) { connection.output.erase(0, sent); }
+				else if (errno == EAGAIN) { break; }
+				else if (errno != EINTR) { open = false; }
+			}
+
+			bool writing = !connection.output.empty() || waiting;
+			if (open && connection.closing && !writing) { open = false; }
+			if (open && writing != connection.writing) {
+				epoll_event interest = {};
+				interest.events = writing ? EPOLLOUT : EPOLLIN;
+				interest.data.fd = descriptor;
+				epoll_ctl(epoll_descriptor_, EPOLL_CTL_MOD, descriptor,
+					      &interest);
+				connection.writing = writing;
+			}
+			if (!open) {
+				close(descriptor);
+				connections.erase(found);
+			}
+		}
+	}
+}
+#else
+//there is no epoll here, so there is no server either
+void QueryServer::Start(const std::string& address) {
+	throw std::runtime_error("Serving queries needs Linux: " + address);
+}
+
+void QueryServer::Stop() {}
+
+void QueryServer::CloseDescriptors() {}
+
+void QueryServer::Run() {}
+#endif
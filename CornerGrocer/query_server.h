@@ -0,0 +1,128 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Query Server header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+#include "frequency_engine.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/* This file answers queries about the counts over a socket, so dashboards
+* and handheld scanners can ask for them while a batch run keeps counting.
+*
+* Readers never see counts half way through an update. Whoever counts
+* publishes a copy of the table after each update as a CountSnapshot,
+* which is never changed again, and swaps it in as the current one with an
+* atomic store. A query takes the current snapshot with an atomic load and
+* answers entirely from it, so every answer is consistent, and counting
+* never waits for a reader: a reader still holding an older snapshot keeps
+* it alive until it lets go, and the counter has moved on already.
+*
+* The server is one thread running an epoll loop (so Linux only), with
+* every connection non-blocking. A client sends one query per line and gets
+* back JSON lines, the same records batch mode writes (see batch_mode.h),
+* always ending with an "end" record giving the snapshot's version, items
+* and units, so a client can tell where each answer stops:
+*
+*   item NAME              an "item" record, count -1 if it wasn't sold
+*   items NAME|NAME|...    an "item" record for every name, in order
+*   top N, bottom N        "rank" records for the N best or worst sellers
+*   above N                "rank" records for items that sold more than N
+*   histogram [WIDTH [N]]  a "histogram" record holding the chart, WIDTH
+*                          columns wide (default 80, at most 1000), of the
+*                          N best sellers or every item
+*   stats                  just the "end" record
+*
+* Anything else gets an "error" record (then "end"), and so does a ranking
+* or chart that would make an answer over 1 MB, or a query that fails, so
+* no client can make the server run out of memory. Queries can be sent
+* without waiting for answers; answers come back in the same order. */
+
+//the counts as they were at one moment, never changed once published
+struct CountSnapshot {
+	uint64_t version = 0; //1 for the first snapshot published, then 2, ...
+	FrequencyTable items; //every item name and count
+	int64_t total_units = 0; //sum of every count
+};
+
+/*Holds the current snapshot. One thread publishes, any number of threads
+* read, and neither ever waits on the other for longer than it takes to
+* swap a pointer. */
+class SnapshotPublisher {
+public:
+	/*copies items into a new snapshot and makes it the current one. Only
+	* one thread may publish. Copying costs about as much as a ranking
+	* query, and is done by the publisher, never by a reader.*/
+	void Publish(const FrequencyTable& items);
+
+	//the current snapshot, or nullptr if nothing was published yet
+	std::shared_ptr<const CountSnapshot> Current() const {
+		return std::atomic_load(&current_);
+	}
+
+private:
+	std::shared_ptr<const CountSnapshot> current_; //only used atomically
+	uint64_t version_ = 0; //version of the last snapshot published
+};
+
+/*Answers one query line (see above) from snapshot, appending JSON lines
+* to output. A null snapshot gets an error saying there are no counts yet.
+* Blank lines are ignored, appending nothing. */
+void AnswerQuery(const CountSnapshot* snapshot, std::string_view query,
+	             std::string& output);
+
+class QueryServer {
+public:
+	//answers from snapshots, which has to outlive the server
+	explicit QueryServer(const SnapshotPublisher& snapshots);
+	~QueryServer() { Stop(); }
+
+	//a server owns its sockets and thread, so it can't be copied
+	QueryServer(const QueryServer&) = delete;
+	QueryServer& operator=(const QueryServer&) = delete;
+
+	/*listens on address and starts answering on a thread of its own.
+	* "localhost:PORT" or "127.0.0.1:PORT" listens on the loopback TCP port,
+	* anything else is the path of a Unix domain socket, replacing one left
+	* behind by a server that is no longer running. Throws
+	* std::runtime_error if it can't listen there, or this isn't Linux. */
+	void Start(const std::string& address);
+
+	/*stops answering, closing every connection and removing the socket
+	* file. Does nothing if the server isn't running.*/
+	void Stop();
+
+	//query lines answered so far
+	uint64_t queries_answered() const { return queries_answered_.load(); }
+
+private:
+	//the epoll loop run by thread_ until Stop
+	void Run();
+
+	//closes the listening socket, epoll and stop descriptors
+	void CloseDescriptors();
+
+	const SnapshotPublisher& snapshots_; //where answers come from
+	std::string socket_path_; //Unix socket to remove on Stop, else empty
+	int listen_descriptor_ = -1; //accepts connections
+	int epoll_descriptor_ = -1; //waits on everything at once
+	int stop_descriptor_ = -1; //eventfd Stop writes to to wake the loop
+	std::thread thread_; //runs Run, joinable while the server is running
+	std::atomic<uint64_t> queries_answered_{0}; //for the "stopped" record
+};
+#endif
@@ -0,0 +1,124 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Ranking header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef RANKING_H
+#define RANKING_H
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/* This file ranks items by quantity sold without sorting the whole table.
+* Best and worst sellers are picked with a heap holding at most k IDs: each
+* item is compared against the heap's weakest entry and only replaces it if
+* it ranks higher, so ranking n items costs O(n log k) instead of the
+* O(n log n) of sorting everything and keeping the first k. Items above a
+* threshold are picked in one pass, and only those are sorted.
+* Everything works on any source of rows with size(), Name(row) and
+* Count(row), so a FrequencyTable and a FrequencyFileView rank the same. */
+
+//what a ranking picks
+enum class RankKind {
+	kNone, //nothing, every item in its usual order
+	kTop, //the value best sellers
+	kBottom, //the value worst sellers
+	kAbove //every item that sold more than value
+};
+
+//a ranking to run, as asked for on the command line or from the menu
+struct RankQuery {
+	RankKind kind = RankKind::kNone;
+	int64_t value = 0; //how many items for kTop and kBottom, else threshold
+};
+
+/*true if a ranks before b: more sold first, or less sold first for worst
+* sellers, with ties broken by name so every ranking comes out the same way*/
+template<typename RowSource>
+bool RanksBefore(const RowSource& item_counts, bool best_first, uint32_t a,
+	             uint32_t b) {
+	int64_t count_a = item_counts.Count(a);
+	int64_t count_b = item_counts.Count(b);
+	if (count_a != count_b) {
+		return best_first ? count_a > count_b : count_a < count_b;
+	}
+	return item_counts.Name(a) < item_counts.Name(b);
+}
+
+/*Fills ids with the IDs of the k best sellers (or worst, when best_first is
+* false), in rank order. ids is cleared first and can be reused between
+* calls to avoid reallocating. */
+template<typename RowSource>
+void RankItems(const RowSource& item_counts, uint32_t k, bool best_first,
+	           std::vector<uint32_t>& ids) {
+	/*with RanksBefore as the heap's "less than", the heap's front is the
+	* entry every other entry ranks before: the weakest one kept so far*/
+	auto ranks_before = [&item_counts, best_first](uint32_t a, uint32_t b) {
+		return RanksBefore(item_counts, best_first, a, b);
+	};
+	ids.clear();
+	uint32_t item_count = item_counts.size();
+	k = std::min(k, item_count);
+	if (k == 0) { return; }
+	ids.reserve(k);
+	for (uint32_t id = 0; id < item_count; ++id) {
+		if (ids.size() < k) { //still filling up, everything gets in
+			ids.push_back(id);
+			std::push_heap(ids.begin(), ids.end(), ranks_before);
+		}
+		else if (ranks_before(id, ids.front())) { //beats the weakest kept
+			std::pop_heap(ids.begin(), ids.end(), ranks_before);
+			ids.back() = id;
+			std::push_heap(ids.begin(), ids.end(), ranks_before);
+		}
+	}
+	std::sort_heap(ids.begin(), ids.end(), ranks_before); //best first
+}
+
+/*Fills ids with the IDs of every item that sold more than threshold, best
+* sellers first. ids is cleared first. */
+template<typename RowSource>
+void ItemsAbove(const RowSource& item_counts, int64_t threshold,
+	            std::vector<uint32_t>& ids) {
+	ids.clear();
+	for (uint32_t id = 0; id < item_counts.size(); ++id) {
+		if (item_counts.Count(id) > threshold) { ids.push_back(id); }
+	}
+	std::sort(ids.begin(), ids.end(),
+		      [&item_counts](uint32_t a, uint32_t b) {
+		return RanksBefore(item_counts, true, a, b);
+	});
+}
+
+/*Runs query against item_counts, filling ids with the IDs it picks in rank
+* order. kNone picks every item in ID order. */
+template<typename RowSource>
+void RunRankQuery(const RowSource& item_counts, const RankQuery& query,
+	              std::vector<uint32_t>& ids) {
+	switch (query.kind) {
+	case RankKind::kNone:
+		ids.resize(item_counts.size());
+		for (uint32_t id = 0; id < ids.size(); ++id) { ids[id] = id; }
+		break;
+	case RankKind::kTop:
+	case RankKind::kBottom:
+		RankItems(item_counts, static_cast<uint32_t>(std::min<int64_t>(
+			          std::max<int64_t>(query.value, 0), UINT32_MAX)),
+			      query.kind == RankKind::kTop, ids);
+		break;
+	case RankKind::kAbove:
+		ItemsAbove(item_counts, query.value, ids);
+		break;
+	}
+}
+#endif
@@ -0,0 +1,123 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Sales Log Generator definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "sales_log_generator.h"
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+//the items of the sample input file, most sold first
+const char* const kProduceNames[] = {
+	"Zucchini", "Cranberries", "Cucumbers", "Peas", "Garlic", "Broccoli",
+	"Celery", "Cauliflower", "Yams", "Spinach", "Potatoes", "Peaches",
+	"Onions", "Apples", "Radishes", "Beets", "Pumpkins", "Cantaloupe",
+	"Pears", "Limes"};
+const uint32_t kProduceNameCount =
+	sizeof(kProduceNames) / sizeof(kProduceNames[0]);
+
+//how much of the log WriteLog builds in memory before each write
+const std::size_t kWriteBlockBytes = 1 << 20;
+}  // namespace
+
+/*names first, then the alias table, built with Vose's method: every rank's
+* probability is scaled so the average is 1, then each column below 1 is
+* topped up from a column above 1, which becomes its alias. */
+SalesLogGenerator::SalesLogGenerator(const SalesLogOptions& options)
+	: options_(options), random_(options.seed) {
+	if (options_.item_count == 0) { options_.item_count = 1; } //need one item
+	uint32_t item_count = options_.item_count;
+
+	names_.reserve(item_count);
+	for (uint32_t rank = 0; rank < item_count; ++rank) {
+		std::string name = kProduceNames[rank % kProduceNameCount];
+		if (rank >= kProduceNameCount) {
+			name += "-" + std::to_string(rank);
+		}
+		names_.push_back(std::move(name));
+	}
+
+	//Zipf weights 1 / (rank + 1)^skew, scaled to average 1
+	std::vector<double> scaled(item_count);
+	double total = 0;
+	for (uint32_t rank = 0; rank < item_count; ++rank) {
+		scaled[rank] = 1.0 / std::pow(rank + 1.0, options_.skew);
+		total += scaled[rank];
+	}
+	for (double& weight : scaled) { weight *= item_count / total; }
+
+	//columns still needing a partner, split by which side of 1 they are
+	std::vector<uint32_t> small;
+	std::vector<uint32_t> large;
+	for (uint32_t rank = 0; rank < item_count; ++rank) {
+		(scaled[rank] < 1.0 ? small : large).push_back(rank);
+	}
+	keep_.assign(item_count, 1.0);
+	alias_.resize(item_count);
+	for (uint32_t rank = 0; rank < item_count; ++rank) { alias_[rank] = rank; }
+	while (!small.empty() && !large.empty()) {
+		uint32_t under = small.back();
+		uint32_t over = large.back();
+		small.pop_back();
+		keep_[under] = scaled[under];
+		alias_[under] = over;
+		scaled[over] -= 1.0 - scaled[under]; //what over gave to fill under
+		if (scaled[over] < 1.0) {
+			large.pop_back();
+			small.push_back(over);
+		}
+	}
+	//anything left over is 1 give or take rounding, and keeps itself
+}
+
+/*the top 32 bits of one random number pick the column (multiplying and
+* shifting instead of taking a remainder, which is slower and biased), the
+* bottom 32 bits decide between the column and its alias*/
+uint32_t SalesLogGenerator::NextItem() {
+	uint64_t bits = random_();
+	uint32_t column = static_cast<uint32_t>(
+		((bits >> 32) * options_.item_count) >> 32);
+	double coin = static_cast<double>(bits & 0xFFFFFFFF) * (1.0 / 4294967296.0);
+	return coin < keep_[column] ? column : alias_[column];
+}
+
+void SalesLogGenerator::AppendLines(uint64_t line_count, std::string& out) {
+	for (uint64_t line = 0; line < line_count; ++line) {
+		out.append(names_[NextItem()]);
+		out.push_back('\n');
+	}
+}
+
+//builds the log a block at a time, writing each block as it fills
+void SalesLogGenerator::WriteLog(const std::string& file_name) {
+	std::ofstream output(file_name, std::ios::out | std::ios::binary);
+	if (!output.is_open()) {
+		throw std::runtime_error("Error creating File: " + file_name);
+	}
+	std::string block;
+	block.reserve(kWriteBlockBytes + 64);
+	for (uint64_t line = 0; line < options_.line_count; ++line) {
+		block.append(names_[NextItem()]);
+		block.push_back('\n');
+		if (block.size() >= kWriteBlockBytes) {
+			output.write(block.data(), block.size());
+			block.clear();
+		}
+	}
+	output.write(block.data(), block.size());
+	if (!output) {
+		throw std::runtime_error("Error writing File: " + file_name);
+	}
+}
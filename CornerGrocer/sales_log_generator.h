@@ -0,0 +1,75 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Sales Log Generator header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef SALES_LOG_GENERATOR_H
+#define SALES_LOG_GENERATOR_H
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/* This file makes synthetic sales logs in the same format as
+* CS210_Project_Three_Input_File.txt (one item name per line) at any size,
+* for the benchmark. Real sales are skewed: a few items sell constantly and
+* most sell rarely, so item names are drawn from a Zipf distribution, where
+* the item of rank r (counting from 1) is picked with probability
+* proportional to 1 / r^skew. A skew of 0 makes every item equally likely,
+* 1 is the classic Zipf curve, and larger values concentrate sales further
+* on the top few items. The same options and seed always give the same log. */
+
+//everything that shapes a generated log
+struct SalesLogOptions {
+	uint64_t line_count = 1000000; //lines (sales) in the log
+	uint32_t item_count = 1000; //distinct item names to draw from
+	double skew = 1.0; //Zipf exponent, 0 for uniform
+	uint64_t seed = 20210423; //random seed, for repeatable logs
+};
+
+class SalesLogGenerator {
+public:
+	/*Builds the item names and the sampling table for options. Takes time
+	* and memory in proportion to item_count, not line_count. */
+	explicit SalesLogGenerator(const SalesLogOptions& options);
+
+	/*Name of the item of the given rank, 0 being the most likely. The first
+	* twenty are the produce names of the sample input file; after that a
+	* number is added ("Apples-21") to keep every name distinct.*/
+	const std::string& ItemName(uint32_t rank) const { return names_[rank]; }
+
+	//rank of the next item sold, drawn from the Zipf distribution
+	uint32_t NextItem();
+
+	//appends line_count more lines of the log to out
+	void AppendLines(uint64_t line_count, std::string& out);
+
+	/*Writes options.line_count lines to file_name, a megabyte at a time, so
+	* logs far bigger than memory can be made. Throws std::runtime_error if
+	* the file can't be created or written.*/
+	void WriteLog(const std::string& file_name);
+
+	//the options the generator was built with
+	const SalesLogOptions& options() const { return options_; }
+
+private:
+	SalesLogOptions options_; //size, cardinality, skew and seed
+	std::vector<std::string> names_; //item name of each rank
+	/*Walker's alias table: rank r is picked by choosing a column r
+	* uniformly, then keeping r with probability keep_[r] and taking
+	* alias_[r] otherwise. One random number and no search per line, however
+	* many items there are. */
+	std::vector<double> keep_;
+	std::vector<uint32_t> alias_;
+	std::mt19937_64 random_; //source of every random choice
+};
+#endif
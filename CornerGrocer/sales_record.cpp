@@ -0,0 +1,73 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Sales Record definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "sales_record.h"
+#include "line_scanner.h"
+#include <charconv>
+#include <cmath>
+
+namespace {
+/*most units one line may sell or return, and most one unit may cost, so
+* a line's revenue in cents is under 10^17 and totals can't overflow*/
+const int64_t kMaximumQuantity = 1000000000;
+const double kMaximumPrice = 1e6;
+
+/*Parses text as a price with std::from_chars, fixed notation only, and
+* converts it to whole cents. Returns false unless every character of text
+* is part of a price between 0 and kMaximumPrice.*/
+bool ParsePriceCents(std::string_view text, int64_t& cents) {
+	const char* end = text.data() + text.size();
+	double price = 0;
+	std::from_chars_result result = std::from_chars(
+		text.data(), end, price, std::chars_format::fixed);
+	if (result.ec != std::errc() || result.ptr != end || text[0] == '-' ||
+		!(price >= 0 && price <= kMaximumPrice)) { //false for NaN too
+		return false;
+	}
+	cents = std::llround(price * 100);
+	return true;
+}
+}  // namespace
+
+/*most lines are a bare name, so anything not ending in a digit is done
+* with straight away. Otherwise the last field, then the one before it, are
+* split off and tried as price and quantity, then as quantity alone.*/
+void ParseSalesRecord(std::string_view line, SalesRecord& record) {
+	record = SalesRecord();
+	record.item_name = line;
+	if (line.empty() || line.back() < '0' || line.back() > '9') { return; }
+
+	std::string_view head; //everything before the last field
+	std::string_view last; //the last field
+	if (!SplitLastField(line, head, last) || head.empty()) { return; }
+	std::string_view name; //everything before the field before last
+	std::string_view middle; //the field before last
+	int64_t quantity = 0;
+	int64_t cents = 0;
+	auto quantity_fits = [&quantity]() {
+		return quantity >= -kMaximumQuantity && quantity <= kMaximumQuantity;
+	};
+	if (SplitLastField(head, name, middle) && !name.empty() &&
+		ParseInteger(middle, quantity) && quantity_fits() &&
+		ParsePriceCents(last, cents)) {
+		record.item_name = name;
+		record.quantity = quantity;
+		record.priced = true;
+		record.unit_cents = cents;
+	}
+	else if (ParseInteger(last, quantity) && quantity_fits()) {
+		record.item_name = head;
+		record.quantity = quantity;
+	}
+}
@@ -0,0 +1,62 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Sales Record header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef SALES_RECORD_H
+#define SALES_RECORD_H
+#include <cstdint>
+#include <string_view>
+
+/* This file reads what one sales log line says was sold. A line is either
+* an item name, sold once, as it always has been:
+*
+*   Apples
+*
+* or, for registers that batch their sales, an item name followed by the
+* quantity sold and, optionally, the price of one unit:
+*
+*   Apples 12
+*   Apples 12 0.45
+*
+* Either kind can have a timestamp in front (see time_window.h), which is
+* split off first. The fields are separated by spaces or tabs and found from
+* the end of the line, so names with spaces in them still work. A quantity
+* is a whole number up to a billion, negative for returns, and a price a
+* decimal number from 0 to a million, without an exponent. A line whose
+* last words aren't shaped like that is an item name, whole, as before.
+*
+* Prices are kept in cents, rounded to the nearest, so revenue added up from
+* any number of lines, on any number of threads, is exact. Everything is
+* parsed with std::from_chars on views of the line, so a record costs no
+* allocation, and a line not ending in a digit, the usual case, costs one
+* comparison more than it used to. */
+
+//what one line says was sold
+struct SalesRecord {
+	std::string_view item_name; //view into the line, empty for a blank one
+	int64_t quantity = 1; //units sold, 1 unless the line says otherwise
+	bool priced = false; //true if the line gave a unit price
+	int64_t unit_cents = 0; //the price of one unit, if priced
+};
+
+/*Fills in record from line, which should already be trimmed and have any
+* timestamp split off. Never fails: a line that isn't a record with a
+* quantity is an item name sold once.*/
+void ParseSalesRecord(std::string_view line, SalesRecord& record);
+
+/*revenue of record in cents, quantity times unit price, or 0 if it has no
+* price*/
+inline int64_t RecordRevenue(const SalesRecord& record) {
+	return record.priced ? record.quantity * record.unit_cents : 0;
+}
+#endif
@@ -0,0 +1,334 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Sketch Engine definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "sketch_engine.h"
+#include "compressed_input.h"
+#include "item_dictionary.h"
+#include "line_scanner.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "sales_record.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+//smallest piece of a buffer worth a thread, as for FrequencyEngine
+const std::size_t kMinimumChunkBytes = 1 << 20;
+
+/*FNV-1a's low bits are poor for names that differ only at the end, and
+* HyperLogLog needs every bit to look random, so the name hash is put
+* through splitmix64's finalizer first*/
+uint64_t MixHash(uint64_t hash) {
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+//smallest power of two no smaller than value
+uint32_t RoundUpToPowerOfTwo(uint32_t value) {
+	uint32_t power = 1;
+	while (power < value && power < (1u << 31)) { power <<= 1; }
+	return power;
+}
+}  // namespace
+
+SketchEngine::SketchEngine(const SketchOptions& options) : options_(options) {
+	options_.width = RoundUpToPowerOfTwo(std::max<uint32_t>(options_.width, 1));
+	options_.depth = std::max<uint32_t>(options_.depth, 1);
+	options_.top = std::max<uint32_t>(options_.top, 1);
+	options_.precision = std::min<uint32_t>(
+		std::max<uint32_t>(options_.precision, 4), 18);
+	counters_.assign(static_cast<std::size_t>(options_.width) *
+		             options_.depth, 0);
+	registers_.assign(std::size_t(1) << options_.precision, 0);
+	candidates_.reserve(options_.top);
+}
+
+//a compressed file is counted a buffer at a time, as FrequencyEngine does
+void SketchEngine::CountFile(const std::string& file_name) {
+	MappedFile input(file_name);
+	if (DetectCompression(input.data(), input.size()) !=
+		InputCompression::kNone) {
+		DecompressingReader reader(file_name);
+		for (std::string_view lines; reader.Next(lines);) {
+			CountBuffer(lines.data(), lines.size());
+		}
+		return;
+	}
+	CountBuffer(input.data(), input.size());
+}
+
+void SketchEngine::set_thread_count(unsigned thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::thread::hardware_concurrency();
+	}
+	thread_count_ = thread_count > 0 ? thread_count : 1;
+}
+
+/*chunks are split and merged in order just like FrequencyEngine's; every
+* structure here merges by adding or taking the larger value, so chunked
+* counts match counting serially, except which items near the bottom of
+* the heavy hitters were kept.*/
+void SketchEngine::CountBuffer(const char* data, std::size_t size) {
+	CORNER_GROCER_TIME_STAGE(kIngest);
+	CORNER_GROCER_COUNT(kBytesRead, size);
+	std::size_t chunk_count = thread_count_;
+	if (size / kMinimumChunkBytes < chunk_count) { //too little work to share
+		chunk_count = size / kMinimumChunkBytes;
+	}
+	if (chunk_count <= 1) {
+		CountRange(data, data + size);
+	}
+	else {
+		std::vector<const char*> bounds = SplitAtLines(data, size,
+			                                           chunk_count);
+		std::vector<SketchEngine> chunk_sketches; //one per chunk
+		chunk_sketches.reserve(chunk_count);
+		for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+			chunk_sketches.emplace_back(options_);
+		}
+		std::vector<std::thread> workers;
+		for (std::size_t chunk = 1; chunk < chunk_count; ++chunk) {
+			workers.emplace_back(&SketchEngine::CountRange,
+				                 &chunk_sketches[chunk], bounds[chunk],
+				                 bounds[chunk + 1]);
+		}
+		chunk_sketches[0].CountRange(bounds[0], bounds[1]);
+		for (std::thread& worker : workers) { worker.join(); }
+		for (const SketchEngine& chunk_sketch : chunk_sketches) {
+			Merge(chunk_sketch);
+		}
+	}
+	RebuildReport();
+}
+
+//the same line rules as FrequencyEngine::CountRange
+void SketchEngine::CountRange(const char* begin, const char* end) {
+	LineScanner lines(begin, end - begin);
+	for (std::string_view line; lines.Next(line);) {
+		std::string_view item_name = TrimWhitespace(line);
+		int64_t seconds = 0; //a timestamp isn't part of the name
+		SplitTimestamp(item_name, seconds, item_name);
+		SalesRecord record; //nor are a quantity and price
+		ParseSalesRecord(item_name, record);
+		if (!record.item_name.empty()) {
+			AddItem(record.item_name, record.quantity);
+		}
+	}
+}
+
+/*rows use double hashing, one 64 bit hash split into two halves, which is
+* as good as depth independent hashes for Count-Min's bounds*/
+std::size_t SketchEngine::CounterIndex(uint64_t hash, uint32_t row) const {
+	uint32_t low = static_cast<uint32_t>(hash);
+	uint32_t high = static_cast<uint32_t>(hash >> 32) | 1;
+	return static_cast<std::size_t>(row) * options_.width +
+		((low + row * high) & (options_.width - 1));
+}
+
+/*conservative update: only the counters at the item's current minimum are
+* raised, the rest already count more than it. Estimates stay upper bounds,
+* but collisions inflate them far less than adding to every row. That is
+* also why returns (a quantity below 1) are skipped: counters that were only
+* raised as far as they had to be can't be lowered again safely.*/
+void SketchEngine::AddItem(std::string_view item_name, int64_t quantity) {
+	if (quantity <= 0) { return; }
+	uint64_t hash = MixHash(ItemDictionary::Hash(item_name));
+	int64_t estimate = Estimate(hash) + quantity;
+	for (uint32_t row = 0; row < options_.depth; ++row) {
+		int64_t& counter = counters_[CounterIndex(hash, row)];
+		if (counter < estimate) { counter = estimate; }
+	}
+	total_units_ += quantity;
+
+	/*the top precision bits pick a register, which keeps the largest run
+	* of trailing zeros (plus one) seen in the rest of the hash*/
+	uint64_t rest = hash << options_.precision;
+	uint8_t rank = rest == 0 ? static_cast<uint8_t>(65 - options_.precision) :
+		static_cast<uint8_t>(LowestSetBit(rest >> options_.precision) + 1);
+	uint8_t& reg = registers_[hash >> (64 - options_.precision)];
+	if (reg < rank) { reg = rank; }
+
+	OfferCandidate(item_name, hash, estimate);
+}
+
+int64_t SketchEngine::Estimate(uint64_t hash) const {
+	int64_t smallest = INT64_MAX;
+	for (uint32_t row = 0; row < options_.depth; ++row) {
+		smallest = std::min(smallest, counters_[CounterIndex(hash, row)]);
+	}
+	return smallest;
+}
+
+/*most sales are of items already kept or of items too small to be kept,
+* and both cost one hash probe and no scan. Only replacing the weakest item
+* (or raising it) scans the heavy hitters for the next weakest.*/
+void SketchEngine::OfferCandidate(std::string_view item_name, uint64_t hash,
+	                              int64_t estimate) {
+	auto found = candidate_slots_.find(hash);
+	if (found != candidate_slots_.end()) {
+		Candidate& candidate = candidates_[found->second];
+		if (candidate.name != item_name) { return; } //a 64 bit collision
+		candidate.estimate = estimate;
+		if (found->second == min_candidate_) { FindMinCandidate(); }
+		return;
+	}
+	if (candidates_.size() < options_.top) { //still room
+		candidate_slots_[hash] = static_cast<uint32_t>(candidates_.size());
+		candidates_.push_back({std::string(item_name), hash, estimate});
+		FindMinCandidate();
+		return;
+	}
+	Candidate& weakest = candidates_[min_candidate_];
+	if (estimate <= weakest.estimate) { return; }
+	candidate_slots_.erase(weakest.hash);
+	candidate_slots_[hash] = static_cast<uint32_t>(min_candidate_);
+	weakest.name.assign(item_name.data(), item_name.size());
+	weakest.hash = hash;
+	weakest.estimate = estimate;
+	FindMinCandidate();
+}
+
+void SketchEngine::FindMinCandidate() {
+	min_candidate_ = 0;
+	for (std::size_t i = 1; i < candidates_.size(); ++i) {
+		if (candidates_[i].estimate < candidates_[min_candidate_].estimate) {
+			min_candidate_ = i;
+		}
+	}
+}
+
+/*counters add, registers keep the larger rank. Heavy hitters
+* from both are estimated again against the merged counters and the best
+* top kept, ties going to the smaller name so the result doesn't depend on
+* the order candidates were stored in.*/
+void SketchEngine::Merge(const SketchEngine& other) {
+	for (std::size_t i = 0; i < counters_.size(); ++i) {
+		counters_[i] += other.counters_[i];
+	}
+	for (std::size_t i = 0; i < registers_.size(); ++i) {
+		registers_[i] = std::max(registers_[i], other.registers_[i]);
+	}
+	total_units_ += other.total_units_;
+
+	std::vector<Candidate> merged = candidates_;
+	for (const Candidate& candidate : other.candidates_) {
+		auto found = candidate_slots_.find(candidate.hash);
+		if (found == candidate_slots_.end() ||
+			candidates_[found->second].name != candidate.name) {
+			merged.push_back(candidate);
+		}
+	}
+	for (Candidate& candidate : merged) {
+		candidate.estimate = Estimate(candidate.hash);
+	}
+	std::sort(merged.begin(), merged.end(),
+		      [](const Candidate& a, const Candidate& b) {
+		if (a.estimate != b.estimate) { return a.estimate > b.estimate; }
+		return a.name < b.name;
+	});
+	if (merged.size() > options_.top) { merged.resize(options_.top); }
+	candidates_.swap(merged);
+	candidate_slots_.clear();
+	for (std::size_t i = 0; i < candidates_.size(); ++i) {
+		candidate_slots_[candidates_[i].hash] = static_cast<uint32_t>(i);
+	}
+	FindMinCandidate();
+}
+
+//best sellers first, ties by name, like ranking.h
+void SketchEngine::RebuildReport() {
+	std::vector<const Candidate*> ranked;
+	for (const Candidate& candidate : candidates_) {
+		ranked.push_back(&candidate);
+	}
+	std::sort(ranked.begin(), ranked.end(),
+		      [](const Candidate* a, const Candidate* b) {
+		if (a->estimate != b->estimate) { return a->estimate > b->estimate; }
+		return a->name < b->name;
+	});
+	report_.Clear();
+	for (const Candidate* candidate : ranked) {
+		report_.Add(candidate->name, candidate->estimate);
+	}
+}
+
+//0 from Count-Min means no counter was ever raised, so it was never sold
+int64_t SketchEngine::ItemFrequency(std::string_view item_name) const {
+	int64_t estimate = Estimate(MixHash(ItemDictionary::Hash(item_name)));
+	return estimate != 0 ? estimate : -1;
+}
+
+void SketchEngine::ItemFrequencies(
+	const std::vector<std::string_view>& item_names,
+	std::vector<int64_t>& item_qtys) const {
+	item_qtys.resize(item_names.size());
+	for (std::size_t i = 0; i < item_names.size(); ++i) {
+		item_qtys[i] = ItemFrequency(item_names[i]);
+	}
+}
+
+/*the HyperLogLog estimate, switching to linear counting of the empty
+* registers while it is small, where that is more accurate*/
+int64_t SketchEngine::DistinctItems() const {
+	double registers = static_cast<double>(registers_.size());
+	double inverse_sum = 0;
+	std::size_t empty = 0;
+	for (uint8_t reg : registers_) {
+		inverse_sum += std::ldexp(1.0, -reg);
+		if (reg == 0) { ++empty; }
+	}
+	double alpha = 0.7213 / (1 + 1.079 / registers);
+	double estimate = alpha * registers * registers / inverse_sum;
+	if (estimate <= 2.5 * registers && empty != 0) {
+		estimate = registers * std::log(registers / empty);
+	}
+	return static_cast<int64_t>(std::llround(estimate));
+}
+
+//e / width of the units sold, with probability 1 - e^-depth
+SketchErrorBounds SketchEngine::ErrorBounds() const {
+	SketchErrorBounds bounds;
+	double epsilon = std::exp(1.0) / options_.width;
+	bounds.frequency_error = static_cast<int64_t>(std::ceil(epsilon *
+		                                                    total_units_));
+	bounds.confidence = 1 - std::exp(-static_cast<double>(options_.depth));
+	bounds.distinct_error = 1.04 / std::sqrt(
+		static_cast<double>(registers_.size()));
+	return bounds;
+}
+
+std::size_t SketchEngine::memory_bytes() const {
+	std::size_t bytes = counters_.size() * sizeof(int64_t) +
+		registers_.size() + candidates_.capacity() * sizeof(Candidate) +
+		candidate_slots_.size() * (sizeof(uint64_t) + sizeof(uint32_t));
+	for (const Candidate& candidate : candidates_) {
+		bytes += candidate.name.capacity();
+	}
+	return bytes;
+}
+
+void SketchEngine::Clear() {
+	std::fill(counters_.begin(), counters_.end(), 0);
+	std::fill(registers_.begin(), registers_.end(), 0);
+	candidates_.clear();
+	candidate_slots_.clear();
+	min_candidate_ = 0;
+	total_units_ = 0;
+	report_.Clear();
+}
@@ -0,0 +1,158 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Sketch Engine header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef SKETCH_ENGINE_H
+#define SKETCH_ENGINE_H
+#include "frequency_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/* This file counts approximately, in memory that is fixed up front instead
+* of growing with every distinct line, for logs with far too many distinct
+* names (free text, SKUs) to keep a count for each. Three structures share
+* one hash of each name:
+*
+*   Count-Min sketch  depth rows of width 64 bit counters, which can't
+*                     overflow before the units sold would. A sale adds to one
+*                     counter per row and an item's estimate is the smallest
+*                     of its counters, which is never less than the true
+*                     count and, with probability 1 - e^-depth, at most
+*                     e / width * units over it.
+*   heavy hitters     the top items by estimate, kept by name as they are
+*                     seen, so best sellers can still be listed and charted.
+*   HyperLogLog       2^precision one byte registers estimating the number
+*                     of distinct items to within about 1.04 / sqrt(2^
+*                     precision), relative standard error.
+*
+* Lookups answer with the estimate, and the report (listing, charts, exports
+* and rankings) is made from the heavy hitters, through a FrequencyEngine so
+* every report call that works on exact counts works here too.
+*
+* A line with a quantity (see sales_record.h) counts that many units, and
+* its price is ignored. Returns, negative quantities, aren't counted at all,
+* so an estimate is an upper bound on units sold rather than net of them. */
+
+//how big each structure is, which is all the memory counting will use
+struct SketchOptions {
+	uint32_t width = 1 << 16; //counters per row, rounded up to a power of two
+	uint32_t depth = 4; //rows, each hashed differently
+	uint32_t top = 100; //heavy hitters kept
+	uint32_t precision = 14; //HyperLogLog registers are 2^precision, 4 to 18
+};
+
+//how far off the estimates can be, worked out from the options and units
+struct SketchErrorBounds {
+	int64_t frequency_error = 0; //estimates are at most this much too high...
+	double confidence = 0; //...with at least this probability
+	double distinct_error = 0; //relative standard error of DistinctItems
+};
+
+class SketchEngine {
+public:
+	explicit SketchEngine(const SketchOptions& options = SketchOptions());
+
+	/*counts every line of file_name, adding to any counts already held,
+	* decompressing a gzip or zstd file as it goes. Throws
+	* std::runtime_error if the file can't be opened, mapped or
+	* decompressed.*/
+	void CountFile(const std::string& file_name);
+
+	/*counts every line of an in-memory buffer, the same lines as
+	* FrequencyEngine would (trimmed, blank lines skipped, timestamps split
+	* off). With more than one thread, each chunk gets a sketch of its own,
+	* so memory is the options' size once per thread while counting.*/
+	void CountBuffer(const char* data, std::size_t size);
+
+	//threads CountBuffer may use, 0 for one per hardware thread
+	void set_thread_count(unsigned thread_count);
+	unsigned thread_count() const { return thread_count_; }
+
+	/*estimated times item_name was sold, or -1 if it certainly wasn't,
+	* matching FrequencyEngine::ItemFrequency*/
+	int64_t ItemFrequency(std::string_view item_name) const;
+
+	//ItemFrequency for a batch of names, like FrequencyEngine's
+	void ItemFrequencies(const std::vector<std::string_view>& item_names,
+		                 std::vector<int64_t>& item_qtys) const;
+
+	//number of units sold, which is exact
+	int64_t TotalUnits() const { return total_units_; }
+
+	//estimated number of distinct items
+	int64_t DistinctItems() const;
+
+	/*the heavy hitters as exact counts would look, best sellers first with
+	* their estimates, for listing, charting and exporting*/
+	const FrequencyEngine& Report() const { return report_; }
+
+	SketchErrorBounds ErrorBounds() const;
+
+	//bytes used by the three structures
+	std::size_t memory_bytes() const;
+
+	const SketchOptions& options() const { return options_; }
+
+	//forgets every count, keeping the structures' sizes
+	void Clear();
+
+private:
+	//one heavy hitter: name, its mixed hash, and its latest estimate
+	struct Candidate {
+		std::string name;
+		uint64_t hash;
+		int64_t estimate;
+	};
+
+	//counts every line between begin and end
+	void CountRange(const char* begin, const char* end);
+
+	//counts quantity units of item_name sold, see the definition for returns
+	void AddItem(std::string_view item_name, int64_t quantity);
+
+	//smallest counter of the item with this mixed hash
+	int64_t Estimate(uint64_t hash) const;
+
+	/*keeps item_name among the heavy hitters if it is one already or its
+	* estimate beats the weakest one kept*/
+	void OfferCandidate(std::string_view item_name, uint64_t hash,
+		                int64_t estimate);
+
+	//points min_candidate_ at the weakest heavy hitter
+	void FindMinCandidate();
+
+	/*adds other's counts, registers and heavy hitters to these, as if its
+	* lines had been counted here after this engine's own*/
+	void Merge(const SketchEngine& other);
+
+	//remakes report_ from the heavy hitters
+	void RebuildReport();
+
+	//counter index of the hash in row
+	std::size_t CounterIndex(uint64_t hash, uint32_t row) const;
+
+	SketchOptions options_; //sizes, with width rounded up
+	std::vector<int64_t> counters_; //depth rows of width counters
+	std::vector<uint8_t> registers_; //HyperLogLog registers
+	std::vector<Candidate> candidates_; //heavy hitters, in no order
+	std::unordered_map<uint64_t, uint32_t> candidate_slots_; //hash -> index
+	std::size_t min_candidate_ = 0; //index of the weakest heavy hitter
+	int64_t total_units_ = 0; //every sale counted
+	FrequencyEngine report_; //heavy hitters, best first
+	unsigned thread_count_ = 1; //threads CountBuffer is allowed to use
+};
+#endif
@@ -0,0 +1,324 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Time Window definition file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#include "time_window.h"
+#include "line_scanner.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+//digits seconds since 1970 need to be taken for a timestamp, 2001 on
+const std::size_t kMinEpochDigits = 10;
+
+//value of the count digits starting at text, which must all be digits
+bool ReadDigits(std::string_view text, std::size_t at, std::size_t count,
+	            int64_t& value) {
+	value = 0;
+	for (std::size_t i = at; i < at + count; ++i) {
+		if (text[i] < '0' || text[i] > '9') { return false; }
+		value = value * 10 + (text[i] - '0');
+	}
+	return true;
+}
+
+/*days from 1970-01-01 to the given date in the proleptic Gregorian
+* calendar, counting eras of 400 years so no table of month lengths or
+* loop over years is needed*/
+int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day) {
+	year -= month <= 2;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	int64_t year_of_era = year - era * 400;
+	int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 +
+		day - 1;
+	int64_t day_of_era = year_of_era * 365 + year_of_era / 4 -
+		year_of_era / 100 + day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+//DaysFromCivil the other way round, from the same eras of 400 years
+void CivilFromDays(int64_t days, int64_t& year, int64_t& month,
+	               int64_t& day) {
+	days += 719468;
+	int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	int64_t day_of_era = days - era * 146097;
+	int64_t year_of_era = (day_of_era - day_of_era / 1460 +
+		day_of_era / 36524 - day_of_era / 146096) / 365;
+	int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 -
+		year_of_era / 100);
+	int64_t shifted_month = (5 * day_of_year + 2) / 153; //March is 0
+	day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+	month = shifted_month + (shifted_month < 10 ? 3 : -9);
+	year = year_of_era + era * 400 + (month <= 2);
+}
+
+//appends the raw bytes of an array to buffer
+template <typename T>
+void AppendArray(std::string& buffer, const T* values, std::size_t count) {
+	buffer.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+/*copies count values from data into values and moves data past them.
+* Returns false, copying nothing, if there aren't that many bytes left.*/
+template <typename T>
+bool ReadArray(const char*& data, const char* end, T* values,
+	           std::size_t count) {
+	if (static_cast<std::size_t>(end - data) / sizeof(T) < count) {
+		return false;
+	}
+	std::memcpy(values, data, count * sizeof(T));
+	data += count * sizeof(T);
+	return true;
+}
+
+/*"YYYY-MM-DDTHH:MM:SS", with or without a trailing Z, in UTC. Only the
+* shape and the ranges of each field are checked.*/
+bool ParseIsoTime(std::string_view text, int64_t& seconds) {
+	if (text.size() == 20 && text[19] == 'Z') { text.remove_suffix(1); }
+	if (text.size() != 19 || text[4] != '-' || text[7] != '-' ||
+		text[10] != 'T' || text[13] != ':' || text[16] != ':') {
+		return false;
+	}
+	int64_t year, month, day, hour, minute, second;
+	if (!ReadDigits(text, 0, 4, year) || !ReadDigits(text, 5, 2, month) ||
+		!ReadDigits(text, 8, 2, day) || !ReadDigits(text, 11, 2, hour) ||
+		!ReadDigits(text, 14, 2, minute) ||
+		!ReadDigits(text, 17, 2, second)) {
+		return false;
+	}
+	if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 ||
+		minute > 59 || second > 60) {
+		return false;
+	}
+	seconds = DaysFromCivil(year, month, day) * 86400 + hour * 3600 +
+		minute * 60 + second;
+	return true;
+}
+}  // namespace
+
+bool ParseIsoDate(std::string_view text, int64_t& day) {
+	int64_t year, month, day_of_month;
+	if (text.size() != 10 || text[4] != '-' || text[7] != '-' ||
+		!ReadDigits(text, 0, 4, year) || !ReadDigits(text, 5, 2, month) ||
+		!ReadDigits(text, 8, 2, day_of_month) || month < 1 || month > 12 ||
+		day_of_month < 1 || day_of_month > 31) {
+		return false;
+	}
+	day = DaysFromCivil(year, month, day_of_month);
+	return true;
+}
+
+std::string FormatIsoDate(int64_t day) {
+	int64_t year, month, day_of_month;
+	CivilFromDays(day, year, month, day_of_month);
+	char text[64]; //room for any year, though only 4 digits are expected
+	std::snprintf(text, sizeof(text), "%04lld-%02lld-%02lld",
+		          static_cast<long long>(year), static_cast<long long>(month),
+		          static_cast<long long>(day_of_month));
+	return text;
+}
+
+/*the first whitespace ends the timestamp. Names may start with digits
+* too, so only a first word no name would plausibly start with is taken
+* for one: an ISO time, or seconds since 1970 long enough to be a date
+* this century. A line that is only a timestamp has no name after it, so
+* it is left to be counted as the name it always was.*/
+bool SplitTimestamp(std::string_view line, int64_t& seconds,
+	                std::string_view& item_name) {
+	if (line.empty() || line[0] < '0' || line[0] > '9') { return false; }
+	std::size_t end = 0;
+	while (end < line.size() && !IsLineWhitespace(line[end])) { ++end; }
+	if (end == line.size()) { return false; } //nothing after it
+	std::string_view stamp = line.substr(0, end);
+	int64_t parsed = 0;
+	if (!(stamp.size() >= kMinEpochDigits && ParseInteger(stamp, parsed)) &&
+		!ParseIsoTime(stamp, parsed)) {
+		return false;
+	}
+	seconds = parsed;
+	item_name = TrimWhitespace(line.substr(end));
+	return true;
+}
+
+TimeWindowCounter::TimeWindowCounter(const TimeWindowOptions& options)
+	: options_(options) {
+	if (options_.bucket_seconds < 1) { options_.bucket_seconds = 1; }
+	if (options_.bucket_count < 1) { options_.bucket_count = 1; }
+	slot_buckets_.assign(options_.bucket_count, kNoBucket);
+}
+
+int64_t TimeWindowCounter::BucketOf(int64_t seconds) const {
+	int64_t bucket = seconds / options_.bucket_seconds;
+	if (seconds % options_.bucket_seconds < 0) { --bucket; } //round down
+	return bucket;
+}
+
+uint32_t TimeWindowCounter::SlotOf(int64_t bucket) const {
+	int64_t slot = bucket % options_.bucket_count;
+	return static_cast<uint32_t>(slot < 0 ? slot + options_.bucket_count :
+		                         slot);
+}
+
+/*each slot moved into is zeroed for every item, which is the only step that
+* touches every item. It happens at most once per bucket_seconds of log, and
+* a jump of more than the whole history only clears each slot once.*/
+void TimeWindowCounter::AdvanceTo(int64_t bucket) {
+	int64_t first = bucket - options_.bucket_count + 1;
+	if (newest_bucket_ != kNoBucket && newest_bucket_ + 1 > first) {
+		first = newest_bucket_ + 1;
+	}
+	uint32_t bucket_count = options_.bucket_count;
+	for (int64_t moved = first; moved <= bucket; ++moved) {
+		uint32_t slot = SlotOf(moved);
+		for (std::size_t at = slot; at < counts_.size(); at += bucket_count) {
+			counts_[at] = 0;
+		}
+		slot_buckets_[slot] = moved;
+	}
+	newest_bucket_ = bucket;
+}
+
+void TimeWindowCounter::Grow(uint32_t id) {
+	if (id < item_count_) { return; }
+	item_count_ = id + 1;
+	counts_.resize(static_cast<std::size_t>(item_count_) *
+		           options_.bucket_count, 0);
+}
+
+void TimeWindowCounter::Add(uint32_t id, int64_t seconds, int64_t amount) {
+	Grow(id);
+	int64_t bucket = BucketOf(seconds);
+	if (newest_bucket_ == kNoBucket || bucket > newest_bucket_) {
+		AdvanceTo(bucket);
+	}
+	if (bucket <= newest_bucket_ - options_.bucket_count) { //too old
+		dropped_units_ += amount;
+		return;
+	}
+	std::size_t at = static_cast<std::size_t>(id) * options_.bucket_count +
+		SlotOf(bucket);
+	counts_[at] += amount;
+}
+
+int64_t TimeWindowCounter::WindowCount(uint32_t id,
+	                                   int64_t window_seconds) const {
+	if (newest_bucket_ == kNoBucket) { return 0; }
+	return WindowCount(id, window_seconds, newest_time());
+}
+
+/*only buckets still in the ring are added up, so a window reaching back
+* past the history kept is simply cut short*/
+int64_t TimeWindowCounter::WindowCount(uint32_t id, int64_t window_seconds,
+	                                   int64_t until) const {
+	if (id >= item_count_ || newest_bucket_ == kNoBucket ||
+		window_seconds <= 0) {
+		return 0;
+	}
+	int64_t last = std::min(BucketOf(until), newest_bucket_);
+	int64_t buckets = (window_seconds + options_.bucket_seconds - 1) /
+		options_.bucket_seconds;
+	int64_t first = std::max(last - buckets + 1,
+		                     newest_bucket_ - options_.bucket_count + 1);
+	const int64_t* ring = counts_.data() +
+		static_cast<std::size_t>(id) * options_.bucket_count;
+	int64_t total = 0;
+	for (int64_t bucket = first; bucket <= last; ++bucket) {
+		total += ring[SlotOf(bucket)];
+	}
+	return total;
+}
+
+/*other's newest bucket may be ahead of ours, so the ring is moved up to it
+* first; after that, every bucket other still holds is either in our history
+* at the same slot (the bucket counts match) or too old for it.*/
+void TimeWindowCounter::Merge(const TimeWindowCounter& other,
+	                          const std::vector<uint32_t>& id_map) {
+	if (other.options_.bucket_seconds != options_.bucket_seconds ||
+		other.options_.bucket_count != options_.bucket_count) {
+		throw std::runtime_error("Time windows with different buckets can't "
+			                     "be merged");
+	}
+	dropped_units_ += other.dropped_units_;
+	if (other.newest_bucket_ == kNoBucket) { return; }
+	if (newest_bucket_ == kNoBucket || other.newest_bucket_ > newest_bucket_) {
+		AdvanceTo(other.newest_bucket_);
+	}
+	for (uint32_t id = 0; id < other.item_count_; ++id) { Grow(id_map[id]); }
+
+	uint32_t bucket_count = options_.bucket_count;
+	for (uint32_t slot = 0; slot < bucket_count; ++slot) {
+		int64_t bucket = other.slot_buckets_[slot];
+		if (bucket == kNoBucket) { continue; }
+		bool kept = bucket > newest_bucket_ - bucket_count;
+		for (uint32_t id = 0; id < other.item_count_; ++id) {
+			int64_t count = other.counts_[
+				static_cast<std::size_t>(id) * bucket_count + slot];
+			if (count == 0) { continue; }
+			if (!kept) { dropped_units_ += count; continue; }
+			counts_[static_cast<std::size_t>(id_map[id]) * bucket_count +
+				slot] += count;
+		}
+	}
+}
+
+void TimeWindowCounter::AppendState(std::string& out) const {
+	AppendArray(out, &options_.bucket_seconds, 1);
+	AppendArray(out, &options_.bucket_count, 1);
+	AppendArray(out, &item_count_, 1);
+	AppendArray(out, &newest_bucket_, 1);
+	AppendArray(out, &dropped_units_, 1);
+	AppendArray(out, slot_buckets_.data(), slot_buckets_.size());
+	AppendArray(out, counts_.data(), counts_.size());
+}
+
+//read into locals first, so a short state changes nothing
+bool TimeWindowCounter::ReadState(const char*& data, const char* end) {
+	const char* at = data;
+	TimeWindowOptions options;
+	uint32_t item_count = 0;
+	int64_t newest_bucket = kNoBucket;
+	int64_t dropped_units = 0;
+	if (!ReadArray(at, end, &options.bucket_seconds, 1) ||
+		!ReadArray(at, end, &options.bucket_count, 1) ||
+		options.bucket_seconds != options_.bucket_seconds ||
+		options.bucket_count != options_.bucket_count ||
+		!ReadArray(at, end, &item_count, 1) ||
+		!ReadArray(at, end, &newest_bucket, 1) ||
+		!ReadArray(at, end, &dropped_units, 1)) {
+		return false;
+	}
+	std::vector<int64_t> slot_buckets(options.bucket_count);
+	std::vector<int64_t> counts(static_cast<std::size_t>(item_count) *
+		                        options.bucket_count);
+	if (!ReadArray(at, end, slot_buckets.data(), slot_buckets.size()) ||
+		!ReadArray(at, end, counts.data(), counts.size())) {
+		return false;
+	}
+	slot_buckets_.swap(slot_buckets);
+	counts_.swap(counts);
+	item_count_ = item_count;
+	newest_bucket_ = newest_bucket;
+	dropped_units_ = dropped_units;
+	data = at;
+	return true;
+}
+
+void TimeWindowCounter::Clear() {
+	counts_.clear();
+	slot_buckets_.assign(options_.bucket_count, kNoBucket);
+	item_count_ = 0;
+	newest_bucket_ = kNoBucket;
+	dropped_units_ = 0;
+}
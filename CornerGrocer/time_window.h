@@ -0,0 +1,148 @@
+/**
+ * Author: Alice Norris
+ * Class: CS-210-T4249 Programming Languages 21EW4
+ * Professor: Eric Gregori, MSCS
+ * Time Window header file
+ *
+ * The code in this file attempts to follow the Google C++ Style Guide
+ *(https://google.github.io/styleguide/cppguide.html).
+ * Comments are used extensively, even when code is obvious, to present an
+ * understanding of the code, and for corrections or clarifications in
+ * execution and concept. In accordance with the Google C++ style guide, all
+ * lines have been wrapped as neatly as possible to 80 characters, and
+ * all naming conventions have been followed to the best of my ability
+*/
+#ifndef TIME_WINDOW_H
+#define TIME_WINDOW_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* This file answers "how many sold in the last 15 minutes" questions for
+* sales logs whose lines carry a timestamp:
+*
+*   2021-04-23T10:15:00 Apples     (ISO 8601, UTC, optionally ending in Z)
+*   1619172900 Apples              (seconds since 1970, UTC)
+*
+* Seconds since 1970 need at least 10 digits (September 2001 on), so a name
+* that starts with a short number, like "7 Up", stays a name. Lines without
+* a timestamp are still plain item names, and both kinds can be mixed in
+* one file; only timestamped lines go into the time buckets.
+*
+* Time is cut into buckets of bucket_seconds, and each item keeps a ring of
+* the latest bucket_count buckets, so the history kept is bucket_seconds *
+* bucket_count long and costs 8 bytes per bucket per item, however long the
+* log is. A window query adds up the buckets the window covers, so it takes
+* time proportional to the window, not to the history. Windows are rounded
+* out to whole buckets: "the last 15 minutes" with 1 minute buckets is the
+* current minute's bucket and the 14 before it. Sales older than the oldest
+* bucket kept are left out of windows (they are still in the totals). */
+
+//how much history is kept, and how finely it is cut
+struct TimeWindowOptions {
+	int64_t bucket_seconds = 60; //length of one bucket
+	uint32_t bucket_count = 60; //buckets kept per item, so one hour
+};
+
+/*If line (already trimmed) starts with a timestamp followed by whitespace
+* and a name, sets seconds to the timestamp, item_name to the trimmed name,
+* and returns true. Otherwise returns false and leaves both alone, and the
+* whole line is the item name as always. */
+bool SplitTimestamp(std::string_view line, int64_t& seconds,
+	                std::string_view& item_name);
+
+/*If text is a "YYYY-MM-DD" date, sets day to the days from 1970-01-01 to
+* it and returns true. Otherwise returns false and leaves day alone.*/
+bool ParseIsoDate(std::string_view text, int64_t& day);
+
+//the "YYYY-MM-DD" date day days after 1970-01-01
+std::string FormatIsoDate(int64_t day);
+
+/*Per item rings of time buckets. Items are the same dense IDs as the
+* FrequencyTable the sales were counted into; an item first seen after
+* others gets zeroed buckets when it arrives. The newest bucket is the one
+* holding the newest timestamp seen, so replaying yesterday's log answers
+* windows as of the end of that log, not as of now. */
+class TimeWindowCounter {
+public:
+	explicit TimeWindowCounter(const TimeWindowOptions& options =
+		                       TimeWindowOptions());
+
+	//adds amount to item id's bucket for the time given in seconds
+	void Add(uint32_t id, int64_t seconds, int64_t amount = 1);
+
+	/*units of item id sold in the window_seconds up to and including the
+	* newest bucket (or until, in the second form). 0 if the item or the
+	* time is unknown, and never more history than is kept.*/
+	int64_t WindowCount(uint32_t id, int64_t window_seconds) const;
+	int64_t WindowCount(uint32_t id, int64_t window_seconds,
+		                int64_t until) const;
+
+	/*adds other's buckets, with other's item i going to id_map[i]. Both
+	* counters must have the same options. Buckets too old for the merged
+	* history are dropped, as if their sales had been added here.*/
+	void Merge(const TimeWindowCounter& other,
+		       const std::vector<uint32_t>& id_map);
+
+	//forgets every bucket, keeping allocated memory for reuse
+	void Clear();
+
+	/*appends the options, every bucket and the newest bucket to out, so
+	* the counter can be carried on with after a restart (see checkpoint.h)*/
+	void AppendState(std::string& out) const;
+
+	/*replaces every bucket with a state appended by AppendState, read from
+	* data, and moves data past it. Returns false and leaves the buckets
+	* alone if the state is cut short before end or was saved with other
+	* options.*/
+	bool ReadState(const char*& data, const char* end);
+
+	//true once a timestamped sale has been added
+	bool has_times() const { return newest_bucket_ != kNoBucket; }
+
+	//start of the newest bucket, in seconds since 1970, if has_times
+	int64_t newest_time() const {
+		return newest_bucket_ * options_.bucket_seconds;
+	}
+
+	//units too old to fit in the history kept when they arrived
+	int64_t dropped_units() const { return dropped_units_; }
+
+	//bytes held by the buckets
+	std::size_t memory_bytes() const {
+		return counts_.capacity() * sizeof(int64_t) +
+			slot_buckets_.capacity() * sizeof(int64_t);
+	}
+
+	const TimeWindowOptions& options() const { return options_; }
+
+private:
+	//marks a slot that has never held a bucket, and an empty counter
+	static constexpr int64_t kNoBucket = INT64_MIN;
+
+	//bucket number holding seconds, rounding down before 1970 too
+	int64_t BucketOf(int64_t seconds) const;
+
+	//slot in every item's ring that holds bucket
+	uint32_t SlotOf(int64_t bucket) const;
+
+	/*makes bucket the newest, emptying and relabelling every slot the
+	* buckets after the old newest one move into*/
+	void AdvanceTo(int64_t bucket);
+
+	//gives every item up to id its ring, zeroed
+	void Grow(uint32_t id);
+
+	TimeWindowOptions options_; //bucket length and count
+	/*item major, id * bucket_count + slot. Signed and 64 bit like the
+	* FrequencyTable's counts, since returns are negative quantities and a
+	* single line can sell up to a billion units.*/
+	std::vector<int64_t> counts_;
+	std::vector<int64_t> slot_buckets_; //bucket each slot holds now
+	uint32_t item_count_ = 0; //items with a ring in counts_
+	int64_t newest_bucket_ = kNoBucket; //bucket of the newest sale
+	int64_t dropped_units_ = 0; //sales too old for any bucket
+};
+#endif